@@ -0,0 +1,156 @@
+#pragma once
+
+// Small helpers shared by the programs in bench/.
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Records.hpp"
+#include "core/Timestamp.hpp"
+
+namespace bench {
+
+class Stopwatch {
+ public:
+  Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+  double ms() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Peak resident set size of this process, in KiB. On Linux this reads
+// VmHWM, which starts over at exec; ru_maxrss would carry over the peak of
+// the process we were forked from.
+inline long maxRssKb() {
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) return std::stol(line.substr(6));
+  }
+#endif
+  struct rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+  return ru.ru_maxrss / 1024;  // bytes on macOS
+#else
+  return ru.ru_maxrss;
+#endif
+}
+
+// Current resident set size in KiB (Linux); falls back to the peak elsewhere.
+inline long currentRssKb() {
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  long pages = 0, resident = 0;
+  if (statm >> pages >> resident) return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+  return maxRssKb();
+}
+
+// Path of the running benchmark, for re-exec'ing it.
+inline std::string selfPath(const char* argv0) {
+#ifdef __linux__
+  std::error_code ec;
+  auto p = std::filesystem::read_symlink("/proc/self/exe", ec);
+  if (!ec) return p.string();
+#endif
+  return argv0;
+}
+
+// Run `self args...` in a fresh process so peak RSS is measured in
+// isolation; returns its exit status.
+inline int runSelf(const std::string& self, const std::vector<std::string>& args) {
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(self.c_str()));
+    for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+    execv(self.c_str(), argv.data());
+    _exit(127);
+  }
+  int st = 0;
+  waitpid(pid, &st, 0);
+  return WIFEXITED(st) ? WEXITSTATUS(st) : 1;
+}
+
+inline std::string isoDate(int dayOffset, int minuteOfDay) {
+  // 2024-01-01 + dayOffset days; good enough for synthetic data.
+  static const int kDays[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  int year = 2024, month = 0, day = dayOffset;
+  while (day >= kDays[month]) {
+    day -= kDays[month];
+    if (++month == 12) {
+      month = 0;
+      ++year;
+    }
+  }
+  minuteOfDay = ((minuteOfDay % 1440) + 1440) % 1440;
+  // Five ints of up to 11 characters each plus the separators: never truncates.
+  char buf[80];
+  const int n = std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:00.000Z", year, month + 1, day + 1,
+                              minuteOfDay / 60, minuteOfDay % 60);
+  return std::string(buf, n > 0 ? static_cast<std::size_t>(n) : 0);
+}
+
+// Deterministic dataset: `users` users with `perCollection` records in each
+// of waters / sleeps / activities and one "Mood" category.
+inline UserMap makeSyntheticUsers(std::size_t users, std::size_t perCollection, unsigned seed = 42) {
+  static const char* kIntensities[] = {"low", "moderate", "vigorous"};
+  static const char* kNotes[] = {"Good day", "Tired", "Morning meditation", "Headache", "Great run"};
+  std::mt19937 rng(seed);
+  UserMap out;
+  for (std::size_t u = 0; u < users; ++u) {
+    UserData d;
+    d.profile.name = "user" + std::to_string(u);
+    d.profile.id = d.profile.name;
+    d.profile.age = 18 + static_cast<int>(rng() % 60);
+    d.profile.weightKg = 50.0 + rng() % 50;
+    d.profile.heightM = 1.5 + (rng() % 50) / 100.0;
+    d.profile.gender = (u % 2) ? "female" : "male";
+    d.password = "pw" + std::to_string(rng());
+    auto& mood = d.categories["Mood"];
+    for (std::size_t i = 0; i < perCollection; ++i) {
+      const int day = static_cast<int>(i / 4);
+      const int minute = static_cast<int>(rng() % 1440);
+      const std::string when = isoDate(day, minute);
+      WaterRecord w;
+      setDatetime(w, when);
+      w.amountMl = 100.0 + rng() % 900;
+      d.waters.push_back(std::move(w));
+      SleepRecord s;
+      setDatetime(s, when);
+      s.hours = 4.0 + (rng() % 80) / 10.0;
+      d.sleeps.push_back(std::move(s));
+      ActivityRecord a;
+      setDatetime(a, when);
+      a.minutes = 10 + static_cast<int>(rng() % 120);
+      a.intensity = kIntensities[rng() % 3];
+      d.activities.push_back(std::move(a));
+      CategoryItem item;
+      setDatetime(item, when);
+      item.note = kNotes[rng() % 5];
+      item.value = static_cast<double>(rng() % 5);
+      mood.push_back(std::move(item));
+    }
+    assignRecordIds(d);
+    out.emplace(d.profile.name, std::move(d));
+  }
+  return out;
+}
+
+}  // namespace bench
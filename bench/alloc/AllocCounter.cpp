@@ -0,0 +1,78 @@
+#include "AllocCounter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> gAllocs{0}, gBytes{0};
+thread_local bool t_uncounted = false;
+
+void count(std::size_t n) {
+  if (t_uncounted) return;
+  gAllocs.fetch_add(1, std::memory_order_relaxed);
+  gBytes.fetch_add(n, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t n) {
+  count(n);
+  return std::malloc(n ? n : 1);
+}
+
+void* allocateAligned(std::size_t n, std::align_val_t align) {
+  count(n);
+  const std::size_t a = std::max(sizeof(void*), static_cast<std::size_t>(align));
+  return std::aligned_alloc(a, (std::max<std::size_t>(n, 1) + a - 1) / a * a);
+}
+
+}  // namespace
+
+namespace bench::alloc {
+
+std::size_t allocations() { return gAllocs.load(); }
+std::size_t bytes() { return gBytes.load(); }
+void setUncounted(bool uncounted) { t_uncounted = uncounted; }
+
+}  // namespace bench::alloc
+
+void* operator new(std::size_t n) {
+  if (void* p = allocate(n)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+  if (void* p = allocate(n)) return p;
+  throw std::bad_alloc();
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return allocate(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return allocate(n); }
+
+// std::pmr::new_delete_resource() allocates through the aligned forms.
+void* operator new(std::size_t n, std::align_val_t align) {
+  if (void* p = allocateAligned(n, align)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n, std::align_val_t align) {
+  if (void* p = allocateAligned(n, align)) return p;
+  throw std::bad_alloc();
+}
+void* operator new(std::size_t n, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return allocateAligned(n, align);
+}
+void* operator new[](std::size_t n, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return allocateAligned(n, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
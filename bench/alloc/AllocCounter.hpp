@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+// Replaced global operator new / delete that count heap allocations, for the
+// benchmarks that report allocations per operation. Link
+// bench/alloc/AllocCounter.cpp into the benchmark (see CMakeLists.txt).
+//
+// The replacements live in their own translation unit: defined next to the
+// code they measure, GCC inlines the malloc/free bodies into every
+// new/delete site and reports them as mismatched allocation pairs.
+namespace bench::alloc {
+
+std::size_t allocations();  // every operator new / new[] so far
+std::size_t bytes();        // bytes requested by those allocations
+
+// Allocations made by the calling thread are not counted while this is set.
+void setUncounted(bool uncounted);
+
+}  // namespace bench::alloc
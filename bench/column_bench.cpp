@@ -0,0 +1,112 @@
+// Row vs columnar layout of the published record lists.
+//
+//   column_bench [users=1000] [recordsPerCollection=1000] [reps=20]
+//
+// "rows" is what a published list used to be: a std::vector<WaterRecord>,
+// one struct per record (its datetime packed since footprint_bench). "columns"
+// is RecordList (RecordColumns.hpp): one array per field plus a text arena.
+// For each layout, in a fresh process (re-exec of this binary):
+//   - build: copying every user's waters into the layout (what a publish does)
+//   - sum:   total amountMl over all records
+//   - range: total amountMl over the last 7 days of the dataset
+//   - bytes per record: RSS growth while the lists are held, over the records
+// Only waters are measured; the other collections follow the same pattern.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/UserVersion.hpp"
+
+constexpr std::int64_t kWeekMs = 7LL * 24 * 3600 * 1000;
+
+static int runLayout(const std::string& layout, std::size_t users, std::size_t perCollection, int reps) {
+  const UserMap data = bench::makeSyntheticUsers(users, perCollection);
+  std::size_t records = 0;
+  std::int64_t latest = kNoTime;
+  for (const auto& [_, u] : data) {
+    records += u.waters.size();
+    for (const WaterRecord& w : u.waters) latest = std::max(latest, w.timeMs);
+  }
+  const std::int64_t from = latest - kWeekMs;
+
+  const long rssBefore = bench::currentRssKb();
+  double buildMs = 0, sumMs = 0, rangeMs = 0, total = 0;
+  long rssHeld = 0;
+
+  if (layout == "rows") {
+    std::vector<std::vector<WaterRecord>> lists;
+    lists.reserve(data.size());
+    bench::Stopwatch build;
+    for (const auto& [_, u] : data) lists.emplace_back(u.waters.begin(), u.waters.end());
+    buildMs = build.ms();
+    rssHeld = bench::currentRssKb() - rssBefore;
+
+    bench::Stopwatch sum;
+    for (int r = 0; r < reps; ++r) {
+      for (const auto& list : lists) {
+        for (const WaterRecord& w : list) total += w.amountMl;
+      }
+    }
+    sumMs = sum.ms() / reps;
+
+    bench::Stopwatch range;
+    for (int r = 0; r < reps; ++r) {
+      for (const auto& list : lists) {
+        for (const WaterRecord& w : list) {
+          if (w.timeMs >= from) total += w.amountMl;  // a scan: nothing to search in
+        }
+      }
+    }
+    rangeMs = range.ms() / reps;
+  } else {
+    std::vector<RecordList<WaterRecord>> lists;
+    lists.reserve(data.size());
+    bench::Stopwatch build;
+    for (const auto& [_, u] : data) lists.emplace_back(u.waters);
+    buildMs = build.ms();
+    rssHeld = bench::currentRssKb() - rssBefore;
+
+    bench::Stopwatch sum;
+    for (int r = 0; r < reps; ++r) {
+      for (const auto& list : lists) {
+        for (double ml : list.columns().amountMl) total += ml;
+      }
+    }
+    sumMs = sum.ms() / reps;
+
+    bench::Stopwatch range;
+    for (int r = 0; r < reps; ++r) {
+      for (const auto& list : lists) {
+        for (const WaterView& w : list.between(from, latest + 1)) total += w.amountMl;
+      }
+    }
+    rangeMs = range.ms() / reps;
+  }
+
+  std::printf("%-8s build %8.1f ms   sum %7.2f ms (%6.0f M rec/s)   last 7 days %7.2f ms   %6.1f bytes/record"
+              "   (checksum %.0f)\n",
+              layout.c_str(), buildMs, sumMs, records / sumMs / 1000.0, rangeMs,
+              rssHeld * 1024.0 / static_cast<double>(records), total);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc == 6 && std::string(argv[1]) == "--layout") {
+    return runLayout(argv[2], std::stoul(argv[3]), std::stoul(argv[4]), std::stoi(argv[5]));
+  }
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 1000;
+  const std::size_t perCollection = argc > 2 ? std::stoul(argv[2]) : 1000;
+  const int reps = argc > 3 ? std::max(1, std::stoi(argv[3])) : 20;
+
+  std::printf("%zu users x %zu water records, %d reps\n", users, perCollection, reps);
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = 0;
+  for (const char* layout : {"rows", "columns"}) {
+    rc |= bench::runSelf(self, {"--layout", layout, std::to_string(users), std::to_string(perCollection),
+                                std::to_string(reps)});
+  }
+  return rc;
+}
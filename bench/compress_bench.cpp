@@ -0,0 +1,81 @@
+// Compressed snapshots: size and encode / decode throughput per codec level.
+//
+//   compress_bench [users=5000] [recordsPerCollection=50] [dir=/tmp/health_compress_bench]
+//
+// Rows: the indented JSON the server writes by default, the same document
+// compact, and compact JSON through the streaming codec at zlib levels 1, 6
+// (the default) and 9. Throughput is in MiB of uncompressed JSON per second;
+// decode is the full SAX load into a UserMap, like at startup.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "BenchUtil.hpp"
+#include "core/SnapshotCodec.hpp"
+#include "core/SnapshotJson.hpp"
+
+struct Result {
+  std::uintmax_t bytes = 0;
+  double encodeMs = 0, decodeMs = 0;
+  std::size_t users = 0;
+};
+
+// level < 0: plain file with that indent (-1 compact); otherwise codec level.
+static Result run(const std::string& path, const UserMap& data, int indent, int level) {
+  Result r;
+  bench::Stopwatch enc;
+  if (level > 0) {
+    codec::CompressedOStream out(path, level);
+    writeJsonSnapshot(out, data, 1, indent);
+    out.close();
+  } else {
+    std::ofstream out(path, std::ios::trunc | std::ios::binary);
+    writeJsonSnapshot(out, data, 1, indent);
+  }
+  r.encodeMs = enc.ms();
+  r.bytes = std::filesystem::file_size(path);
+
+  UserMap loaded;
+  std::uint64_t seq = 0;
+  bench::Stopwatch dec;
+  if (level > 0) {
+    codec::CompressedIStream in(path);
+    readJsonSnapshot(in, loaded, seq);
+  } else {
+    readJsonSnapshot(path, loaded, seq);
+  }
+  r.decodeMs = dec.ms();
+  r.users = loaded.size();
+  return r;
+}
+
+int main(int argc, char** argv) {
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 5000;
+  const std::size_t perCollection = argc > 2 ? std::stoul(argv[2]) : 50;
+  const std::string dir = argc > 3 ? argv[3] : "/tmp/health_compress_bench";
+  std::filesystem::create_directories(dir);
+
+  const UserMap data = bench::makeSyntheticUsers(users, perCollection);
+  std::printf("dataset: %zu users x %zu records per collection, codec %s\n", users, perCollection, codec::name());
+
+  const Result pretty = run(dir + "/pretty.json", data, 2, 0);
+  const Result compact = run(dir + "/compact.json", data, -1, 0);
+  const double mib = 1024.0 * 1024.0;
+
+  auto print = [&](const char* label, const Result& r, double inputBytes) {
+    std::printf("%-16s %8.1f MiB  ratio %5.2fx  encode %7.1f ms %7.1f MiB/s  decode %7.1f ms %7.1f MiB/s%s\n", label,
+                r.bytes / mib, pretty.bytes / static_cast<double>(r.bytes), r.encodeMs,
+                inputBytes / mib / (r.encodeMs / 1000.0), r.decodeMs, inputBytes / mib / (r.decodeMs / 1000.0),
+                r.users == users ? "" : "   (LOAD FAILED)");
+  };
+  print("json (indent 2)", pretty, pretty.bytes);
+  print("json compact", compact, compact.bytes);
+  for (int level : {1, 6, 9}) {
+    const std::string label = "json.gz level " + std::to_string(level);
+    print(label.c_str(), run(dir + "/level" + std::to_string(level) + ".json.gz", data, -1, level), compact.bytes);
+  }
+  std::filesystem::remove_all(dir);
+  return 0;
+}
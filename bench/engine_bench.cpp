@@ -0,0 +1,142 @@
+// The same request mix against every StorageEngine.
+//
+//   engine_bench [users=1000] [ops=100000] [threads=4] [dir=/tmp/health_engine_bench] [engine...]
+//
+// Each engine gets `users` users with a few records each, then `threads`
+// threads run `ops` operations in total: 70% reads of a whole user (the list
+// endpoints), 20% record adds, 5% updates and 5% deletes, on random users.
+// Reported per engine: throughput, read / write latency percentiles, the
+// time of a checkpoint and of a reopen (startup), and the size on disk.
+// STORAGE_DURABILITY applies as in the server (default async).
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/SnapshotJson.hpp"
+#include "core/StorageEngine.hpp"
+
+using nlohmann::json;
+
+static double percentile(std::vector<double>& v, double p) {
+  if (v.empty()) return 0.0;
+  const std::size_t k = std::min(v.size() - 1, static_cast<std::size_t>(p * (v.size() - 1)));
+  std::nth_element(v.begin(), v.begin() + static_cast<long>(k), v.end());
+  return v[k];
+}
+
+static std::uintmax_t diskBytes(const std::string& dir) {
+  std::uintmax_t n = 0;
+  std::error_code ec;
+  for (const auto& f : std::filesystem::recursive_directory_iterator(dir, ec)) {
+    if (f.is_regular_file(ec)) n += f.file_size(ec);
+  }
+  return n;
+}
+
+static void run(const std::string& name, const std::string& dir, std::size_t users, std::size_t ops,
+                std::size_t threads) {
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  auto engine = makeStorageEngine(name, dir);
+  if (!engine || !engine->open()) {
+    std::printf("%-15s cannot open\n", name.c_str());
+    return;
+  }
+
+  // Seed: users with 8 records per collection, then fold them into a snapshot.
+  const UserMap seed = bench::makeSyntheticUsers(users, 8);
+  for (const auto& [user, u] : seed) {
+    engine->createUser(u);
+    for (const auto& w : u.waters) engine->putRecord(user, {"waters"}, toJson(w));
+    for (const auto& s : u.sleeps) engine->putRecord(user, {"sleeps"}, toJson(s));
+    for (const auto& a : u.activities) engine->putRecord(user, {"activities"}, toJson(a));
+  }
+  engine->checkpoint();
+
+  std::vector<std::vector<double>> readLat(threads), writeLat(threads);
+  std::atomic<std::size_t> failed{0};
+  bench::Stopwatch total;
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t] {
+      std::mt19937 rng(static_cast<unsigned>(t + 1));
+      const std::size_t mine = ops / threads + (t < ops % threads ? 1 : 0);
+      for (std::size_t i = 0; i < mine; ++i) {
+        const std::string user = "user" + std::to_string(rng() % users);
+        const unsigned roll = rng() % 100;
+        bench::Stopwatch sw;
+        bool ok = true;
+        if (roll < 70) {
+          UserData u;
+          ok = engine->loadUser(user, u);
+          readLat[t].push_back(sw.ms());
+          continue;
+        }
+        if (roll < 90) {
+          ok = engine->putRecord(user, {"waters"}, toJson(WaterRecord{bench::isoDate(40, rng() % 1440), 250.0}));
+        } else if (roll < 95) {
+          const std::uint64_t firstSleep = seed.at(user).sleeps.begin()->id;
+          ok = engine->putRecord(user, {"sleeps", firstSleep}, toJson(SleepRecord{bench::isoDate(41, 0), 8.0}));
+        } else {
+          // Delete the oldest water record (the seed leaves plenty); like a
+          // client, list first to learn its id. Two threads can pick the
+          // same record, and the loser's delete then counts as failed.
+          UserData u;
+          ok = engine->loadUser(user, u) && !u.waters.empty() &&
+               engine->deleteRecord(user, {"waters", u.waters.begin()->id});
+        }
+        if (!ok) ++failed;
+        writeLat[t].push_back(sw.ms());
+      }
+    });
+  }
+  for (auto& th : pool) th.join();
+  const double elapsed = total.ms();
+
+  std::vector<double> reads, writes;
+  for (std::size_t t = 0; t < threads; ++t) {
+    reads.insert(reads.end(), readLat[t].begin(), readLat[t].end());
+    writes.insert(writes.end(), writeLat[t].begin(), writeLat[t].end());
+  }
+
+  bench::Stopwatch cp;
+  engine->checkpoint();
+  const double checkpointMs = cp.ms();
+  engine.reset();
+
+  bench::Stopwatch op;
+  auto reopened = makeStorageEngine(name, dir);
+  reopened->open();
+  const double openMs = op.ms();
+
+  std::printf("%-15s %9.0f ops/s  read p50 %6.1f us p99 %7.1f us  write p50 %6.1f us p99 %7.1f us  "
+              "checkpoint %7.1f ms  open %7.1f ms  disk %6.1f MB%s\n",
+              name.c_str(), ops / (elapsed / 1000.0), percentile(reads, 0.50) * 1000, percentile(reads, 0.99) * 1000,
+              percentile(writes, 0.50) * 1000, percentile(writes, 0.99) * 1000, checkpointMs, openMs,
+              diskBytes(dir) / 1048576.0, failed > 0 ? "  (some ops failed)" : "");
+}
+
+int main(int argc, char** argv) {
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 1000;
+  const std::size_t ops = argc > 2 ? std::stoul(argv[2]) : 100000;
+  const std::size_t threads = std::max<std::size_t>(1, argc > 3 ? std::stoul(argv[3]) : 4);
+  const std::string dir = argc > 4 ? argv[4] : "/tmp/health_engine_bench";
+  std::vector<std::string> engines(argv + std::min(argc, 5), argv + argc);
+  if (engines.empty()) engines = storageEngineNames();
+
+  const char* durability = std::getenv("STORAGE_DURABILITY");
+  std::printf("%zu users, %zu ops on %zu threads, durability %s\n", users, ops, threads,
+              durability ? durability : "async");
+  for (const std::string& name : engines) run(name, dir + "/" + name, users, ops, threads);
+  std::filesystem::remove_all(dir);
+  return 0;
+}
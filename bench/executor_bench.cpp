@@ -0,0 +1,98 @@
+// Write scaling: per-user stripe locks against shard-per-core execution.
+//
+//   executor_bench [users=256] [maxThreads=8] [seconds=1] [shards=hardware threads]
+//
+// For 1, 2, 4 ... maxThreads client threads, each thread adds then deletes a
+// water record for random users (what POST + DELETE /waters do) for
+// `seconds`, once with the default locked model and once with
+// EXECUTOR_SHARDS=`shards`. The journal runs with STORAGE_DURABILITY=none
+// and no checkpoints, so the numbers are the in-memory write path plus the
+// hand-off to the owning shard, not the disk.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/HealthBackend.hpp"
+#include "utils/Logger.hpp"
+
+static double opsPerSec(HealthBackend& backend, const std::vector<std::string>& tokens, int threads, double seconds) {
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> ops{0};
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t] {
+      std::mt19937_64 rng(t + 1);
+      std::uint64_t n = 0;
+      while (!stop) {
+        const std::string& token = tokens[rng() % tokens.size()];
+        const std::uint64_t id = backend.addWater(token, bench::isoDate(1, n % 1440), 250.0);
+        backend.deleteWater(token, id);
+        n += 2;
+      }
+      ops += n;
+    });
+  }
+  bench::Stopwatch sw;
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto& th : pool) th.join();
+  return ops / (sw.ms() / 1000.0);
+}
+
+// One backend per mode, fresh directory each time; ops/s per thread count.
+static std::vector<double> runMode(const std::string& dir, int users, const std::vector<int>& threadCounts,
+                                   double seconds) {
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::vector<double> out;
+  HealthBackend backend;
+  std::vector<std::string> tokens;
+  for (int i = 0; i < users; ++i) {
+    const std::string name = "user" + std::to_string(i);
+    backend.registerUser(name, 30, 70.0, 1.75, "pw", "other");
+    tokens.push_back(backend.login(name, "pw"));
+    backend.addWater(tokens.back(), bench::isoDate(0, 0), 250.0);
+  }
+  for (int n : threadCounts) out.push_back(opsPerSec(backend, tokens, n, seconds));
+  return out;
+}
+
+int main(int argc, char** argv) {
+  const int users = argc > 1 ? std::max(1, std::atoi(argv[1])) : 256;
+  const int maxThreads = argc > 2 ? std::max(1, std::atoi(argv[2])) : 8;
+  const double seconds = argc > 3 ? std::atof(argv[3]) : 1.0;
+  const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  const int shards = argc > 4 ? std::max(1, std::atoi(argv[4])) : static_cast<int>(hw);
+
+  const std::string dir = "/tmp/health_executor_bench";
+  std::filesystem::create_directories(dir);
+  util::Logger::init("/tmp/health_executor_bench.log", util::LogLevel::Error);
+  ::setenv("STORAGE_PATH", (dir + "/storage.json").c_str(), 1);
+  ::setenv("STORAGE_DURABILITY", "none", 1);
+  ::setenv("STORAGE_CHECKPOINT_BYTES", "1099511627776", 1);  // never, during a run
+
+  std::vector<int> threadCounts;
+  for (int n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+  threadCounts.push_back(maxThreads);
+
+  std::printf("%d users, %.1f s per run, %u hardware threads, %d shards\n", users, seconds, hw, shards);
+  ::unsetenv("EXECUTOR_SHARDS");
+  const std::vector<double> locked = runMode(dir, users, threadCounts, seconds);
+  ::setenv("EXECUTOR_SHARDS", std::to_string(shards).c_str(), 1);
+  const std::vector<double> sharded = runMode(dir, users, threadCounts, seconds);
+
+  std::printf("threads   locked ops/s   shard-per-core ops/s\n");
+  for (std::size_t i = 0; i < threadCounts.size(); ++i) {
+    std::printf("%7d   %12.0f   %20.0f  (%.2fx)\n", threadCounts[i], locked[i], sharded[i], sharded[i] / locked[i]);
+  }
+  util::Logger::shutdown();
+  std::filesystem::remove_all(dir);
+  return 0;
+}
@@ -0,0 +1,198 @@
+// Memory per record: the compact record encoding against the one it replaced.
+//
+//   footprint_bench [users=1000] [recordsPerCollection=1000]
+//
+// "strings" is the old layout: records with a std::string datetime (its own
+// heap block: 24 characters do not fit the inline buffer) and notes, a hash
+// index per collection, and published lists whose text arena holds every
+// datetime. "compact" is the current one: datetimes rebuilt from timeMs
+// unless the client's text differs (setDatetime), PackedText notes, a
+// sorted id array (RecordSet) and lists that keep only the exceptions.
+//
+// For each layout, in a fresh process (re-exec of this binary), the same
+// synthetic users (bench::makeSyntheticUsers: waters, sleeps, activities and
+// one category) are copied into the layout, writer side and published side,
+// and the RSS growth is divided by the number of records. The compact run
+// also prints what the in-process accounting (footprintOf, behind
+// GET /admin/memory) reports for the same data, to show how close it is.
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/UserVersion.hpp"
+
+namespace {
+
+struct StringWater {
+  std::string datetime;
+  double amountMl = 0.0;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct StringSleep {
+  std::string datetime;
+  double hours = 0.0;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct StringActivity {
+  std::string datetime;
+  int minutes = 0;
+  Symbol intensity;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct StringItem {
+  std::string datetime;
+  std::string note;
+  double value = 0.0;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+// The old RecordSet: slots plus a hash index id → slot.
+template <typename Rec>
+struct HashedSet {
+  std::vector<Rec> slots;
+  std::unordered_map<std::uint64_t, std::uint32_t> index;
+};
+
+// The old published list: the columns of RecordColumns.hpp, with every
+// datetime (not just the exceptions) in the text arena.
+struct TextColumns {
+  std::vector<std::uint64_t> id;
+  std::vector<std::int64_t> timeMs;
+  std::vector<TextArena::Ref> datetime;
+  std::vector<std::uint64_t> fields;  // the record's own fields, 8 bytes each
+  TextArena text;
+};
+
+struct StringUser {
+  HashedSet<StringWater> waters;
+  HashedSet<StringSleep> sleeps;
+  HashedSet<StringActivity> activities;
+  std::map<Symbol, HashedSet<StringItem>, SymbolLess> categories;
+  std::vector<TextColumns> published;
+};
+
+template <typename Rec, typename Out, typename Convert>
+HashedSet<Out> toHashed(const RecordSet<Rec>& in, Convert convert) {
+  HashedSet<Out> out;
+  out.slots.reserve(in.size());
+  out.index.reserve(in.size());
+  for (const Rec& r : in) {
+    out.index.emplace(r.id, static_cast<std::uint32_t>(out.slots.size()));
+    out.slots.push_back(convert(r));
+  }
+  return out;
+}
+
+template <typename Rec>
+TextColumns toTextColumns(const RecordSet<Rec>& in, std::size_t fieldsPerRecord) {
+  TextColumns c;
+  std::size_t textBytes = 0;
+  for (const Rec& r : in) {
+    textBytes += datetimeText(r).view().size();
+    if constexpr (std::is_same_v<Rec, CategoryItem>) textBytes += r.note.size();
+  }
+  c.id.reserve(in.size());
+  c.timeMs.reserve(in.size());
+  c.datetime.reserve(in.size());
+  c.fields.resize(in.size() * fieldsPerRecord);
+  c.text.reserve(textBytes);
+  for (const Rec& r : in) {
+    c.id.push_back(r.id);
+    c.timeMs.push_back(r.timeMs);
+    c.datetime.push_back(c.text.add(datetimeText(r).view()));
+    if constexpr (std::is_same_v<Rec, CategoryItem>) c.text.add(r.note.view());
+  }
+  return c;
+}
+
+StringUser toStrings(const UserData& u) {
+  StringUser s;
+  s.waters = toHashed<WaterRecord, StringWater>(u.waters, [](const WaterRecord& r) {
+    return StringWater{std::string(datetimeText(r).view()), r.amountMl, r.id, r.timeMs};
+  });
+  s.sleeps = toHashed<SleepRecord, StringSleep>(u.sleeps, [](const SleepRecord& r) {
+    return StringSleep{std::string(datetimeText(r).view()), r.hours, r.id, r.timeMs};
+  });
+  s.activities = toHashed<ActivityRecord, StringActivity>(u.activities, [](const ActivityRecord& r) {
+    return StringActivity{std::string(datetimeText(r).view()), r.minutes, r.intensity, r.id, r.timeMs};
+  });
+  s.published.push_back(toTextColumns(u.waters, 1));
+  s.published.push_back(toTextColumns(u.sleeps, 1));
+  s.published.push_back(toTextColumns(u.activities, 1));
+  for (const auto& [name, items] : u.categories) {
+    s.categories.emplace(name, toHashed<CategoryItem, StringItem>(items, [](const CategoryItem& r) {
+                           return StringItem{std::string(datetimeText(r).view()), r.note.str(), r.value, r.id,
+                                             r.timeMs};
+                         }));
+    s.published.push_back(toTextColumns(items, 2));  // note ref + value
+  }
+  return s;
+}
+
+int runLayout(const std::string& layout, std::size_t users, std::size_t perCollection) {
+  const UserMap data = bench::makeSyntheticUsers(users, perCollection);
+  std::size_t records = 0;
+  for (const auto& [_, u] : data) {
+    records += u.waters.size() + u.sleeps.size() + u.activities.size();
+    for (const auto& [_name, items] : u.categories) records += items.size();
+  }
+
+  const long rssBefore = bench::currentRssKb();
+  bench::Stopwatch sw;
+  if (layout == "strings") {
+    std::vector<StringUser> held;
+    held.reserve(data.size());
+    for (const auto& [_, u] : data) held.push_back(toStrings(u));
+    const double ms = sw.ms();
+    const long rss = bench::currentRssKb() - rssBefore;
+    std::printf("%-8s build %7.1f ms   %6.1f bytes/record (RSS)   water struct %zu bytes\n", layout.c_str(), ms,
+                rss * 1024.0 / static_cast<double>(records), sizeof(StringWater));
+    return 0;
+  }
+
+  UserMap copy = data;
+  std::vector<std::unique_ptr<UserVersion>> published;
+  published.reserve(copy.size());
+  for (const auto& [_, u] : copy) published.push_back(makeUserVersion(u));
+  const double ms = sw.ms();
+  const long rss = bench::currentRssKb() - rssBefore;
+
+  std::size_t accounted = 0;
+  std::size_t i = 0;
+  for (const auto& [_, u] : copy) accounted += footprintOf(u, published[i++].get()).bytes();
+  std::printf("%-8s build %7.1f ms   %6.1f bytes/record (RSS)   water struct %zu bytes   accounted %.1f bytes/record\n",
+              layout.c_str(), ms, rss * 1024.0 / static_cast<double>(records), sizeof(WaterRecord),
+              accounted / static_cast<double>(records));
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 5 && std::string(argv[1]) == "--layout") {
+    return runLayout(argv[2], std::stoul(argv[3]), std::stoul(argv[4]));
+  }
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 1000;
+  const std::size_t perCollection = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+  std::printf("%zu users x %zu records in each of 4 collections\n", users, perCollection);
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = 0;
+  for (const char* layout : {"strings", "compact"}) {
+    rc |= bench::runSelf(self, {"--layout", layout, std::to_string(users), std::to_string(perCollection)});
+  }
+  return rc;
+}
@@ -0,0 +1,147 @@
+// Interned (Symbol) vs per-record std::string activity intensities.
+//
+//   intern_bench [users=2000] [activitiesPerUser=1000]
+//
+// "strings" is what the records used to hold: a std::string per value.
+// "symbols" is the current ActivityRecord, whose intensity is a Symbol into
+// the shared pool (Symbol.hpp); genders and category names are per-user
+// strings in both layouts. For each layout and each intensity vocabulary,
+// in a fresh process (re-exec of this binary), every user gets a gender,
+// one category and `activitiesPerUser` activities built from the same
+// pre-generated inputs, as ingest does. It reports heap allocations and RSS
+// growth per activity record.
+//
+// The "short" vocabulary is the API's own ("low", "moderate", "vigorous"):
+// it fits in std::string's inline buffer, so interning saves the field's
+// size but no allocations. The "long" one stands for client-defined values
+// past that buffer, where every record used to pay an allocation.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "alloc/AllocCounter.hpp"
+#include "core/Records.hpp"
+
+namespace {
+
+struct StringActivity {
+  std::string datetime;
+  int minutes = 0;
+  std::string intensity;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct StringUser {
+  std::string gender;
+  std::vector<StringActivity> activities;
+  std::map<std::string, int> categories;
+};
+
+struct SymbolUser {
+  std::string gender;
+  std::vector<ActivityRecord> activities;
+  std::map<std::string, int, std::less<>> categories;
+};
+
+const std::vector<std::string> kShort = {"low", "moderate", "vigorous"};
+const std::vector<std::string> kLong = {"light walking, flat route", "moderate cardio session",
+                                        "vigorous interval training"};
+const std::vector<std::string> kGenders = {"female", "male", "other"};
+const std::vector<std::string> kCategories = {"Mood", "Blood pressure readings", "Medication taken"};
+
+// What one ingest reads: per record a datetime and an intensity index.
+struct Inputs {
+  std::vector<std::string> when;
+  std::vector<std::uint8_t> pick;
+};
+
+Inputs makeInputs(std::size_t perUser) {
+  std::mt19937 rng(42);
+  Inputs in;
+  for (std::size_t i = 0; i < perUser; ++i) {
+    in.when.push_back(bench::isoDate(static_cast<int>(i / 4), static_cast<int>(rng() % 1440)));
+    in.pick.push_back(static_cast<std::uint8_t>(rng() % 3));
+  }
+  return in;
+}
+
+template <typename User, typename Activity>
+std::vector<User> ingest(std::size_t users, const Inputs& in, const std::vector<std::string>& vocab) {
+  std::vector<User> out(users);
+  for (std::size_t u = 0; u < users; ++u) {
+    User& user = out[u];
+    user.gender = kGenders[u % kGenders.size()];
+    user.categories[kCategories[u % kCategories.size()]] = 0;
+    user.activities.reserve(in.when.size());
+    for (std::size_t i = 0; i < in.when.size(); ++i) {
+      Activity a;
+      a.datetime = in.when[i];
+      a.minutes = 30;
+      a.intensity = vocab[in.pick[i]];
+      a.id = i + 1;
+      user.activities.push_back(std::move(a));
+    }
+  }
+  return out;
+}
+
+int runLayout(const std::string& layout, const std::string& vocabName, std::size_t users, std::size_t perUser) {
+  const Inputs in = makeInputs(perUser);
+  const std::vector<std::string>& vocab = vocabName == "long" ? kLong : kShort;
+  const std::size_t records = users * perUser;
+
+  const long rssBefore = bench::currentRssKb();
+  const std::size_t allocsBefore = bench::alloc::allocations();
+  bench::Stopwatch sw;
+  std::size_t check = 0;
+  if (layout == "strings") {
+    const auto data = ingest<StringUser, StringActivity>(users, in, vocab);
+    const double ms = sw.ms();
+    const std::size_t allocs = bench::alloc::allocations() - allocsBefore;
+    const long rss = bench::currentRssKb() - rssBefore;
+    for (const auto& u : data) check += u.activities.back().intensity.size() + u.gender.size();
+    std::printf("%-8s %-6s ingest %7.1f ms   %5.2f allocs/record   %6.1f bytes/record"
+                "   (%zu bytes/struct, check %zu)\n",
+                layout.c_str(), vocabName.c_str(), ms, allocs / static_cast<double>(records),
+                rss * 1024.0 / static_cast<double>(records), sizeof(StringActivity), check);
+  } else {
+    const auto data = ingest<SymbolUser, ActivityRecord>(users, in, vocab);
+    const double ms = sw.ms();
+    const std::size_t allocs = bench::alloc::allocations() - allocsBefore;
+    const long rss = bench::currentRssKb() - rssBefore;
+    for (const auto& u : data) check += u.activities.back().intensity.view().size() + u.gender.size();
+    const Symbol::PoolStats pool = Symbol::poolStats();
+    std::printf("%-8s %-6s ingest %7.1f ms   %5.2f allocs/record   %6.1f bytes/record"
+                "   (%zu bytes/struct, check %zu; pool %zu symbols, %zu bytes)\n",
+                layout.c_str(), vocabName.c_str(), ms, allocs / static_cast<double>(records),
+                rss * 1024.0 / static_cast<double>(records), sizeof(ActivityRecord), check, pool.symbols, pool.bytes);
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 6 && std::string(argv[1]) == "--layout") {
+    return runLayout(argv[2], argv[3], std::stoul(argv[4]), std::stoul(argv[5]));
+  }
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const std::size_t perUser = argc > 2 ? std::max<std::size_t>(1, std::stoul(argv[2])) : 1000;
+
+  std::printf("%zu users x %zu activities\n", users, perUser);
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = 0;
+  for (const char* vocab : {"short", "long"}) {
+    for (const char* layout : {"strings", "symbols"}) {
+      rc |= bench::runSelf(self, {"--layout", layout, vocab, std::to_string(users), std::to_string(perUser)});
+    }
+  }
+  return rc;
+}
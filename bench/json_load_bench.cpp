@@ -0,0 +1,64 @@
+// JSON snapshot loading: DOM (parse into nlohmann::json, then walk it)
+// vs the streaming SAX loader Storage uses.
+//
+//   json_load_bench [users=2000] [recordsPerCollection=100] [dir=/tmp/health_json_load_bench]
+//
+// Each loader runs in a fresh process; "model" is the RSS left once the
+// loader has returned: roughly the in-memory UserMap, plus (DOM path) the
+// heap the allocator keeps after the DOM is freed.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "BenchUtil.hpp"
+#include "core/SnapshotJson.hpp"
+#include "core/Storage.hpp"
+
+static bool loadDom(const std::string& path, UserMap& users, std::uint64_t& seq) {
+  std::ifstream in(path);
+  nlohmann::json j;
+  try {
+    in >> j;
+  } catch (...) {
+    return false;
+  }
+  return usersFromJson(j, users, seq);
+}
+
+static int loadOnce(const std::string& mode, const std::string& path) {
+  const long before = bench::currentRssKb();
+  UserMap users;
+  std::uint64_t seq = 0;
+  bench::Stopwatch sw;
+  const bool ok = mode == "--dom" ? loadDom(path, users, seq) : readJsonSnapshot(path, users, seq);
+  const double ms = sw.ms();
+  std::printf("%-4s load %9.1f ms   peak RSS %8ld KiB   model %8ld KiB   users %zu%s\n", mode.c_str() + 2, ms,
+              bench::maxRssKb(), bench::currentRssKb() - before, users.size(), ok ? "" : "   (FAILED)");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc == 3 && (std::string(argv[1]) == "--dom" || std::string(argv[1]) == "--sax")) {
+    return loadOnce(argv[1], argv[2]);
+  }
+
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const std::size_t perCollection = argc > 2 ? std::stoul(argv[2]) : 100;
+  const std::string dir = argc > 3 ? argv[3] : "/tmp/health_json_load_bench";
+  std::filesystem::create_directories(dir);
+
+  const std::string path = dir + "/storage.json";
+  {
+    UserMap data = bench::makeSyntheticUsers(users, perCollection);
+    Storage(path).saveSnapshot(data, 1);
+  }
+  std::printf("dataset: %zu users x %zu records per collection, %.1f MiB\n", users, perCollection,
+              std::filesystem::file_size(path) / (1024.0 * 1024.0));
+
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = bench::runSelf(self, {"--dom", path});
+  rc |= bench::runSelf(self, {"--sax", path});
+  return rc;
+}
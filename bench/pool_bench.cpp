@@ -0,0 +1,92 @@
+// Cheap GETs next to slow writes: httplib's ThreadPool against our
+// WorkStealingPool.
+//
+//   pool_bench [slowWriters=16] [writeMs=200] [seconds=3] [workers=8]
+//
+// An in-process server with `workers` threads gets a POST route that takes
+// `writeMs` (standing in for a write stuck behind fsync or a snapshot) and
+// GET /health. `slowWriters` client threads post non-stop while one client
+// times GET /health. With httplib's pool the slow writes take every worker
+// and the GETs queue behind them; with ours, writes run in the write lane and
+// the pool starts extra threads for them, so GETs keep a free worker.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../third_party/httplib.h"
+#include "BenchUtil.hpp"
+#include "server/ServerSetup.hpp"
+#include "server/WorkerPool.hpp"
+#include "utils/Logger.hpp"
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, static_cast<std::size_t>(p * (v.size() - 1)))];
+}
+
+static void run(const char* label, bool ours, int writers, int writeMs, double seconds, std::size_t workers) {
+  httplib::Server svr;
+  server::setupServerCommon(svr);
+  if (!ours) svr.new_task_queue = [workers] { return new httplib::ThreadPool(workers); };
+  svr.Post("/slow", [writeMs](const httplib::Request&, httplib::Response& res) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(writeMs));
+    res.set_content("{}", "application/json");
+  });
+  svr.Get("/health", [](const httplib::Request&, httplib::Response& res) { res.set_content("ok", "text/plain"); });
+  const int port = svr.bind_to_any_port("127.0.0.1");
+  std::thread server([&] { svr.listen_after_bind(); });
+  svr.wait_until_ready();
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> writes{0};
+  std::vector<std::thread> clients;
+  for (int i = 0; i < writers; ++i) {
+    clients.emplace_back([&] {
+      httplib::Client cli("127.0.0.1", port);
+      while (!stop) {
+        if (cli.Post("/slow", "{}", "application/json")) ++writes;
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));  // let the writers fill the pool
+
+  std::vector<double> getMs;
+  httplib::Client probe("127.0.0.1", port);
+  probe.set_read_timeout(30, 0);
+  bench::Stopwatch total;
+  while (total.ms() < seconds * 1000.0) {
+    bench::Stopwatch sw;
+    if (probe.Get("/health")) getMs.push_back(sw.ms());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  stop = true;
+  for (auto& c : clients) c.join();
+  svr.stop();
+  server.join();
+
+  std::printf("%-22s GET /health p50 %8.2f ms  p99 %8.2f ms  max %8.2f ms  (%zu GETs, %d slow writes)\n", label,
+              percentile(getMs, 0.50), percentile(getMs, 0.99), percentile(getMs, 1.0), getMs.size(), writes.load());
+}
+
+int main(int argc, char** argv) {
+  const int writers = argc > 1 ? std::max(1, std::atoi(argv[1])) : 16;
+  const int writeMs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+  const double seconds = argc > 3 ? std::atof(argv[3]) : 3.0;
+  const std::size_t workers = argc > 4 ? std::max(1, std::atoi(argv[4])) : 8;
+
+  util::Logger::init("/tmp/health_pool_bench.log", util::LogLevel::Error);
+  const std::string w = std::to_string(workers);
+  ::setenv("HTTP_WORKERS", w.c_str(), 1);
+  std::printf("%d slow writers (%d ms each), %zu workers, %.1f s per run\n", writers, writeMs, workers, seconds);
+  run("httplib ThreadPool", false, writers, writeMs, seconds, workers);
+  run("WorkStealingPool", true, writers, writeMs, seconds, workers);
+  util::Logger::shutdown();
+  return 0;
+}
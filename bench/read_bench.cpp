@@ -0,0 +1,100 @@
+// Read throughput on one user while that same user is being written.
+//
+//   read_bench [readers=4] [records=1000] [seconds=2]
+//
+// `readers` threads list the user's water records in a loop (what GET
+// /waters does), first alone, then next to one thread that adds / updates /
+// deletes records of that user non-stop. Reads go to the published version
+// and take no user lock, so the second number should stay close to the
+// first (on a machine with a core to spare for the writer).
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/HealthBackend.hpp"
+#include "utils/Logger.hpp"
+
+struct Run {
+  double readsPerSec = 0;
+  double writesPerSec = 0;
+  double sizeSeen = 0;  // average list size, to show readers saw the writes
+};
+
+static Run run(HealthBackend& backend, const std::string& token, int readers, double seconds, bool withWriter) {
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> reads{0}, writes{0}, sizes{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < readers; ++t) {
+    threads.emplace_back([&] {
+      std::uint64_t n = 0, seen = 0;
+      while (!stop) {
+        seen += backend.getAllWater(token).size();
+        ++n;
+      }
+      reads += n;
+      sizes += seen;
+    });
+  }
+  if (withWriter) {
+    threads.emplace_back([&] {
+      std::uint64_t n = 0;
+      while (!stop) {
+        const std::uint64_t id = backend.addWater(token, bench::isoDate(50, n % 1440), 250.0);
+        backend.updateWater(token, id, bench::isoDate(51, n % 1440), 300.0);
+        backend.deleteWater(token, id);
+        n += 3;
+      }
+      writes += n;
+    });
+  }
+  bench::Stopwatch sw;
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto& t : threads) t.join();
+  const double secs = sw.ms() / 1000.0;
+
+  Run r;
+  r.readsPerSec = reads / secs;
+  r.writesPerSec = writes / secs;
+  r.sizeSeen = reads > 0 ? static_cast<double>(sizes) / reads : 0;
+  return r;
+}
+
+int main(int argc, char** argv) {
+  const int readers = argc > 1 ? std::max(1, std::atoi(argv[1])) : 4;
+  const int records = argc > 2 ? std::max(2, std::atoi(argv[2])) : 1000;
+  const double seconds = argc > 3 ? std::atof(argv[3]) : 2.0;
+
+  const std::string dir = "/tmp/health_read_bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  ::setenv("STORAGE_PATH", (dir + "/storage.json").c_str(), 1);
+  util::Logger::init(dir + "/bench.log", util::LogLevel::Error);
+
+  {
+    HealthBackend backend;
+    backend.registerUser("reader", 30, 70.0, 1.75, "pw", "other");
+    const std::string token = backend.login("reader", "pw");
+    for (int i = 0; i < records; ++i) backend.addWater(token, bench::isoDate(i / 1440, i % 1440), 250.0);
+
+    std::printf("%d reader thread(s), %d water records, %.1f s per run, %u hardware threads\n", readers, records,
+                seconds, std::thread::hardware_concurrency());
+    const Run alone = run(backend, token, readers, seconds, false);
+    const Run mixed = run(backend, token, readers, seconds, true);
+    std::printf("reads only        %10.0f reads/s  (list size %.0f)\n", alone.readsPerSec, alone.sizeSeen);
+    std::printf("reads + 1 writer  %10.0f reads/s  (list size %.0f)  %8.0f writes/s  reads at %.0f%%\n",
+                mixed.readsPerSec, mixed.sizeSeen, mixed.writesPerSec, 100.0 * mixed.readsPerSec / alone.readsPerSec);
+    const auto ep = EpochDomain::global().stats();
+    std::printf("versions retired and freed: %llu, pending: %zu\n", static_cast<unsigned long long>(ep.freed),
+                ep.pending);
+  }
+  util::Logger::shutdown();
+  std::filesystem::remove_all(dir);
+  return 0;
+}
@@ -0,0 +1,155 @@
+// Heap allocations per HTTP request, with and without the request arena.
+//
+//   request_alloc_bench [requests=2000] [seededWaters=1000]
+//
+// Runs the real server (setupServerCommon + registerRoutes) in-process on a
+// loopback port and drives it with one keep-alive client. The replaced
+// operator new (alloc/AllocCounter.cpp) counts every allocation made off the
+// client's thread, so the numbers cover httplib, the server hooks, the
+// routes and the backend, but not the client. Each route gets a warm-up pass, then `requests` measured
+// requests; the table shows allocations and bytes per request.
+//
+// Each mode runs in a fresh process (re-exec of this binary): "heap" with
+// REQUEST_ARENA_KB=0, "arena" with the default. OPTIONS is the floor: what
+// httplib and the server hooks cost before any route runs. Logging is at
+// the default level (Info) into a file, as the server runs by default.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../third_party/httplib.h"
+#include "../third_party/json.hpp"
+#include "BenchUtil.hpp"
+#include "alloc/AllocCounter.hpp"
+#include "core/HealthBackend.hpp"
+#include "routes/Routes.hpp"
+#include "server/ServerSetup.hpp"
+#include "utils/Logger.hpp"
+
+namespace {
+
+struct Counted {
+  double allocs = 0;
+  double bytes = 0;
+};
+
+template <typename Fn>
+Counted measure(int requests, Fn&& request) {
+  for (int i = 0; i < requests / 10 + 1; ++i) request(i);  // warm-up: arena sized, pools filled
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const std::size_t a0 = bench::alloc::allocations(), b0 = bench::alloc::bytes();
+  for (int i = 0; i < requests; ++i) request(i);
+  return {static_cast<double>(bench::alloc::allocations() - a0) / requests,
+          static_cast<double>(bench::alloc::bytes() - b0) / requests};
+}
+
+int runMode(const std::string& mode, int requests, int seeded) {
+  bench::alloc::setUncounted(true);  // allocations on the client's thread are not counted
+  if (mode == "heap") ::setenv("REQUEST_ARENA_KB", "0", 1);
+  const std::string dir = "/tmp/health_request_alloc_bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  ::setenv("STORAGE_PATH", (dir + "/storage.json").c_str(), 1);
+  ::setenv("STORAGE_DURABILITY", "none", 1);
+  ::setenv("STORAGE_CHECKPOINT_BYTES", "1099511627776", 1);  // never, during a run
+  util::Logger::init(dir + "/server.log", util::LogLevel::Info);
+  std::fflush(stdout);
+  const int realStdout = ::dup(1);  // the logger also writes to stdout; keep the table readable
+  ::dup2(::open("/dev/null", O_WRONLY), 1);
+
+  HealthBackend backend;
+  backend.registerUser("bench", 30, 70.0, 1.75, "pw", "other");
+  const std::string token = backend.login("bench", "pw");
+  for (int i = 0; i < seeded; ++i) backend.addWater(token, bench::isoDate(i / 4, i % 1440), 250.0);
+  const std::uint64_t patchId = backend.addWater(token, bench::isoDate(0, 0), 250.0);
+
+  httplib::Server svr;
+  server::setupServerCommon(svr);
+  registerRoutes(svr, backend);
+  svr.set_keep_alive_max_count(1000000);  // one connection for the whole run: no per-connection setup
+  const int port = svr.bind_to_any_port("127.0.0.1");
+  std::thread listener([&] {
+    bench::alloc::setUncounted(false);
+    svr.listen_after_bind();
+  });
+  svr.wait_until_ready();
+
+  httplib::Client cli("127.0.0.1", port);
+  cli.set_keep_alive(true);
+  cli.set_tcp_nodelay(true);  // else headers and body wait on delayed ACKs
+  const httplib::Headers auth = {{"Authorization", "Bearer " + token}};
+  // httplib reads a DELETE without Content-Length until the keep-alive timeout.
+  const httplib::Headers authNoBody = {{"Authorization", "Bearer " + token}, {"Content-Length", "0"}};
+  const std::string body = R"({"datetime":"2024-03-01T07:30:00.000Z","amountMl":250})";
+  std::vector<std::uint64_t> added;
+  bool ok = true;
+  auto expect = [&](const httplib::Result& r, int status) {
+    if (!r || r->status != status) ok = false;
+    return r ? r->body : std::string();
+  };
+
+  struct Row {
+    const char* name;
+    Counted c;
+  };
+  std::vector<Row> rows;
+  rows.push_back({"OPTIONS /waters", measure(requests, [&](int) { expect(cli.Options("/waters"), 204); })});
+  rows.push_back({"GET /health", measure(requests, [&](int) { expect(cli.Get("/health"), 200); })});
+  rows.push_back({"POST /waters", measure(requests, [&](int) {
+                    const std::string out = expect(cli.Post("/waters", auth, body, "application/json"), 201);
+                    added.push_back(std::stoull(nlohmann::json::parse(out).value("id", "0")));
+                  })});
+  rows.push_back({"PATCH /waters/:id", measure(requests, [&](int) {
+                    expect(cli.Patch("/waters/" + std::to_string(patchId), auth, R"({"amountMl":300})",
+                                     "application/json"),
+                           200);
+                  })});
+  rows.push_back(
+      {"GET /waters?limit=20", measure(requests, [&](int) { expect(cli.Get("/waters?limit=20", auth), 200); })});
+  rows.push_back(
+      {"GET /waters (full)", measure(requests / 10 + 1, [&](int) { expect(cli.Get("/waters", auth), 200); })});
+  std::size_t next = 0;
+  const int deletes = std::min<int>(requests, static_cast<int>(added.size()) * 10 / 11);
+  rows.push_back({"DELETE /waters/:id", measure(deletes, [&](int) {
+                    expect(cli.Delete("/waters/" + std::to_string(added[next++]), authNoBody), 204);
+                  })});
+
+  svr.stop();
+  listener.join();
+  std::fflush(stdout);
+  ::dup2(realStdout, 1);
+  for (const Row& r : rows) {
+    std::printf("%-6s %-22s %8.1f allocs/request %10.0f bytes/request\n", mode.c_str(), r.name, r.c.allocs,
+                r.c.bytes);
+  }
+  util::Logger::shutdown();
+  std::filesystem::remove_all(dir);
+  if (!ok) std::printf("%s: some requests failed\n", mode.c_str());
+  return ok ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 5 && std::string(argv[1]) == "--mode") {
+    return runMode(argv[2], std::atoi(argv[3]), std::atoi(argv[4]));
+  }
+  const int requests = argc > 1 ? std::max(10, std::atoi(argv[1])) : 2000;
+  const int seeded = argc > 2 ? std::max(0, std::atoi(argv[2])) : 1000;
+
+  std::printf("%d requests per route, %d seeded waters; allocations off the client thread\n", requests, seeded);
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = 0;
+  for (const char* mode : {"heap", "arena"}) {
+    rc |= bench::runSelf(self, {"--mode", mode, std::to_string(requests), std::to_string(seeded)});
+  }
+  return rc;
+}
@@ -0,0 +1,99 @@
+// Record responses: built as a RequestJson document and dumped, against
+// written straight from the schema (appendRecordJson in routes/Helpers.hpp).
+//
+//   schema_json_bench [records=3200] [reps=200]
+//
+// For waters and activities, a published list of `records` records is
+// rendered as the body of a full GET list route, `reps` times, with the
+// request arena reset before each one as the server does. "dom" is what the
+// routes did before the schemas: one object per record, ids as strings, then
+// dump(). "schema" is what they do now. Both bodies are compared, so a run
+// also checks that the text is byte for byte the same.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "BenchUtil.hpp"
+#include "core/RecordSchema.hpp"
+#include "routes/Helpers.hpp"
+#include "utils/RequestArena.hpp"
+
+namespace {
+
+std::string domBody(const RecordList<WaterRecord>& list) {
+  RequestJson arr = RequestJson::array();
+  for (const WaterView& r : list) {
+    RequestJson jr;
+    jr["id"] = std::to_string(r.id);
+    jr["datetime"] = r.datetime.view();
+    jr["amountMl"] = r.amountMl;
+    arr.push_back(std::move(jr));
+  }
+  const ArenaString text = arr.dump();
+  return std::string(text.data(), text.size());
+}
+
+std::string domBody(const RecordList<ActivityRecord>& list) {
+  RequestJson arr = RequestJson::array();
+  for (const ActivityView& a : list) {
+    RequestJson ja;
+    ja["id"] = std::to_string(a.id);
+    ja["datetime"] = a.datetime.view();
+    ja["minutes"] = a.minutes;
+    ja["intensity"] = a.intensity;
+    arr.push_back(std::move(ja));
+  }
+  const ArenaString text = arr.dump();
+  return std::string(text.data(), text.size());
+}
+
+template <typename Schema>
+std::string schemaBody(const RecordList<typename Schema::Record>& list) {
+  ArenaString out;
+  out.reserve(list.size() * 64 + 2);
+  out += '[';
+  for (const auto& r : list) {
+    if (out.size() > 1) out += ',';
+    appendRecordJson<Schema>(out, r);
+  }
+  out += ']';
+  return std::string(out.data(), out.size());
+}
+
+template <typename Render>
+double timeRender(int reps, std::string& body, Render&& render) {
+  bench::Stopwatch sw;
+  for (int i = 0; i < reps; ++i) {
+    util::RequestArena::reset();
+    body = render();
+  }
+  return sw.ms() * 1000.0 / reps;
+}
+
+template <typename Schema>
+bool compare(const char* name, const RecordList<typename Schema::Record>& list, int reps) {
+  std::string dom, schema;
+  const double domUs = timeRender(reps, dom, [&] { return domBody(list); });
+  const double schemaUs = timeRender(reps, schema, [&] { return schemaBody<Schema>(list); });
+  std::printf("%-10s %zu records, %zu bytes   dom %8.1f us   schema %8.1f us   %.1fx   %s\n", name, list.size(),
+              schema.size(), domUs, schemaUs, domUs / schemaUs, dom == schema ? "same text" : "TEXT DIFFERS");
+  return dom == schema;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t records = argc > 1 ? std::stoul(argv[1]) : 3200;
+  const int reps = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+
+  const UserMap users = bench::makeSyntheticUsers(1, records);
+  const UserData& u = users.begin()->second;
+  const RecordList<WaterRecord> waters(u.waters);
+  const RecordList<ActivityRecord> activities(u.activities);
+
+  bool same = compare<WaterSchema>("waters", waters, reps);
+  same = compare<ActivitySchema>("activities", activities, reps) && same;
+  return same ? 0 : 1;
+}
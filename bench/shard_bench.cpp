@@ -0,0 +1,66 @@
+// Single-file vs sharded storage layout.
+//
+//   shard_bench [users=2000] [recordsPerCollection=50] [dir=/tmp/health_shard_bench]
+//
+// Measures the cost of persisting a change to one user (the whole file vs
+// that user's shard) and the time to load everything back (one parse vs
+// shards loaded in parallel), for both snapshot formats.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "BenchUtil.hpp"
+#include "core/Storage.hpp"
+
+static void run(const std::string& dir, const char* ext, UserMap& data) {
+  const std::string path = dir + "/storage" + ext;
+  Storage single(path);
+  Storage sharded(path, Storage::Layout::Sharded);
+
+  // Initial full write of both layouts.
+  for (auto& [_, u] : data) u.dirty = true;
+  single.saveSnapshot(data, 1);
+  sharded.saveSnapshot(data, 1);
+  for (auto& [_, u] : data) u.dirty = false;
+
+  // One user changes.
+  auto& one = data.begin()->second;
+  one.waters.push_back({"2024-06-01T08:00:00.000Z", 250.0});
+  one.dirty = true;
+
+  bench::Stopwatch sw;
+  single.saveSnapshot(data, 2);
+  const double singleSave = sw.ms();
+  bench::Stopwatch sw2;
+  sharded.saveSnapshot(data, 2);
+  const double shardSave = sw2.ms();
+  one.dirty = false;
+
+  UserMap a, b;
+  std::uint64_t seq = 0;
+  bench::Stopwatch sw3;
+  single.loadSnapshot(a, seq);
+  const double singleLoad = sw3.ms();
+  bench::Stopwatch sw4;
+  sharded.loadSnapshot(b, seq);
+  const double shardLoad = sw4.ms();
+
+  std::printf("%-6s save after 1 change: single %9.2f ms   sharded %7.2f ms\n", ext + 1, singleSave, shardSave);
+  std::printf("%-6s load everything:     single %9.2f ms   sharded %7.2f ms (%zu / %zu users)\n", ext + 1,
+              singleLoad, shardLoad, a.size(), b.size());
+}
+
+int main(int argc, char** argv) {
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const std::size_t perCollection = argc > 2 ? std::stoul(argv[2]) : 50;
+  const std::string dir = argc > 3 ? argv[3] : "/tmp/health_shard_bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  UserMap data = bench::makeSyntheticUsers(users, perCollection);
+  std::printf("dataset: %zu users x %zu records per collection\n", users, perCollection);
+  run(dir + "/json", ".json", data);
+  run(dir + "/binary", ".hbs", data);
+  return 0;
+}
@@ -0,0 +1,61 @@
+// Startup cost of the JSON snapshot vs the binary (.hbs) snapshot.
+//
+//   startup_bench [users=2000] [recordsPerCollection=100] [dir=/tmp/health_startup_bench]
+//
+// Writes the same synthetic dataset in both formats, then loads each one in
+// a fresh process (re-exec of this binary) so load time and peak RSS are
+// measured in isolation.
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "BenchUtil.hpp"
+#include "core/Storage.hpp"
+
+static int loadOnce(const std::string& path) {
+  Storage storage(path);
+  UserMap users;
+  std::uint64_t seq = 0;
+  bench::Stopwatch sw;
+  bool ok = storage.loadSnapshot(users, seq);
+  double ms = sw.ms();
+  std::size_t records = 0;
+  for (const auto& [_, u] : users) records += u.waters.size() + u.sleeps.size() + u.activities.size();
+  std::printf("%-7s load %9.1f ms   peak RSS %8ld KiB   users %zu records %zu%s\n",
+              Storage::formatName(storage.format()), ms, bench::maxRssKb(), users.size(), records,
+              ok ? "" : "   (FAILED)");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc == 3 && std::string(argv[1]) == "--load") return loadOnce(argv[2]);
+
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const std::size_t perCollection = argc > 2 ? std::stoul(argv[2]) : 100;
+  const std::string dir = argc > 3 ? argv[3] : "/tmp/health_startup_bench";
+  std::filesystem::create_directories(dir);
+
+  const std::string jsonPath = dir + "/storage.json";
+  const std::string binPath = dir + "/storage.hbs";
+  {
+    UserMap data = bench::makeSyntheticUsers(users, perCollection);
+    bench::Stopwatch sw;
+    Storage(jsonPath).saveSnapshot(data, 1);
+    double jsonMs = sw.ms();
+    bench::Stopwatch sw2;
+    Storage(binPath).saveSnapshot(data, 1);
+    double binMs = sw2.ms();
+    std::printf("dataset: %zu users x %zu records per collection\n", users, perCollection);
+    std::printf("json    size %8.1f MiB   write %8.1f ms\n",
+                std::filesystem::file_size(jsonPath) / (1024.0 * 1024.0), jsonMs);
+    std::printf("binary  size %8.1f MiB   write %8.1f ms\n",
+                std::filesystem::file_size(binPath) / (1024.0 * 1024.0), binMs);
+  }
+
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = bench::runSelf(self, {"--load", jsonPath});
+  rc |= bench::runSelf(self, {"--load", binPath});
+  return rc;
+}
@@ -0,0 +1,140 @@
+// Hot / cold tiering: what a long history costs with and without archived
+// segments.
+//
+//   tiering_bench [users=20] [days=730] [perDay=8]
+//
+// Every user logs `perDay` waters a day for the last `days` days, oldest
+// first, through HealthBackend::addWater. Each mode runs in a fresh process
+// (re-exec of this binary): "memory" keeps everything resident (tiering off),
+// "tiered" sets STORAGE_ARCHIVE_DAYS=30 with the default batch, so records
+// older than 30 days are cut into segments as they age.
+//
+// Reported per mode: the resident bytes (memoryReport, what GET
+// /admin/memory shows), the size of the snapshot a checkpoint rewrites and
+// of the segment files, and the time of a list query for the last 14 days
+// (the dashboard) and for the whole history (reads every segment).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/HealthBackend.hpp"
+#include "utils/Logger.hpp"
+
+namespace {
+
+constexpr std::int64_t kDayMs = 24LL * 60 * 60 * 1000;
+
+std::int64_t nowMs() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+std::string isoAt(std::int64_t ms) {
+  char buf[kCanonicalTimeLen];
+  formatTimestamp(ms, buf);
+  return std::string(buf, sizeof(buf));
+}
+
+std::uintmax_t bytesUnder(const std::string& dir) {
+  std::uintmax_t n = 0;
+  std::error_code ec;
+  for (auto it = std::filesystem::recursive_directory_iterator(dir, ec);
+       it != std::filesystem::recursive_directory_iterator(); ++it) {
+    if (it->is_regular_file()) n += it->file_size();
+  }
+  return n;
+}
+
+// Average microseconds per call and the records the last call returned.
+template <typename Query>
+double timeQuery(int runs, std::size_t& records, Query&& query) {
+  bench::Stopwatch sw;
+  for (int i = 0; i < runs; ++i) records = query();
+  return sw.ms() * 1000.0 / runs;
+}
+
+int runMode(const std::string& mode, int users, int days, int perDay) {
+  const std::string dir = "/tmp/health_tiering_bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  ::setenv("STORAGE_PATH", (dir + "/storage.json").c_str(), 1);
+  ::setenv("STORAGE_DURABILITY", "none", 1);
+  ::setenv("STORAGE_CHECKPOINT_BYTES", "1099511627776", 1);  // never, during a run: the final one is measured
+  if (mode == "tiered") ::setenv("STORAGE_ARCHIVE_DAYS", "30", 1);
+  util::Logger::init(dir + "/bench.log", util::LogLevel::Error);
+
+  const std::int64_t now = nowMs();
+  std::size_t resident = 0, residentRecords = 0, recent = 0, all = 0;
+  double loadMs = 0, recentUs = 0, allUs = 0;
+  HealthBackend::ArchiveStats archived;
+  {
+    HealthBackend backend;
+    std::vector<std::string> tokens;
+    for (int u = 0; u < users; ++u) {
+      const std::string name = "user" + std::to_string(u);
+      backend.registerUser(name, 30, 70.0, 1.75, "pw", "other");
+      tokens.push_back(backend.login(name, "pw"));
+    }
+    bench::Stopwatch sw;
+    for (int d = days; d > 0; --d) {
+      for (int k = 0; k < perDay; ++k) {
+        const std::string at = isoAt(now - d * kDayMs + k * (kDayMs / perDay));
+        for (const std::string& token : tokens) backend.addWater(token, at, 250.0);
+      }
+    }
+    loadMs = sw.ms();
+
+    const HealthBackend::MemoryReport report = backend.memoryReport(0);
+    resident = report.bytes;
+    residentRecords = report.waters.records;
+    archived = backend.archiveStats();
+
+    RecordQuery lastTwoWeeks;
+    lastTwoWeeks.from = now - 14 * kDayMs;
+    const std::string& token = tokens.front();
+    auto count = [&](const RecordQuery& q) {
+      std::size_t n = 0;
+      for (const auto& list : backend.queryWater(token, q)) n += list.between(q.from, q.to).size();
+      return n;
+    };
+    recentUs = timeQuery(1000, recent, [&] { return count(lastTwoWeeks); });
+    allUs = timeQuery(20, all, [&] { return count(RecordQuery{}); });
+  }  // the destructor writes the final snapshot
+
+  const std::uintmax_t snapshot = std::filesystem::file_size(dir + "/storage.json");
+  const std::uintmax_t segments = bytesUnder(dir + "/archive");
+  std::printf("%-7s load %8.0f ms  resident %7.1f MiB (%zu records)  snapshot %7.1f MiB  segments %6.1f MiB "
+              "(%llu files)\n",
+              mode.c_str(), loadMs, resident / 1048576.0, residentRecords, snapshot / 1048576.0,
+              segments / 1048576.0, static_cast<unsigned long long>(archived.segmentsWritten));
+  std::printf("%-7s last 14 days %8.1f us (%zu records)   whole history %8.1f us (%zu records)\n", mode.c_str(),
+              recentUs, recent, allUs, all);
+  util::Logger::shutdown();
+  std::filesystem::remove_all(dir);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 6 && std::string(argv[1]) == "--mode") {
+    return runMode(argv[2], std::atoi(argv[3]), std::atoi(argv[4]), std::atoi(argv[5]));
+  }
+  const int users = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+  const int days = argc > 2 ? std::max(1, std::atoi(argv[2])) : 730;
+  const int perDay = argc > 3 ? std::max(1, std::atoi(argv[3])) : 8;
+
+  std::printf("%d users x %d days x %d waters a day\n", users, days, perDay);
+  const std::string self = bench::selfPath(argv[0]);
+  int rc = 0;
+  for (const char* mode : {"memory", "tiered"}) {
+    rc |= bench::runSelf(self, {"--mode", mode, std::to_string(users), std::to_string(days), std::to_string(perDay)});
+  }
+  return rc;
+}
@@ -0,0 +1,108 @@
+// Token → user lookup: the old two-map path against TokenTable.
+//
+//   token_bench [users=100000] [lookups=2000000] [threads=4]
+//
+// Both sides start from the Authorization header string and end at the
+// user's data, as an authenticated request does:
+//   maps   substr() the token into a std::string, then tokenToName and
+//          usersByName (std::map) under a shared_mutex, as before;
+//   table  a string_view of the token, TokenTable::find, then the handle's
+//          published version, under an epoch pin.
+// Every user has one token; lookups pick users at random.
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "core/Epoch.hpp"
+#include "core/TokenTable.hpp"
+#include "core/UserVersion.hpp"
+
+static std::string makeToken(std::mt19937_64& rng) {
+  static const char chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  std::string token(TokenTable::kTokenLength, '0');
+  for (char& c : token) c = chars[rng() % (sizeof(chars) - 1)];
+  return token;
+}
+
+// Runs `lookups` calls of `fn(header)` over `threads` threads; ns per lookup.
+template <typename F>
+static double timeLookups(const std::vector<std::string>& headers, std::size_t lookups, std::size_t threads, F fn) {
+  std::atomic<std::size_t> found{0};
+  bench::Stopwatch sw;
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t] {
+      std::mt19937_64 rng(t + 1);
+      std::size_t hits = 0;
+      for (std::size_t i = 0; i < lookups / threads; ++i) hits += fn(headers[rng() % headers.size()]) ? 1 : 0;
+      found += hits;
+    });
+  }
+  for (auto& th : pool) th.join();
+  const double ms = sw.ms();
+  if (found != lookups / threads * threads) std::printf("  (only %zu of %zu lookups found their user)\n", found.load(), lookups);
+  return ms * 1e6 / static_cast<double>(lookups);
+}
+
+int main(int argc, char** argv) {
+  const std::size_t users = argc > 1 ? std::stoul(argv[1]) : 100000;
+  const std::size_t lookups = argc > 2 ? std::stoul(argv[2]) : 2000000;
+  const std::size_t threads = std::max<std::size_t>(1, argc > 3 ? std::stoul(argv[3]) : 4);
+
+  std::mt19937_64 rng(42);
+  std::vector<std::string> headers;
+  std::map<std::string, std::string> tokenToName;
+  std::map<std::string, UserData> usersByName;
+  std::vector<std::unique_ptr<UserHandle>> handles;
+  TokenTable table;
+  for (std::size_t i = 0; i < users; ++i) {
+    const std::string name = "user" + std::to_string(i);
+    const std::string token = makeToken(rng);
+    headers.push_back("Bearer " + token);
+
+    UserData u;
+    u.profile.name = name;
+    u.waters.push_back({bench::isoDate(0, 0), 250.0});
+    handles.push_back(std::make_unique<UserHandle>(name));
+    handles.back()->published.store(makeUserVersion(u).release());
+    usersByName.emplace(name, std::move(u));
+    tokenToName.emplace(token, name);
+    table.insert(token, handles.back().get());
+  }
+  std::shared_mutex mtx;
+
+  std::printf("%zu users, %zu lookups on %zu thread(s); table capacity %zu\n", users, lookups, threads,
+              table.capacity());
+  for (std::size_t n : {std::size_t{1}, threads}) {
+    const double maps = timeLookups(headers, lookups, n, [&](const std::string& header) {
+      const std::string token = header.substr(7);
+      std::shared_lock<std::shared_mutex> lk(mtx);
+      auto itTok = tokenToName.find(token);
+      if (itTok == tokenToName.end()) return false;
+      auto itUser = usersByName.find(itTok->second);
+      return itUser != usersByName.end() && !itUser->second.waters.empty();
+    });
+    const double tokens = timeLookups(headers, lookups, n, [&](const std::string& header) {
+      const std::string_view token = std::string_view(header).substr(7);
+      EpochDomain::Guard pin;
+      const UserHandle* handle = table.find(token);
+      if (!handle) return false;
+      const UserVersion* v = handle->published.load(std::memory_order_acquire);
+      return v && !v->waters.empty();
+    });
+    std::printf("%zu thread(s): maps %7.1f ns/lookup   table %7.1f ns/lookup   %.1fx\n", n, maps, tokens,
+                maps / tokens);
+    if (threads == 1) break;
+  }
+
+  for (auto& h : handles) delete h->published.load();
+  return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "Records.hpp"
+
+// ----------------------
+// Hot / cold tiering
+// ----------------------
+//
+// Records older than STORAGE_ARCHIVE_DAYS leave memory, the snapshots and
+// the journal's replay in batches. Each batch becomes a segment: one
+// immutable file holding the records in time order, compressed like
+// *.json.gz snapshots (SnapshotCodec.hpp), at Storage::segmentPathFor. The
+// user keeps only its descriptor (Segment, Records.hpp), so memory and the
+// bytes every snapshot rewrites follow the recent window, not the history.
+//
+// List queries read the segments their time range reaches and merge them
+// with the in-memory list (HealthBackend::queryWater ...), through a cache of
+// parsed segments (SegmentCache.hpp). Updating or deleting an archived
+// record first restores its segment into memory ("restore" op); the file
+// stays until a snapshot covers that op.
+//
+// A segment file is written and fsynced before the "archive" journal op
+// that moves its records out (UserOps.hpp), so a crash in between leaves a
+// file no one refers to, never a record in neither place.
+
+struct ArchivePolicy {
+  std::int64_t ageMs = 0;        // 0: tiering is off
+  std::size_t minRecords = 256;  // a collection is archived once it has this many old records
+
+  // STORAGE_ARCHIVE_DAYS (default 0: off) and STORAGE_ARCHIVE_BATCH (default 256).
+  static ArchivePolicy fromEnv();
+
+  bool enabled() const { return ageMs > 0; }
+  // Records before this time (now - ageMs) are old.
+  std::int64_t cutoff() const;
+};
+
+// A segment file's body: a JSON array of the records (toJson), oldest
+// first. Both return false on any error; readSegment then leaves `out`
+// empty.
+template <typename Rec>
+bool writeSegment(std::ostream& out, const std::vector<const Rec*>& records);
+template <typename Rec>
+bool readSegment(const std::string& path, std::vector<Rec>& out);
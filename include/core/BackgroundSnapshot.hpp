@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// BGSAVE-style snapshots: fork() gives the child a copy-on-write image of the
+// whole process, the child serializes it at leisure, and the parent keeps
+// serving requests. Only the fork itself runs on the caller's thread.
+class BackgroundSnapshot {
+ public:
+  enum class State { Idle, Running, Succeeded, Failed };
+
+  struct Status {
+    State state = State::Idle;
+    pid_t pid = 0;
+    std::uint64_t journalSeq = 0;  // seq the running / last snapshot covers
+    std::size_t usersTotal = 0;
+    std::size_t usersWritten = 0;
+    std::int64_t startedAtMs = 0;  // unix epoch millis
+    std::int64_t finishedAtMs = 0;
+    std::int64_t lastSuccessAtMs = 0;
+    std::uint64_t lastSuccessSeq = 0;
+    std::string lastError;
+  };
+
+  // Reports (written, total) from inside the child.
+  using Progress = std::function<void(std::size_t, std::size_t)>;
+  // Runs in the child; must not take locks other threads may hold (no Logger).
+  using Writer = std::function<bool(const Progress&)>;
+  // Runs in the parent's monitor thread once the child has exited.
+  using OnFinish = std::function<void(bool ok)>;
+
+  BackgroundSnapshot() = default;
+  ~BackgroundSnapshot();
+
+  BackgroundSnapshot(const BackgroundSnapshot&) = delete;
+  BackgroundSnapshot& operator=(const BackgroundSnapshot&) = delete;
+
+  // Fork and run `write` in the child. Returns false if a snapshot is
+  // already running or fork() failed.
+  bool start(std::uint64_t journalSeq, Writer write, OnFinish onFinish);
+
+  bool running() const;
+  Status status() const;
+
+  // Block until the running snapshot (if any) has finished.
+  void wait();
+
+  static const char* stateName(State s);
+
+ private:
+  mutable std::mutex mtx_;
+  Status status_;
+  std::thread monitor_;
+
+  void monitor(int progressFd, pid_t pid, OnFinish onFinish);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Epoch-based reclamation for objects that readers reach through an atomic
+// pointer without taking a lock (published user versions, UserVersion.hpp).
+//
+// A reader pins the domain for as long as it dereferences such a pointer. A
+// writer swaps the pointer, then retires the old object: it is freed once
+// every reader that was pinned at that point has unpinned. Pinning is two
+// atomic stores; only retire() takes a mutex.
+//
+//   {
+//     EpochDomain::Guard pin;
+//     const T* p = slot.load();
+//     ... use *p ...
+//   }
+//   const T* old = slot.exchange(fresh);
+//   EpochDomain::global().retire([old] { delete old; });
+class EpochDomain {
+ public:
+  // The process-wide domain (never destroyed, so threads may unpin at exit).
+  static EpochDomain& global();
+
+  // Pins the calling thread in the global domain while alive. Nests.
+  class Guard {
+   public:
+    Guard();
+    ~Guard();
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+  };
+
+  // Run `free` once no reader pinned before this call is still pinned. The
+  // caller has already unlinked the object, so later readers cannot reach it.
+  void retire(std::function<void()> free);
+
+  // Free whatever has become safe to free; returns how many were freed.
+  std::size_t collect();
+
+  struct Stats {
+    std::uint64_t epoch = 0;
+    std::size_t pending = 0;  // retired, not freed yet
+    std::uint64_t freed = 0;
+  };
+  Stats stats() const;
+
+  // One per thread that has ever pinned; handed back when the thread exits.
+  struct Reader {
+    std::atomic<std::uint64_t> epoch{0};  // 0: not pinned
+    std::atomic<bool> inUse{false};
+    Reader* next = nullptr;
+    int depth = 0;  // owner thread only
+  };
+
+ private:
+  EpochDomain() = default;
+
+  struct Retired {
+    std::uint64_t epoch;  // freeable once every pinned reader is past this
+    std::function<void()> free;
+  };
+
+  std::atomic<std::uint64_t> epoch_{1};
+  std::atomic<Reader*> readers_{nullptr};  // push-only list
+
+  mutable std::mutex retiredMtx_;
+  std::vector<Retired> retired_;
+  std::uint64_t freed_ = 0;
+
+  Reader* acquireReader();
+  void pin();
+  void unpin();
+  std::uint64_t oldestPinned() const;
+  // Moves the freeable entries to `ready`; caller holds retiredMtx_.
+  void takeFreeable(std::vector<std::function<void()>>& ready);
+};
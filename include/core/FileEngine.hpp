@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+#include "Storage.hpp"
+#include "StorageEngine.hpp"
+
+// StorageEngine over Storage: every user in memory, each write applied to it
+// and appended to the write-ahead journal, checkpoint() writes the snapshot
+// and trims the journal. The snapshot path and layout pick the variant (JSON
+// or binary, one file or one file per user); see makeStorageEngine.
+//
+// This is what HealthBackend does minus its request-side extras (user cache,
+// warm-up, forked snapshots), which makes it the baseline other engines are
+// measured against.
+class FileEngine : public StorageEngine {
+ public:
+  FileEngine(std::string name, const std::string& path, Storage::Layout layout = Storage::Layout::Single);
+  ~FileEngine() override;
+
+  std::string name() const override { return name_; }
+  bool open() override;
+
+  bool createUser(const UserData& user) override;
+  bool putRecord(const std::string& user, const RecordRef& ref, const nlohmann::json& record) override;
+  bool deleteRecord(const std::string& user, const RecordRef& ref) override;
+  bool createCategory(const std::string& user, const std::string& category) override;
+  bool dropCategory(const std::string& user, const std::string& category) override;
+
+  bool loadUser(const std::string& user, UserData& out) const override;
+  void forEachUser(const std::function<void(const UserData&)>& fn) const override;
+
+  bool checkpoint() override;
+  Stats stats() const override;
+
+ private:
+  std::string name_;
+  std::unique_ptr<Storage> storage_;
+
+  // Shared for reads; exclusive for writes, which also keeps the journal in
+  // the order the writes were applied.
+  mutable std::shared_mutex mtx_;
+  UserMap users_;
+  std::atomic<std::uint64_t> writes_{0};
+  std::atomic<std::uint64_t> checkpoints_{0};
+
+  // Apply `op` to `user` and journal it.
+  bool commit(const std::string& user, nlohmann::json op);
+  void replayEntry(const nlohmann::json& entry);
+  static nlohmann::json recordOp(const char* kind, const RecordRef& ref);
+};
@@ -1,65 +1,37 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
 
 class Storage;
 #include <string>
+#include <string_view>
 #include <vector>
 
-// ----------------------
-// 基本資料結構
-// ----------------------
-
-struct UserProfile {
-  std::string id;
-  std::string name;
-  int age = 0;
-  double weightKg = 0.0;
-  double heightM = 0.0;
-  std::string gender;
-};
-
-// This is added also to meet the requirement of BINGO!!!!
-inline std::string operator+(const std::string& lhs, const UserProfile& p) {
-  return lhs + "{ID:" + p.id + ", Name:" + p.name + ", Age:" + std::to_string(p.age) + "}";
-}
-
-struct WaterRecord {
-  std::string datetime;
-  double amountMl = 0.0;
-};
-
-struct SleepRecord {
-  std::string datetime;
-  double hours = 0.0;
-};
-
-struct ActivityRecord {
-  std::string datetime;
-  int minutes = 0;
-  std::string intensity;
-};
-
-struct CategoryItem {
-  std::string datetime;
-  std::string note;
-  double value = 0.0;
-};
+#include "../../third_party/json.hpp"
+#include "Archive.hpp"
+#include "BackgroundSnapshot.hpp"
+#include "Epoch.hpp"
+#include "Journal.hpp"
+#include "RecordSchema.hpp"
+#include "Records.hpp"
+#include "SegmentCache.hpp"
+#include "ShardExecutor.hpp"
+#include "TokenTable.hpp"
+#include "UserCache.hpp"
+#include "UserVersion.hpp"
 
 class HealthBackend {
  public:
-  struct UserData {
-    UserProfile profile;
-    std::string password;
-
-    std::vector<WaterRecord> waters;
-    std::vector<SleepRecord> sleeps;
-    std::vector<ActivityRecord> activities;
-
-    // categoryName → items
-    std::map<std::string, std::vector<CategoryItem>> categories;
-  };
+  using UserData = ::UserData;
 
   HealthBackend();
   ~HealthBackend();
@@ -69,60 +41,372 @@ class HealthBackend {
                     const std::string& gender);
   std::string login(const std::string& name, const std::string& password);
 
-  bool getUserProfile(const std::string& token, UserProfile& outProfile) const;
-  double getBMI(const std::string& token) const;
+  bool getUserProfile(std::string_view token, UserProfile& outProfile) const;
+  double getBMI(std::string_view token) const;
+
+  bool hasUserForToken(std::string_view token) const;
 
-  bool hasUserForToken(const std::string& token) const;
+  // Borrowed read: calls fn(const UserVersion&) with the user's published
+  // version and returns true, or returns false for an unknown token. fn
+  // reads the profile, lists and category names in place; nothing is
+  // copied and no lock is held. The version cannot change or be freed until
+  // fn returns, so several reads inside fn agree with each other. Views
+  // taken from it must not outlive the call.
+  template <typename Fn>
+  bool readUser(std::string_view token, Fn&& fn) const {
+    PinnedVersion user(*this, token);
+    if (!user) return false;
+    fn(*user);
+    return true;
+  }
+
+  // Records are addressed by their stable id (RecordSet in Records.hpp).
+  // add* return the new record's id, 0 if it was not added; the record
+  // itself is what was passed in. getAll* return the published list itself
+  // (RecordList is shared, not copied), which stays valid while it is held.
+  // update* and delete* also reach archived records (see Tiering below).
+
+  // -------- Any top-level collection (RecordSchemas, RecordSchema.hpp) --------
+  // `rec` must be within the schema's bounds (validRecord) for add and
+  // update alike, or nothing changes; its id is ignored. Instantiated for
+  // each schema in RecordSchemas.
+  template <typename Schema>
+  std::uint64_t addRecord(std::string_view token, typename Schema::Record rec);
+  template <typename Schema>
+  RecordList<typename Schema::Record> getRecords(std::string_view token) const;
+  template <typename Schema>
+  bool updateRecord(std::string_view token, std::uint64_t id, typename Schema::Record rec);
+  template <typename Schema>
+  bool deleteRecord(std::string_view token, std::uint64_t id);
+  // The record with this id, in memory or archived; nullopt if there is none.
+  template <typename Schema>
+  std::optional<typename Schema::Record> findRecord(std::string_view token, std::uint64_t id) const;
+  // See queryWater below.
+  template <typename Schema>
+  std::vector<RecordList<typename Schema::Record>> queryRecords(std::string_view token, const RecordQuery& q) const;
+
+  // The same, by type.
 
   // -------- Water --------
-  bool addWater(const std::string& token, const std::string& datetime, double amountMl);
-  std::vector<WaterRecord> getAllWater(const std::string& token) const;
-  bool updateWater(const std::string& token, std::size_t index, const std::string& newDatetime, double newAmountMl);
-  bool deleteWater(const std::string& token, std::size_t index);
+  std::uint64_t addWater(std::string_view token, std::string_view datetime, double amountMl);
+  RecordList<WaterRecord> getAllWater(std::string_view token) const;
+  bool updateWater(std::string_view token, std::uint64_t id, std::string_view newDatetime, double newAmountMl);
+  bool deleteWater(std::string_view token, std::uint64_t id);
 
   // -------- Sleep --------
-  bool addSleep(const std::string& token, const std::string& datetime, double hours);
-  std::vector<SleepRecord> getAllSleep(const std::string& token) const;
-  bool updateSleep(const std::string& token, std::size_t index, const std::string& newDatetime, double newHours);
-  bool deleteSleep(const std::string& token, std::size_t index);
+  std::uint64_t addSleep(std::string_view token, std::string_view datetime, double hours);
+  RecordList<SleepRecord> getAllSleep(std::string_view token) const;
+  bool updateSleep(std::string_view token, std::uint64_t id, std::string_view newDatetime, double newHours);
+  bool deleteSleep(std::string_view token, std::uint64_t id);
 
   // -------- Activity --------
-  bool addActivity(const std::string& token, const std::string& datetime, int minutes, const std::string& intensity);
-  std::vector<ActivityRecord> getAllActivity(const std::string& token) const;
-  bool updateActivity(const std::string& token, std::size_t index, const std::string& newDatetime, int newMinutes,
-                      const std::string& newIntensity);
-  bool deleteActivity(const std::string& token, std::size_t index);
+  std::uint64_t addActivity(std::string_view token, std::string_view datetime, int minutes,
+                            std::string_view intensity);
+  RecordList<ActivityRecord> getAllActivity(std::string_view token) const;
+  bool updateActivity(std::string_view token, std::uint64_t id, std::string_view newDatetime, int newMinutes,
+                      std::string_view newIntensity);
+  bool deleteActivity(std::string_view token, std::uint64_t id);
 
   // -------- Custom Categories --------
-  std::vector<std::string> getOtherCategories(const std::string& token) const;
+  std::vector<std::string> getOtherCategories(std::string_view token) const;
+
+  bool createCategory(std::string_view token, std::string_view name);
 
-  bool createCategory(const std::string& token, const std::string& name);
+  std::uint64_t addOtherRecord(std::string_view token, std::string_view categoryName, std::string_view datetime,
+                               double value, std::string_view note);
+
+  RecordList<CategoryItem> getOtherRecords(std::string_view token, std::string_view categoryName) const;
+
+  bool updateOtherRecord(std::string_view token, std::string_view categoryName, std::uint64_t id,
+                         std::string_view newDatetime, double newValue, std::string_view newNote);
+
+  bool deleteOtherRecord(std::string_view token, std::string_view categoryName, std::uint64_t id);
+
+  // As findRecord.
+  std::optional<CategoryItem> findOtherRecord(std::string_view token, std::string_view categoryName,
+                                              std::uint64_t id) const;
+
+  bool deleteCategory(std::string_view token, std::string_view categoryName);
+
+  // -------- Tiering (Archive.hpp) --------
+  // A list query across tiers: the published list, then one list per
+  // archived segment of the collection that can hold records in
+  // [q.from, q.to) after q's cursor, read from disk once and then kept in
+  // the segment cache (STORAGE_ARCHIVE_CACHE_BYTES). No id is in two of
+  // them. Empty for an unknown token (or category). getAll* above return
+  // the published list only: the records still in memory.
+  //
+  // Updating or deleting an archived record first restores its segment:
+  // the segment's records move back into memory (a "restore" journal op)
+  // and are cut into a new segment by a later archive pass. The old file is
+  // removed once a snapshot covers the restore, as are the files of a
+  // dropped category.
+  std::vector<RecordList<WaterRecord>> queryWater(std::string_view token, const RecordQuery& q) const;
+  std::vector<RecordList<SleepRecord>> querySleep(std::string_view token, const RecordQuery& q) const;
+  std::vector<RecordList<ActivityRecord>> queryActivity(std::string_view token, const RecordQuery& q) const;
+  std::vector<RecordList<CategoryItem>> queryOtherRecords(std::string_view token, std::string_view categoryName,
+                                                          const RecordQuery& q) const;
+  // The category's records, in memory and archived; 0 if there is no such category.
+  std::size_t countOtherRecords(std::string_view token, std::string_view categoryName) const;
+
+  // Archive every resident user's old records now, however few
+  // (STORAGE_ARCHIVE_BATCH only paces the automatic cuts). Returns the
+  // number of segments written; 0 when tiering is off.
+  std::size_t archiveNow();
+  struct ArchiveStats {
+    std::int64_t ageMs = 0;  // STORAGE_ARCHIVE_DAYS; 0 when off
+    std::size_t minRecords = 0;
+    std::uint64_t segmentsWritten = 0;  // since startup
+    std::uint64_t recordsArchived = 0;
+    std::uint64_t segmentReads = 0;
+    std::uint64_t segmentReadErrors = 0;  // missing or unreadable files, skipped
+    std::uint64_t segmentsRestored = 0;
+    SegmentCache::Stats cache;
+  };
+  ArchiveStats archiveStats() const;
 
-  bool addOtherRecord(const std::string& token, const std::string& categoryName, const std::string& datetime,
-                      double value, const std::string& note);
+  // -------- Persistence --------
+  // Journal group-commit counters and flush lag.
+  Journal::Stats persistenceStats() const;
+  std::string durabilityMode() const;
+  // "single" | "sharded" (STORAGE_LAYOUT) and users changed since their last save.
+  std::string storageLayout() const;
+  std::size_t dirtyUsers() const;
+  // Resident-user cache (STORAGE_CACHE_BYTES): budget, usage and hit / miss / eviction counters.
+  UserCache::Stats cacheStats() const;
 
-  std::vector<CategoryItem> getOtherRecords(const std::string& token, const std::string& categoryName) const;
+  // -------- Memory --------
+  // What the resident users hold, per collection (UserFootprint in
+  // UserVersion.hpp), summed over all of them, plus the `limit` largest
+  // users, biggest first. Writers wait while it is taken.
+  struct MemoryReport {
+    std::size_t users = 0;
+    std::size_t bytes = 0;  // everything, all users
+    CollectionFootprint waters, sleeps, activities, categories;
+    std::vector<UserFootprint> largest;
+  };
+  MemoryReport memoryReport(std::size_t limit) const;
 
-  bool updateOtherRecord(const std::string& token, const std::string& categoryName, std::size_t index,
-                         const std::string& newDatetime, double newValue, const std::string& newNote);
+  // -------- Execution --------
+  // "locked" (default) or "shard-per-core" (EXECUTOR_SHARDS); one entry per
+  // shard thread, empty when locked.
+  std::string executionMode() const;
+  std::vector<ShardExecutor::ShardStats> executorStats() const;
 
-  bool deleteOtherRecord(const std::string& token, const std::string& categoryName, std::size_t index);
+  // -------- Startup warm-up --------
+  // STORAGE_WARMUP=background returns from the constructor before the data is
+  // loaded, so the server can listen at once; see README "Startup".
+  struct WarmupStatus {
+    bool ready = false;
+    std::string mode;             // "blocking" | "background"
+    std::size_t usersLoaded = 0;  // shards loaded by the warm-up threads so far
+    std::size_t usersTotal = 0;   // shards to load (0 while a whole-file load runs)
+    std::int64_t elapsedMs = 0;   // since startup; stops once ready
+  };
+  WarmupStatus warmupStatus() const;
 
-  bool deleteCategory(const std::string& token, const std::string& categoryName);
+  // Fork a child that writes a full snapshot while we keep serving; the
+  // journal it covers is dropped once the snapshot is renamed into place.
+  // Returns false if one is already running.
+  bool startBackgroundSnapshot();
+  BackgroundSnapshot::Status snapshotStatus() const;
 
  private:
-  std::map<std::string, UserData> usersByName;
-  std::map<std::string, std::string> tokenToName;
+  // Resident users: everyone, unless the cache is bounded over sharded
+  // storage, in which case cold users are paged out to their shard and back
+  // in on the next lookup (hence mutable: a const lookup may page in).
+  mutable std::map<std::string, UserData> usersByName;
+  // Session tokens → user handles (lock-free lookups, see TokenTable.hpp).
+  TokenTable tokens_;
+  // Every user that has been resident, by name; UserData::handle points
+  // here. Entries are added under usersMtx_ (exclusive) and never removed.
+  mutable std::map<std::string, std::unique_ptr<UserHandle>> handles_;
+
+  // Concurrency model (httplib runs handlers on a thread pool):
+  //   usersMtx_     the user directory. Held shared by every operation while
+  //                 it uses a UserData, exclusively to insert or evict users,
+  //                 so a looked-up user never dangles.
+  //   userStripes_  one of kUserStripes locks per user, by name hash, held
+  //                 exclusively to change the user's records, so writes to
+  //                 different users rarely contend.
+  //   snapshotGate_ see below.
+  // Reads take no lock at all once a user is published: token → handle →
+  // version (UserVersion.hpp), which every commit replaces; see PinnedVersion.
+  // Lock order: usersMtx_, user stripe, snapshotGate_.
+  //
+  // With EXECUTOR_SHARDS set, users are hash-partitioned over shard threads
+  // instead, and a user's writes all run on the shard that owns it (see
+  // withUser), so the stripes are not used: there is only ever one thread
+  // touching a user's records.
+  mutable std::shared_mutex usersMtx_;
+  static constexpr std::size_t kUserStripes = 64;
+  mutable std::shared_mutex userStripes_[kUserStripes];
+  std::unique_ptr<ShardExecutor> executor_;
+  // The user's stripe; nullptr in shard-per-core mode.
+  std::shared_mutex* stripeFor(const std::string& name) const;
+  mutable UserCache cache_;
+  bool lazy_ = false;  // sharded layout + bounded cache or background warm-up: users load on first access
+  mutable std::atomic<std::uint64_t> evictGen_{0};  // bumped per eviction (a shard may have been rewritten)
+
+  // Background warm-up. With lazy_ set, lookups page users in on demand
+  // (and warmers back off while they do); otherwise the whole load runs on
+  // one thread and lookups wait for ready_.
+  bool background_ = false;
+  bool lookupsWait_ = false;
+  std::chrono::steady_clock::time_point startedAt_ = std::chrono::steady_clock::now();
+  std::atomic<std::int64_t> readyAfterMs_{-1};
+  std::atomic<bool> ready_{false};
+  std::atomic<bool> stopWarmup_{false};
+  mutable std::atomic<int> demand_{0};  // on-demand loads in flight
+  std::vector<std::string> warmFiles_;
+  std::atomic<std::size_t> warmNext_{0};
+  std::atomic<std::size_t> warmLoaded_{0};
+  std::atomic<std::size_t> warmersLeft_{0};
+  std::vector<std::thread> warmers_;
+  mutable std::mutex readyMtx_;
+  mutable std::condition_variable readyCv_;
+
+  // A user's published version, pinned in the EpochDomain for as long as
+  // this lives, so no writer can free it; no lock is held. The first read
+  // of a user (and the first after it was paged back in) publishes its
+  // version through the write path.
+  class PinnedVersion {
+   public:
+    PinnedVersion(const HealthBackend& backend, std::string_view token);
+    explicit operator bool() const { return version_ != nullptr; }
+    const UserVersion* operator->() const { return version_; }
+    const UserVersion& operator*() const { return *version_; }
+
+   private:
+    EpochDomain::Guard pin_;
+    const UserVersion* version_ = nullptr;
+  };
+
+  // A resident user together with the hold on usersMtx_ that keeps it
+  // resident (shared on a hit, exclusive when the lookup just paged it in)
+  // and its stripe, if any: shared for a const user, exclusive for a
+  // mutable one. The stripe is declared last so it is released first.
+  template <typename T>
+  class UserRef {
+   public:
+    UserRef() = default;
+    UserRef(std::shared_lock<std::shared_mutex> lock, std::shared_mutex* stripe, T* user)
+        : shared_(std::move(lock)), user_(user) {
+      if (stripe) lockStripe(*stripe);
+    }
+    UserRef(std::unique_lock<std::shared_mutex> lock, std::shared_mutex* stripe, T* user)
+        : exclusive_(std::move(lock)), user_(user) {
+      if (stripe) lockStripe(*stripe);
+    }
+    explicit operator bool() const { return user_ != nullptr; }
+    T* operator->() const { return user_; }
+    T& operator*() const { return *user_; }
+
+   private:
+    std::shared_lock<std::shared_mutex> shared_;
+    std::unique_lock<std::shared_mutex> exclusive_;
+    T* user_ = nullptr;
+    std::shared_lock<std::shared_mutex> stripeShared_;
+    std::unique_lock<std::shared_mutex> stripeExclusive_;
+
+    void lockStripe(std::shared_mutex& stripe) {
+      if constexpr (std::is_const_v<T>) {
+        stripeShared_ = std::shared_lock<std::shared_mutex>(stripe);
+      } else {
+        stripeExclusive_ = std::unique_lock<std::shared_mutex>(stripe);
+      }
+    }
+  };
 
   // Storage manages persistence to disk
   std::unique_ptr<Storage> storage_;
 
-  // JSON I/O
+  // Tiering: when a collection's old records are cut into a segment.
+  ArchivePolicy archive_ = ArchivePolicy::fromEnv();
+  std::atomic<std::uint64_t> segmentsWritten_{0};
+  std::atomic<std::uint64_t> recordsArchived_{0};
+  mutable std::atomic<std::uint64_t> segmentReads_{0};
+  mutable std::atomic<std::uint64_t> segmentReadErrors_{0};
+  std::atomic<std::uint64_t> segmentsRestored_{0};
+  mutable SegmentCache segmentCache_{SegmentCache::budgetFromEnv()};
+  // Files of segments no user refers to any more, removed once a snapshot
+  // covers the journal entry that let go of them (`seq`): until then a
+  // replay after a crash may bring the segment back.
+  struct RetiredSegment {
+    std::string user;
+    Segment segment;
+    std::uint64_t seq;
+  };
+  std::mutex retiredMtx_;
+  std::vector<RetiredSegment> retired_;
+  // Cut a segment of the collection's old records if there are at least
+  // `minRecords`; caller is the user's writer. True if one was written.
+  bool archiveCollection(UserData& user, const std::string& coll, const std::string& category,
+                         std::size_t minRecords);
+  template <typename Rec>
+  bool archiveRecords(UserData& user, const RecordSet<Rec>& records, const std::string& coll,
+                      const std::string& category, std::size_t minRecords);
+  template <typename T>
+  std::vector<RecordList<T>> withArchived(const UserVersion& user, RecordList<T> published, std::string_view coll,
+                                          std::string_view category, const RecordQuery& q) const;
+  // A segment's records, from the cache or its file; nullopt if unreadable.
+  template <typename T>
+  std::optional<RecordList<T>> segmentList(const std::string& user, const Segment& seg) const;
+  template <typename Schema>
+  std::optional<typename Schema::Record> findInTiers(const UserVersion& user,
+                                                     const RecordList<typename Schema::Record>& published,
+                                                     std::string_view category, std::uint64_t id) const;
+  // Caller is the user's writer: commit a "restore" of the segment of the
+  // collection that holds `id`. False if none does (or it failed).
+  template <typename Schema>
+  bool restoreArchived(UserData& user, const std::string& category, std::uint64_t id);
+  // Queue the files of those `segments` the user no longer has.
+  void retireSegments(const UserData& user, const std::vector<Segment>& segments);
+  // Remove the queued files whose release is covered by a snapshot at `seq`.
+  void removeRetiredSegments(std::uint64_t seq);
+
+  // Held shared by every mutation, exclusively while sealing + forking a
+  // snapshot, so the child sees no half-applied change.
+  mutable std::shared_mutex snapshotGate_;
+  BackgroundSnapshot snapshotter_;
+
+  // JSON I/O: snapshot + write-ahead journal
   void loadFromFile();
-  void saveToFile() const;
+  void startWarmup();
+  void warmShards();
+  void markReady();
+  void waitReady() const;
+  void saveToFile();
+  bool startBackgroundSnapshotLocked();
+  // Clear the dirty bit of every user whose changes are all <= seq.
+  void markPersisted(std::uint64_t seq);
+
+  // Apply a journal op ({"op","coll",...}) to one user; shared by requests and replay.
+  bool applyOp(UserData& user, const nlohmann::json& op);
+  // applyOp + publish + append to the journal.
+  bool commit(UserData& user, nlohmann::json op);
+  // Commit an "add" op under the user's next record id; returns it, 0 on failure.
+  std::uint64_t commitAdd(std::string_view token, nlohmann::json op);
+  // Replace the user's published version after `op` (if it has one yet).
+  void publish(UserData& user, const nlohmann::json& op);
+  // Unpublish before a user leaves memory; freed once no reader holds it.
+  void retireVersion(UserData& user) const;
+  std::uint64_t logMutation(nlohmann::json op);
+  void replayEntry(const nlohmann::json& entry);
+
+  // Cache：page users in / out (caller holds usersMtx_ exclusively)
+  void admitUser(const std::string& name, UserData data, bool miss) const;
+  UserHandle* handleFor(const std::string& name) const;
+  bool pageIn(const std::string& name) const;
+  UserData* loadOnDemand(const std::string& name, std::unique_lock<std::shared_mutex>& ex) const;
+  void evictColdUsers() const;
 
   // Token / 使用者
   std::string generateToken() const;
-  UserData* getUserByToken(const std::string& token);
-  const UserData* getUserByToken(const std::string& token) const;
+  template <typename T>
+  UserRef<T> acquireUser(std::string_view token) const;
+  // Run fn(UserData&) → bool as the user's only writer: under its stripe, or
+  // on the shard that owns it. False if the token is unknown.
+  template <typename F>
+  bool withUser(std::string_view token, F&& fn) const;
 };
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../third_party/json.hpp"
+
+// Append-only write-ahead journal.
+//
+// Every mutation is written as one compact JSON line tagged with a
+// monotonically increasing sequence number. On startup the journal is
+// replayed on top of the last snapshot; a checkpoint writes a new snapshot
+// and then truncates the journal.
+//
+// A background snapshot first seals the journal: the live file is moved to
+// <path>.1 and a fresh one is started, so the entries the snapshot covers can
+// be dropped as a unit once it is safely on disk.
+//
+// Writes are group-committed: request threads only queue their line, and a
+// background flusher writes everything queued so far with a single write()
+// and a single fsync.
+class Journal {
+ public:
+  enum class Durability {
+    Sync,   // append() returns once the batch holding the entry is fsynced
+    Async,  // append() returns at once; the flusher fsyncs every flush interval
+    None,   // never fsync; the OS decides when data hits the disk (benchmarks)
+  };
+
+  // "sync" | "async" | "none"; anything else falls back to Async.
+  static Durability parseDurability(const std::string& s);
+  static const char* durabilityName(Durability d);
+
+  struct Stats {
+    std::uint64_t lastSeq = 0;         // highest seq handed out
+    std::uint64_t durableSeq = 0;      // highest seq written (and fsynced unless None)
+    std::uint64_t pendingEntries = 0;  // flush lag, in entries
+    std::uint64_t lagMs = 0;           // age of the oldest entry not yet written
+    std::uint64_t flushes = 0;
+    std::uint64_t maxBatch = 0;        // largest group commit so far, in entries
+    std::uint64_t failedBatches = 0;   // batches whose write or fsync failed
+  };
+
+  explicit Journal(const std::string& path, Durability mode = Durability::Async,
+                   std::chrono::milliseconds flushInterval = std::chrono::milliseconds(10));
+  ~Journal();
+
+  Journal(const Journal&) = delete;
+  Journal& operator=(const Journal&) = delete;
+
+  std::string path() const { return journalPath; }
+  Durability durability() const { return mode_; }
+
+  // Replay every entry with seq > afterSeq, sealed segment first. A torn or
+  // unparsable tail (e.g. from a crash mid-write) ends the replay of that file
+  // and is cut off. Must run before the first append(). Returns the number of
+  // entries applied.
+  std::size_t replay(std::uint64_t afterSeq, const std::function<void(const nlohmann::json&)>& apply);
+
+  // Stamp the entry with the next sequence number and queue it for the
+  // flusher. In Sync mode this blocks until the entry is on disk.
+  // Returns the assigned seq, or 0 in Sync mode if the batch carrying the
+  // entry could not be written (the batch is cut back out of the file).
+  std::uint64_t append(nlohmann::json entry);
+
+  // Drop all entries, including queued ones and the sealed segment (called
+  // once a snapshot covering them is on disk).
+  bool reset();
+
+  // Flush what is queued and move it into the sealed segment; later appends
+  // go to a fresh file. Everything up to lastSeq() is then in the sealed part.
+  bool seal();
+  // Delete the sealed segment once a snapshot covering it is durable.
+  void dropSealed();
+
+  std::uint64_t lastSeq() const;
+  // Make the next append() use a seq > `seq`. Like replay(), call it before
+  // the first append().
+  void advanceSeq(std::uint64_t seq);
+  std::uintmax_t sizeBytes() const;
+  Stats stats() const;
+
+ private:
+  std::string journalPath;
+  std::string sealedPath;
+  Durability mode_;
+  std::chrono::milliseconds flushInterval_;
+  int fd_ = -1;
+
+  mutable std::mutex mtx_;
+  std::condition_variable wake_;     // flusher: work queued / stop
+  std::condition_variable durable_;  // writers: durableSeq_ advanced
+  std::string pending_;
+  std::uint64_t pendingCount_ = 0;
+  std::chrono::steady_clock::time_point oldestPending_;
+  bool writing_ = false;
+  bool stop_ = false;
+
+  std::uint64_t seq_ = 0;
+  std::uint64_t durableSeq_ = 0;
+  std::uintmax_t size_ = 0;
+  std::uint64_t flushes_ = 0;
+  std::uint64_t maxBatch_ = 0;
+  std::uint64_t failedBatches_ = 0;
+
+  // Sync mode: seq ranges of failed batches whose writers have not yet
+  // returned from append().
+  struct FailedBatch {
+    std::uint64_t from;
+    std::uint64_t upTo;
+    std::uint64_t waiters;
+  };
+  std::vector<FailedBatch> failed_;
+
+  std::thread flusher_;
+
+  bool openForAppend();
+  std::size_t replayFile(const std::string& file, std::uint64_t afterSeq, std::uint64_t& maxSeq,
+                         const std::function<void(const nlohmann::json&)>& apply);
+  bool writeAll(const std::string& data);
+  bool writeBatch(const std::string& data);
+  void settleBatch(bool ok, std::uint64_t upTo, std::uint64_t count, std::size_t bytes);
+  std::vector<FailedBatch>::iterator failedBatchOf(std::uint64_t seq);
+  void flusherLoop();
+};
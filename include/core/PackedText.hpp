@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// ----------------------
+// Packed record text
+// ----------------------
+//
+// An owned string in a single heap block: a 4-byte length, then the bytes.
+// A record holds one pointer (8 bytes; std::string is 32) and nothing at all
+// when the text is empty, which is what most records keep for their
+// datetime (see setDatetime in Records.hpp). Text is replaced whole, never
+// edited in place.
+class PackedText {
+ public:
+  PackedText() = default;
+  PackedText(std::string_view s) { assign(s); }  // NOLINT(google-explicit-constructor)
+  PackedText(const std::string& s) : PackedText(std::string_view(s)) {}  // NOLINT(google-explicit-constructor)
+  PackedText(const char* s) : PackedText(std::string_view(s)) {}  // NOLINT(google-explicit-constructor)
+  PackedText(const PackedText& o) { assign(o.view()); }
+  PackedText(PackedText&& o) noexcept : block_(std::exchange(o.block_, nullptr)) {}
+  ~PackedText() { delete[] block_; }
+
+  PackedText& operator=(const PackedText& o) {
+    assign(o.view());
+    return *this;
+  }
+  PackedText& operator=(PackedText&& o) noexcept {
+    std::swap(block_, o.block_);
+    return *this;
+  }
+
+  std::string_view view() const { return block_ ? std::string_view(block_ + kHeader, size()) : std::string_view(); }
+  std::string str() const { return std::string(view()); }
+  std::size_t size() const {
+    if (!block_) return 0;
+    std::uint32_t n;
+    std::memcpy(&n, block_, kHeader);
+    return n;
+  }
+  bool empty() const { return block_ == nullptr; }
+  // Heap bytes held (the block; allocator overhead not included).
+  std::size_t heapBytes() const { return block_ ? kHeader + size() : 0; }
+
+  friend bool operator==(const PackedText& a, std::string_view b) { return a.view() == b; }
+  friend bool operator!=(const PackedText& a, std::string_view b) { return a.view() != b; }
+
+ private:
+  static constexpr std::size_t kHeader = sizeof(std::uint32_t);
+  char* block_ = nullptr;
+
+  // Builds the new block before freeing the old one, so `s` may point into it.
+  void assign(std::string_view s) {
+    char* next = nullptr;
+    if (!s.empty()) {
+      const auto n = static_cast<std::uint32_t>(s.size());
+      next = new char[kHeader + n];
+      std::memcpy(next, &n, kHeader);
+      std::memcpy(next + kHeader, s.data(), n);
+    }
+    delete[] block_;
+    block_ = next;
+  }
+};
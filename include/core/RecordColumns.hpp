@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Records.hpp"
+
+// ----------------------
+// Columnar record storage
+// ----------------------
+//
+// A published record list (RecordList, UserVersion.hpp) keeps each field in
+// its own contiguous array: ids, timestamps, amounts ... one after another,
+// instead of one struct per record with a heap string inside. A sum over a
+// field is then a sequential sweep of that one array, and copying a list on
+// publish is a handful of vector copies rather than one allocation per
+// string.
+//
+// Strings live back to back in one TextArena per list: notes, and the few
+// datetimes whose text is not rebuilt from the time (setDatetime in
+// Records.hpp). Records are read back as small views (WaterView ...) that
+// point into the columns; they are valid while the list is.
+
+// The strings of one list in one buffer.
+class TextArena {
+ public:
+  struct Ref {
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+  };
+
+  Ref add(std::string_view s) {
+    Ref r{static_cast<std::uint32_t>(buf_.size()), static_cast<std::uint32_t>(s.size())};
+    buf_.append(s);
+    return r;
+  }
+  std::string_view get(Ref r) const { return std::string_view(buf_).substr(r.offset, r.length); }
+  void reserve(std::size_t bytes) { buf_.reserve(bytes); }
+  std::size_t bytes() const { return buf_.capacity(); }
+
+ private:
+  std::string buf_;
+};
+
+struct WaterView {
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+  DatetimeText datetime;
+  double amountMl = 0;
+};
+
+struct SleepView {
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+  DatetimeText datetime;
+  double hours = 0;
+};
+
+struct ActivityView {
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+  DatetimeText datetime;
+  int minutes = 0;
+  std::string_view intensity{};
+};
+
+struct CategoryItemView {
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+  DatetimeText datetime;
+  std::string_view note{};
+  double value = 0;
+};
+
+// The columns every record type has. Ids are in increasing order.
+//
+// Datetimes have no column of their own: the text is rebuilt from timeMs
+// (DatetimeText), and only the records whose client text differs from that
+// are listed, by position, in `keptAt` / `keptText`. Usually there are none.
+struct CommonColumns {
+  std::vector<std::uint64_t> id;
+  std::vector<std::int64_t> timeMs;
+  std::vector<std::uint32_t> keptAt;  // positions with a kept datetime text, increasing
+  std::vector<TextArena::Ref> keptText;
+  TextArena text;
+
+  template <typename Rec>
+  void appendCommon(const Rec& r) {
+    if (!r.datetime.empty()) {
+      keptAt.push_back(static_cast<std::uint32_t>(id.size()));
+      keptText.push_back(text.add(r.datetime.view()));
+    }
+    id.push_back(r.id);
+    timeMs.push_back(r.timeMs);
+  }
+  void reserveCommon(std::size_t n, std::size_t textBytes) {
+    id.reserve(n);
+    timeMs.reserve(n);
+    text.reserve(textBytes);
+  }
+  DatetimeText datetimeAt(std::size_t i) const {
+    std::string_view kept;
+    if (!keptAt.empty()) {
+      auto it = std::lower_bound(keptAt.begin(), keptAt.end(), static_cast<std::uint32_t>(i));
+      if (it != keptAt.end() && *it == i) kept = text.get(keptText[static_cast<std::size_t>(it - keptAt.begin())]);
+    }
+    return DatetimeText(timeMs[i], kept);
+  }
+  std::size_t commonBytes() const {
+    return id.capacity() * sizeof(std::uint64_t) + timeMs.capacity() * sizeof(std::int64_t) +
+           keptAt.capacity() * sizeof(std::uint32_t) + keptText.capacity() * sizeof(TextArena::Ref) + text.bytes();
+  }
+};
+
+template <typename Rec>
+struct RecordColumns;
+
+template <>
+struct RecordColumns<WaterRecord> : CommonColumns {
+  using View = WaterView;
+  std::vector<double> amountMl;
+
+  void reserve(std::size_t n, std::size_t textBytes) {
+    reserveCommon(n, textBytes);
+    amountMl.reserve(n);
+  }
+  void append(const WaterRecord& r) {
+    appendCommon(r);
+    amountMl.push_back(r.amountMl);
+  }
+  View row(std::size_t i) const { return {id[i], timeMs[i], datetimeAt(i), amountMl[i]}; }
+  std::size_t bytes() const { return commonBytes() + amountMl.capacity() * sizeof(double); }
+};
+
+template <>
+struct RecordColumns<SleepRecord> : CommonColumns {
+  using View = SleepView;
+  std::vector<double> hours;
+
+  void reserve(std::size_t n, std::size_t textBytes) {
+    reserveCommon(n, textBytes);
+    hours.reserve(n);
+  }
+  void append(const SleepRecord& r) {
+    appendCommon(r);
+    hours.push_back(r.hours);
+  }
+  View row(std::size_t i) const { return {id[i], timeMs[i], datetimeAt(i), hours[i]}; }
+  std::size_t bytes() const { return commonBytes() + hours.capacity() * sizeof(double); }
+};
+
+// Intensities are interned (Symbol), so the column is their 4-byte handles.
+template <>
+struct RecordColumns<ActivityRecord> : CommonColumns {
+  using View = ActivityView;
+  std::vector<std::int32_t> minutes;
+  std::vector<Symbol> intensity;
+
+  void reserve(std::size_t n, std::size_t textBytes) {
+    reserveCommon(n, textBytes);
+    minutes.reserve(n);
+    intensity.reserve(n);
+  }
+  void append(const ActivityRecord& r) {
+    appendCommon(r);
+    minutes.push_back(r.minutes);
+    intensity.push_back(r.intensity);
+  }
+  View row(std::size_t i) const {
+    return {id[i], timeMs[i], datetimeAt(i), minutes[i], intensity[i].view()};
+  }
+  std::size_t bytes() const {
+    return commonBytes() + minutes.capacity() * sizeof(std::int32_t) + intensity.capacity() * sizeof(Symbol);
+  }
+};
+
+template <>
+struct RecordColumns<CategoryItem> : CommonColumns {
+  using View = CategoryItemView;
+  std::vector<TextArena::Ref> note;
+  std::vector<double> value;
+
+  void reserve(std::size_t n, std::size_t textBytes) {
+    reserveCommon(n, textBytes);
+    note.reserve(n);
+    value.reserve(n);
+  }
+  void append(const CategoryItem& r) {
+    appendCommon(r);
+    note.push_back(text.add(r.note.view()));
+    value.push_back(r.value);
+  }
+  View row(std::size_t i) const { return {id[i], timeMs[i], datetimeAt(i), text.get(note[i]), value[i]}; }
+  std::size_t bytes() const {
+    return commonBytes() + note.capacity() * sizeof(TextArena::Ref) + value.capacity() * sizeof(double);
+  }
+};
+
+// Text bytes a record adds to its list's arena (for reserve()).
+inline std::size_t arenaBytes(const WaterRecord& r) { return r.datetime.size(); }
+inline std::size_t arenaBytes(const SleepRecord& r) { return r.datetime.size(); }
+inline std::size_t arenaBytes(const ActivityRecord& r) { return r.datetime.size(); }
+inline std::size_t arenaBytes(const CategoryItem& r) { return r.datetime.size() + r.note.size(); }
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../../third_party/json.hpp"
+#include "Records.hpp"
+#include "UserVersion.hpp"
+
+// ----------------------
+// Record schemas
+// ----------------------
+//
+// Each record type declares its own fields once, in a constexpr table: the
+// JSON key, the member in the record (Records.hpp) and in its view
+// (RecordColumns.hpp), the accepted range, and whether the API exposes it.
+// `id` and `datetime`, which every record has, are not listed. Everything
+// that used to be written out per type is generated from the table:
+//
+//   validRecord                 the range checks add / update apply
+//   recordToJson / FromJson     snapshot and journal JSON (SnapshotJson.hpp)
+//   setRecordNumber / Text      the streaming snapshot loader
+//   applyUserOp, nextUserVersion, HealthBackend::addRecord<Schema> ...
+//                               one collection of UserData per schema
+//   registerRecordRoutes        POST / GET / PATCH / DELETE, with the JSON
+//                               responses written straight from the views
+//                               (routes/RecordRoutes.hpp)
+//
+// The schemas in RecordSchemas are the user's top-level collections and
+// also name where they live (records / published). CategoryItemSchema
+// describes category items, which live in a map per category and keep
+// their hand-written routes. The binary snapshot layout (SnapshotBinary.cpp)
+// and the columns stay per type: both are fixed formats tuned by hand.
+
+// Accepted values of a numeric field: [lo, hi], either end open.
+struct Bounds {
+  double lo = -std::numeric_limits<double>::infinity();
+  double hi = std::numeric_limits<double>::infinity();
+  bool loOpen = false;
+  bool hiOpen = false;
+
+  static constexpr Bounds any() { return Bounds{}; }
+  static constexpr Bounds open(double lo, double hi) { return Bounds{lo, hi, true, true}; }
+  static constexpr Bounds closed(double lo, double hi) { return Bounds{lo, hi, false, false}; }
+  static constexpr Bounds openClosed(double lo, double hi) { return Bounds{lo, hi, true, false}; }
+
+  constexpr bool contains(double v) const { return (loOpen ? v > lo : v >= lo) && (hiOpen ? v < hi : v <= hi); }
+};
+
+// One field: `T Rec::*` holds it in the record, `V View::*` in the view.
+// T is double, int, PackedText or Symbol; V is the same number or a
+// std::string_view.
+template <typename Rec, typename View, typename T, typename V>
+struct Field {
+  using Type = T;
+  static constexpr bool kNumber = std::is_arithmetic_v<T>;
+
+  const char* key;
+  T Rec::*member;
+  V View::*view;
+  Bounds bounds;
+  bool api;  // accepted and returned by the HTTP routes
+
+  std::string_view text(const Rec& r) const {
+    static_assert(!kNumber, "text() is for text fields");
+    return (r.*member).view();
+  }
+};
+
+template <typename Rec, typename View, typename T, typename V>
+constexpr Field<Rec, View, T, V> field(const char* key, T Rec::*member, V View::*view, Bounds bounds = Bounds::any(),
+                                       bool api = true) {
+  return Field<Rec, View, T, V>{key, member, view, bounds, api};
+}
+
+struct WaterSchema {
+  using Record = WaterRecord;
+  using View = WaterView;
+  static constexpr const char* kCollection = "waters";
+  static constexpr const char* kNoun = "water";
+  static constexpr auto kFields =
+      std::make_tuple(field("amountMl", &WaterRecord::amountMl, &WaterView::amountMl, Bounds::open(0, 5000)));
+
+  static RecordSet<Record>& records(UserData& u) { return u.waters; }
+  static const RecordSet<Record>& records(const UserData& u) { return u.waters; }
+  static const RecordList<Record>& published(const UserVersion& v) { return v.waters; }
+  static RecordList<Record>& published(UserVersion& v) { return v.waters; }
+};
+
+struct SleepSchema {
+  using Record = SleepRecord;
+  using View = SleepView;
+  static constexpr const char* kCollection = "sleeps";
+  static constexpr const char* kNoun = "sleep";
+  static constexpr auto kFields =
+      std::make_tuple(field("hours", &SleepRecord::hours, &SleepView::hours, Bounds::closed(0, 24)));
+
+  static RecordSet<Record>& records(UserData& u) { return u.sleeps; }
+  static const RecordSet<Record>& records(const UserData& u) { return u.sleeps; }
+  static const RecordList<Record>& published(const UserVersion& v) { return v.sleeps; }
+  static RecordList<Record>& published(UserVersion& v) { return v.sleeps; }
+};
+
+struct ActivitySchema {
+  using Record = ActivityRecord;
+  using View = ActivityView;
+  static constexpr const char* kCollection = "activities";
+  static constexpr const char* kNoun = "activity";
+  static constexpr auto kFields =
+      std::make_tuple(field("minutes", &ActivityRecord::minutes, &ActivityView::minutes, Bounds::openClosed(0, 1440)),
+                      field("intensity", &ActivityRecord::intensity, &ActivityView::intensity));
+
+  static RecordSet<Record>& records(UserData& u) { return u.activities; }
+  static const RecordSet<Record>& records(const UserData& u) { return u.activities; }
+  static const RecordList<Record>& published(const UserVersion& v) { return v.activities; }
+  static RecordList<Record>& published(UserVersion& v) { return v.activities; }
+};
+
+// Items of one category (UserData::categories). `value` is stored but the
+// routes neither take nor return it.
+struct CategoryItemSchema {
+  using Record = CategoryItem;
+  using View = CategoryItemView;
+  static constexpr const char* kCollection = "categories";
+  static constexpr const char* kNoun = "item";
+  static constexpr auto kFields =
+      std::make_tuple(field("note", &CategoryItem::note, &CategoryItemView::note),
+                      field("value", &CategoryItem::value, &CategoryItemView::value, Bounds::any(), false));
+};
+
+// The top-level collections. A new record type is a record and view struct,
+// its columns, a schema and an entry here.
+using RecordSchemas = std::tuple<WaterSchema, SleepSchema, ActivitySchema>;
+
+// SchemaFor<Rec>: the schema whose Record is Rec, looked up among
+// RecordSchemas and CategoryItemSchema by the schemas' own Record alias.
+template <typename Rec, typename... Schemas>
+struct SchemaWithRecord;
+template <typename Rec, typename First, typename... Rest>
+struct SchemaWithRecord<Rec, First, Rest...>
+    : std::conditional_t<std::is_same_v<typename First::Record, Rec>, SchemaWithRecord<Rec, First>,
+                         SchemaWithRecord<Rec, Rest...>> {};
+template <typename Rec, typename Schema>
+struct SchemaWithRecord<Rec, Schema> {
+  static_assert(std::is_same_v<typename Schema::Record, Rec>, "no schema for this record type");
+  using type = Schema;
+};
+
+template <typename Rec, typename Schemas>
+struct SchemaOf;
+template <typename Rec, typename... Schemas>
+struct SchemaOf<Rec, std::tuple<Schemas...>> : SchemaWithRecord<Rec, Schemas..., CategoryItemSchema> {};
+template <typename Rec>
+using SchemaFor = typename SchemaOf<Rec, RecordSchemas>::type;
+
+// fn(schema) for each of RecordSchemas, in order (a default-constructed
+// schema; only its type matters).
+template <typename Fn>
+void forEachRecordSchema(Fn&& fn) {
+  std::apply([&fn](auto... schema) { (fn(schema), ...); }, RecordSchemas{});
+}
+
+// fn(field) for each field of Schema, in order. Unrolled at compile time.
+template <typename Schema, typename Fn>
+void forEachField(Fn&& fn) {
+  std::apply([&fn](const auto&... f) { (fn(f), ...); }, Schema::kFields);
+}
+
+// ----------------------
+// Generated operations
+// ----------------------
+
+template <typename Schema>
+bool validRecord(const typename Schema::Record& r) {
+  bool ok = true;
+  forEachField<Schema>([&](const auto& f) {
+    if constexpr (std::decay_t<decltype(f)>::kNumber) ok = ok && f.bounds.contains(static_cast<double>(r.*f.member));
+  });
+  return ok;
+}
+
+// A record from its datetime and its fields' values, in table order.
+template <typename Schema, typename... Values>
+typename Schema::Record makeRecord(std::string_view datetime, Values&&... values) {
+  static_assert(sizeof...(Values) == std::tuple_size_v<decltype(Schema::kFields)>, "one value per field");
+  typename Schema::Record r;
+  setDatetime(r, datetime);
+  std::apply([&](const auto&... f) { ((r.*f.member = std::forward<Values>(values)), ...); }, Schema::kFields);
+  return r;
+}
+
+// The record as its view (what a published list yields), for rendering a
+// record that is not in a list. Valid while `r` is.
+template <typename Schema>
+typename Schema::View viewOf(const typename Schema::Record& r) {
+  typename Schema::View v{r.id, r.timeMs, datetimeText(r)};
+  forEachField<Schema>([&](const auto& f) {
+    if constexpr (std::decay_t<decltype(f)>::kNumber) {
+      v.*f.view = r.*f.member;
+    } else {
+      v.*f.view = f.text(r);
+    }
+  });
+  return v;
+}
+
+// The reverse: a record holding the view's values (its id included).
+template <typename Schema>
+typename Schema::Record recordOf(const typename Schema::View& v) {
+  typename Schema::Record r;
+  r.id = v.id;
+  setDatetime(r, v.datetime.view());
+  forEachField<Schema>([&](const auto& f) { r.*f.member = v.*f.view; });
+  return r;
+}
+
+// Snapshot / journal JSON: {"id"?, "datetime", <every field>}. The id is
+// left out while it is 0 (not added yet).
+template <typename Schema>
+nlohmann::json recordToJson(const typename Schema::Record& r) {
+  nlohmann::json j;
+  if (r.id != 0) j["id"] = r.id;
+  j["datetime"] = datetimeText(r).view();
+  forEachField<Schema>([&](const auto& f) {
+    if constexpr (std::decay_t<decltype(f)>::kNumber) {
+      j[f.key] = r.*f.member;
+    } else {
+      j[f.key] = f.text(r);
+    }
+  });
+  return j;
+}
+
+// Missing fields keep their defaults; a number of the wrong type throws
+// (json::type_error), a string of the wrong type reads as "".
+template <typename Schema>
+void recordFromJson(const nlohmann::json& j, typename Schema::Record& r) {
+  auto text = [&j](const char* key) -> std::string_view {
+    auto it = j.find(key);
+    if (it == j.end() || !it->is_string()) return {};
+    return it->template get_ref<const std::string&>();
+  };
+  r.id = j.value("id", std::uint64_t{0});
+  setDatetime(r, text("datetime"));
+  forEachField<Schema>([&](const auto& f) {
+    using T = typename std::decay_t<decltype(f)>::Type;
+    if constexpr (std::decay_t<decltype(f)>::kNumber) {
+      r.*f.member = j.value(f.key, T{});
+    } else {
+      r.*f.member = text(f.key);
+    }
+  });
+}
+
+// For streaming loaders: set the field named `key` from a number / a
+// string. False if the schema has no such field of that kind.
+template <typename Schema>
+bool setRecordNumber(typename Schema::Record& r, std::string_view key, double d) {
+  bool found = false;
+  forEachField<Schema>([&](const auto& f) {
+    using T = typename std::decay_t<decltype(f)>::Type;
+    if constexpr (std::decay_t<decltype(f)>::kNumber) {
+      if (!found && key == f.key) {
+        r.*f.member = static_cast<T>(d);
+        found = true;
+      }
+    }
+  });
+  return found;
+}
+
+template <typename Schema>
+bool setRecordText(typename Schema::Record& r, std::string_view key, std::string_view s) {
+  bool found = false;
+  forEachField<Schema>([&](const auto& f) {
+    if constexpr (!std::decay_t<decltype(f)>::kNumber) {
+      if (!found && key == f.key) {
+        r.*f.member = s;
+        found = true;
+      }
+    }
+  });
+  return found;
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PackedText.hpp"
+#include "Symbol.hpp"
+#include "Timestamp.hpp"
+
+// ----------------------
+// 基本資料結構
+// ----------------------
+
+struct UserProfile {
+  std::string id;
+  std::string name;
+  int age = 0;
+  double weightKg = 0.0;
+  double heightM = 0.0;
+  std::string gender;
+};
+
+// This is added also to meet the requirement of BINGO!!!!
+inline std::string operator+(const std::string& lhs, const UserProfile& p) {
+  return lhs + "{ID:" + p.id + ", Name:" + p.name + ", Age:" + std::to_string(p.age) + "}";
+}
+
+// `id` is the record's stable id (see RecordSet); 0 until it is added.
+// `timeMs` is the client's datetime parsed when the record is added or
+// loaded (Timestamp.hpp). The API echoes that text back as it was sent, but
+// `datetime` keeps it only when it is not the canonical text of timeMs,
+// which is almost never: set and read it with setDatetime / datetimeText.
+//
+// With the text packed (PackedText) a record is a few fixed-size fields and
+// no heap block. Amounts stay double: a float would not echo every value
+// back exactly, and alignment would give the 4 bytes back as padding.
+struct WaterRecord {
+  PackedText datetime;  // empty: canonical
+  double amountMl = 0.0;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct SleepRecord {
+  PackedText datetime;
+  double hours = 0.0;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct ActivityRecord {
+  PackedText datetime;
+  int minutes = 0;
+  Symbol intensity;  // interned: a handful of values repeated on every record
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+struct CategoryItem {
+  PackedText datetime;
+  PackedText note;
+  double value = 0.0;
+  std::uint64_t id = 0;
+  std::int64_t timeMs = 0;
+};
+
+template <typename Rec>
+inline void setDatetime(Rec& r, std::string_view text) {
+  r.timeMs = parseTimestamp(text);
+  r.datetime = isCanonicalTimestamp(text, r.timeMs) ? std::string_view() : text;
+}
+
+template <typename Rec>
+inline DatetimeText datetimeText(const Rec& r) {
+  return DatetimeText(r.timeMs, r.datetime.view());
+}
+
+// ----------------------
+// RecordSet：records addressed by stable id
+// ----------------------
+//
+// One collection of a user's records, in insertion order. Ids are handed
+// out in increasing order (UserData::nextRecordId), so iteration order is
+// also id order, and a record is found by binary search over a sorted array
+// of the slots' ids: 8 bytes per record, where a hash index node costs
+// about 50. Erase leaves a tombstone (its id stays in the array) instead of
+// shifting the records behind it; the slots are compacted once tombstones
+// outnumber live records, which keeps erase amortised O(log n).
+template <typename Rec>
+class RecordSet {
+ public:
+  // Live records only.
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Rec;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Rec*;
+    using reference = const Rec&;
+
+    const_iterator(const Rec* at, const Rec* end) : at_(at), end_(end) { skipDead(); }
+    reference operator*() const { return *at_; }
+    pointer operator->() const { return at_; }
+    const_iterator& operator++() {
+      ++at_;
+      skipDead();
+      return *this;
+    }
+    bool operator==(const const_iterator& o) const { return at_ == o.at_; }
+    bool operator!=(const const_iterator& o) const { return at_ != o.at_; }
+
+   private:
+    const Rec* at_;
+    const Rec* end_;
+    void skipDead() {
+      while (at_ != end_ && at_->id == kDead) ++at_;
+    }
+  };
+
+  const_iterator begin() const { return const_iterator(slots_.data(), slots_.data() + slots_.size()); }
+  const_iterator end() const { return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+  std::size_t size() const { return live_; }
+  bool empty() const { return live_ == 0; }
+  void reserve(std::size_t n) {
+    slots_.reserve(n);
+    ids_.reserve(n);
+  }
+
+  Rec* find(std::uint64_t id) {
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), id);
+    if (it == ids_.end() || *it != id) return nullptr;
+    Rec& r = slots_[static_cast<std::size_t>(it - ids_.begin())];
+    return r.id == id ? &r : nullptr;  // else a tombstone
+  }
+  const Rec* find(std::uint64_t id) const { return const_cast<RecordSet*>(this)->find(id); }
+
+  // Appends `r`, whose id must be new to the set and larger than any in it.
+  // Id 0 is allowed only while loading data written before records had
+  // ids; assignIds numbers those.
+  void push_back(Rec r) {
+    ids_.push_back(r.id);
+    slots_.push_back(std::move(r));
+    ++live_;
+  }
+
+  // Adds records whose ids the set does not have yet, wherever they fall
+  // in id order (an archived segment coming back into memory). Rebuilds
+  // the slots: O(size() + more.size()).
+  void merge(std::vector<Rec> more) {
+    if (more.empty()) return;
+    live_ += more.size();
+    for (Rec& r : slots_) {
+      if (r.id != kDead) more.push_back(std::move(r));
+    }
+    std::sort(more.begin(), more.end(), [](const Rec& a, const Rec& b) { return a.id < b.id; });
+    slots_ = std::move(more);
+    ids_.clear();
+    ids_.reserve(slots_.size());
+    for (const Rec& r : slots_) ids_.push_back(r.id);
+  }
+
+  bool erase(std::uint64_t id) {
+    Rec* dead = find(id);
+    if (!dead) return false;
+    *dead = Rec{};  // release its text now
+    dead->id = kDead;
+    --live_;
+    if (slots_.size() - live_ > std::max<std::size_t>(live_, 16)) compact();
+    return true;
+  }
+
+  // Id of the index-th live record (0 if there is none). Only journal
+  // entries written before ids existed address records by position.
+  std::uint64_t idAt(std::size_t index) const {
+    if (index >= live_) return 0;
+    if (live_ == slots_.size()) return slots_[index].id;
+    auto it = begin();
+    std::advance(it, static_cast<std::ptrdiff_t>(index));
+    return it->id;
+  }
+
+  std::uint64_t maxId() const {
+    for (auto it = slots_.rbegin(); it != slots_.rend(); ++it) {
+      if (it->id != kDead) return it->id;
+    }
+    return 0;
+  }
+
+  // Numbers the records loaded without an id, in order, from `nextId` on.
+  // Should a file mix numbered and unnumbered records, the slots are then
+  // sorted by id so the id array stays searchable.
+  void assignIds(std::uint64_t& nextId) {
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+      if (slots_[i].id != 0) continue;
+      slots_[i].id = nextId++;
+      ids_[i] = slots_[i].id;
+    }
+    if (!std::is_sorted(ids_.begin(), ids_.end())) {
+      std::stable_sort(slots_.begin(), slots_.end(), [](const Rec& a, const Rec& b) { return a.id < b.id; });
+      for (std::size_t i = 0; i < slots_.size(); ++i) ids_[i] = slots_[i].id;
+    }
+  }
+
+  // Heap bytes of the slots and the id array (not the records' text).
+  std::size_t bytes() const { return slots_.capacity() * sizeof(Rec) + ids_.capacity() * sizeof(std::uint64_t); }
+
+ private:
+  static constexpr std::uint64_t kDead = ~std::uint64_t{0};
+
+  std::vector<Rec> slots_;          // kDead ids are tombstones
+  std::vector<std::uint64_t> ids_;  // the slots' ids, tombstones included; sorted
+  std::size_t live_ = 0;
+
+  void compact() {
+    std::vector<Rec> kept;
+    kept.reserve(live_);
+    ids_.clear();
+    for (Rec& r : slots_) {
+      if (r.id == kDead) continue;
+      ids_.push_back(r.id);
+      kept.push_back(std::move(r));
+    }
+    slots_ = std::move(kept);
+  }
+};
+
+// A run of a user's archived records: old records moved out of memory into
+// one immutable, compressed, time-sorted file (Archive.hpp). The record
+// fields live only in the file; this is what is needed to find it.
+struct Segment {
+  std::uint64_t id = 0;     // unique per user; names the file
+  Symbol collection;        // "waters" | "sleeps" | "activities" | "categories"
+  std::string category;     // the category, for "categories"
+  std::int64_t fromMs = 0;  // oldest timeMs in the file
+  std::int64_t toMs = 0;    // newest
+  std::uint64_t records = 0;
+};
+
+struct UserHandle;  // UserVersion.hpp
+
+struct UserData {
+  UserProfile profile;
+  std::string password;
+
+  RecordSet<WaterRecord> waters;
+  RecordSet<SleepRecord> sleeps;
+  RecordSet<ActivityRecord> activities;
+
+  // categoryName → items. Names come from clients, so each user owns its
+  // own (not interned); std::less<> finds one by string_view.
+  std::map<std::string, RecordSet<CategoryItem>, std::less<>> categories;
+
+  // The id the next record gets, whatever its collection (serialised, so an
+  // id is never handed out twice, even after the record is deleted).
+  std::uint64_t nextRecordId = 1;
+
+  // Archived records (serialised): they are no longer in the sets above.
+  std::vector<Segment> segments;
+
+  // Persistence bookkeeping (not serialised). With the sharded layout only
+  // dirty users are rewritten; persistedSeq is the journalSeq stamped on the
+  // user's snapshot, so replay skips entries that snapshot already holds.
+  bool dirty = false;
+  std::uint64_t lastSeq = 0;       // seq of the last journal entry applied to this user
+  std::uint64_t persistedSeq = 0;  // journal entries <= this are in the snapshot on disk
+  std::size_t bytes = 0;           // approxBytes(*this), kept current by HealthBackend::applyOp
+
+  // Read side (not serialised): HealthBackend's stable handle for this user,
+  // which holds the version lock-free readers see.
+  UserHandle* handle = nullptr;
+};
+
+// ----------------------
+// 記憶體估算：records + string bytes (UserCache budget)
+// ----------------------
+//
+// A record counts its slot, its entry in RecordSet's id array and its
+// packed text. Interned strings (Symbol) count only their handle: the text
+// is shared with every other user and lives in the pool, not in the user.
+// Only closed vocabularies (intensities, collection names) are interned.
+
+constexpr std::size_t kRecordIdBytes = sizeof(std::uint64_t);
+
+// The record's own heap blocks (packed text).
+inline std::size_t textBytes(const WaterRecord& r) { return r.datetime.heapBytes(); }
+inline std::size_t textBytes(const SleepRecord& r) { return r.datetime.heapBytes(); }
+inline std::size_t textBytes(const ActivityRecord& r) { return r.datetime.heapBytes(); }
+inline std::size_t textBytes(const CategoryItem& r) { return r.datetime.heapBytes() + r.note.heapBytes(); }
+
+inline std::size_t approxBytes(const WaterRecord& r) { return sizeof(r) + kRecordIdBytes + textBytes(r); }
+inline std::size_t approxBytes(const SleepRecord& r) { return sizeof(r) + kRecordIdBytes + textBytes(r); }
+inline std::size_t approxBytes(const ActivityRecord& r) { return sizeof(r) + kRecordIdBytes + textBytes(r); }
+inline std::size_t approxBytes(const CategoryItem& r) { return sizeof(r) + kRecordIdBytes + textBytes(r); }
+
+// What a set holds on the heap right now: its arrays at their capacity
+// (tombstones and spare room included) and its records' text. Memory
+// accounting (UserFootprint) reports this; approxBytes above is the cheap
+// running estimate the cache budget is kept with.
+template <typename Rec>
+inline std::size_t heapBytes(const RecordSet<Rec>& records) {
+  std::size_t n = records.bytes();
+  for (const auto& r : records) n += textBytes(r);
+  return n;
+}
+
+template <typename Rec>
+inline std::size_t approxBytes(const RecordSet<Rec>& records) {
+  std::size_t n = 0;
+  for (const auto& r : records) n += approxBytes(r);
+  return n;
+}
+
+// A category entry: its name, the map node and its items.
+inline std::size_t approxCategoryBytes(const std::string& name, const RecordSet<CategoryItem>& items) {
+  return name.size() + sizeof(std::string) + sizeof(items) + approxBytes(items);
+}
+
+inline std::size_t approxBytes(const UserData& u) {
+  std::size_t n = sizeof(UserData) + u.profile.id.size() + u.profile.name.size() + u.profile.gender.size() +
+                  u.password.size();
+  n += approxBytes(u.waters) + approxBytes(u.sleeps) + approxBytes(u.activities);
+  for (const auto& [name, items] : u.categories) n += approxCategoryBytes(name, items);
+  n += u.segments.size() * sizeof(Segment);
+  return n;
+}
+
+// After loading a user: ids for records stored before ids existed, and a
+// nextRecordId past every id in use.
+inline void assignRecordIds(UserData& u) {
+  std::uint64_t maxId = std::max({u.waters.maxId(), u.sleeps.maxId(), u.activities.maxId()});
+  for (const auto& [_, items] : u.categories) maxId = std::max(maxId, items.maxId());
+  u.nextRecordId = std::max(u.nextRecordId, maxId + 1);
+  u.waters.assignIds(u.nextRecordId);
+  u.sleeps.assignIds(u.nextRecordId);
+  u.activities.assignIds(u.nextRecordId);
+  for (auto& [_, items] : u.categories) items.assignIds(u.nextRecordId);
+}
+
+// name → user; the whole in-memory database and the unit snapshots work on.
+using UserMap = std::map<std::string, UserData>;
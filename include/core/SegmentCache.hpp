@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+#include "Records.hpp"
+#include "UserVersion.hpp"
+
+// Parsed archived segments (Archive.hpp), shared by every query that
+// reaches them, so a list that spans history decompresses and parses each
+// segment once instead of once per request.
+//
+// Segment files are immutable and a user never reuses a segment id, so an
+// entry never goes stale; entries are keyed by the segment's path. The
+// least recently used ones are dropped once the lists held pass the byte
+// budget (RecordList::bytes). A budget of 0 turns the cache off.
+class SegmentCache {
+ public:
+  struct Stats {
+    std::uint64_t budgetBytes = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t segments = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+  };
+
+  explicit SegmentCache(std::size_t budgetBytes) : budget_(budgetBytes) {}
+
+  // STORAGE_ARCHIVE_CACHE_BYTES (K / M / G suffix as STORAGE_CACHE_BYTES); default 32M.
+  static std::size_t budgetFromEnv();
+
+  template <typename T>
+  std::optional<RecordList<T>> get(const std::string& path) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = pos_.find(path);
+    const RecordList<T>* list = it == pos_.end() ? nullptr : std::get_if<RecordList<T>>(&it->second->list);
+    if (!list) {
+      ++misses_;
+      return std::nullopt;
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return *list;
+  }
+
+  template <typename T>
+  void put(const std::string& path, const RecordList<T>& list) {
+    insert(path, AnyList(list), list.bytes());
+  }
+
+  // The segment left the user (restored or dropped with its category).
+  void erase(const std::string& path);
+
+  Stats stats() const;
+
+ private:
+  using AnyList = std::variant<RecordList<WaterRecord>, RecordList<SleepRecord>, RecordList<ActivityRecord>,
+                               RecordList<CategoryItem>>;
+  struct Entry {
+    std::string path;
+    AnyList list;
+    std::size_t bytes;
+  };
+
+  std::size_t budget_;
+  mutable std::mutex mtx_;
+  std::list<Entry> lru_;  // most recently used at the front
+  std::unordered_map<std::string, std::list<Entry>::iterator> pos_;
+  std::size_t bytes_ = 0;
+  std::uint64_t hits_ = 0;
+  std::uint64_t misses_ = 0;
+
+  void insert(const std::string& path, AnyList list, std::size_t bytes);
+  void eraseLocked(std::unordered_map<std::string, std::list<Entry>::iterator>::iterator it);
+};
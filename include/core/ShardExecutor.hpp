@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Shard-per-core execution: N shard threads, each pinned to a core, each the
+// only thread that ever touches the users hashed to it. Callers hand a task
+// to the owning shard over that shard's lock-free MPSC queue and wait for it
+// to run, so per-user state needs no lock: it is only ever used from one
+// thread.
+//
+//   executor.run(executor.shardFor(name), [&] { ... mutate name's data ... });
+//
+// Tasks live on the caller's stack (run() blocks until the task has run), so
+// handing one over allocates nothing. A task submitted from the shard that
+// owns it runs inline.
+class ShardExecutor {
+ public:
+  // EXECUTOR_SHARDS: 0 / unset = off; "auto" = one per hardware thread.
+  static std::size_t shardsFromEnv();
+
+  explicit ShardExecutor(std::size_t shards);
+  ~ShardExecutor();
+  ShardExecutor(const ShardExecutor&) = delete;
+  ShardExecutor& operator=(const ShardExecutor&) = delete;
+
+  std::size_t size() const { return shards_.size(); }
+  std::size_t shardFor(std::string_view key) const;
+  // True on the thread of shard `shard`.
+  bool onShard(std::size_t shard) const;
+
+  // Run `fn` on `shard` and wait for it; rethrows what `fn` threw.
+  template <typename F>
+  void run(std::size_t shard, F&& fn) {
+    if (onShard(shard)) {
+      fn();
+      return;
+    }
+    using Fn = std::remove_reference_t<F>;
+    Task task;
+    task.call = [](void* ctx) { (*static_cast<Fn*>(ctx))(); };
+    task.ctx = const_cast<void*>(static_cast<const void*>(&fn));
+    submit(shard, task);
+    if (task.error) std::rethrow_exception(task.error);
+  }
+
+  struct ShardStats {
+    std::uint64_t tasks = 0;  // run on this shard so far
+    std::size_t queued = 0;   // submitted, not picked up yet
+    int cpu = -1;             // core it is pinned to; -1 if not pinned
+  };
+  std::vector<ShardStats> stats() const;
+
+ private:
+  struct Task {
+    std::atomic<Task*> next{nullptr};
+    void (*call)(void*) = nullptr;
+    void* ctx = nullptr;
+    std::exception_ptr error;
+    // Completion: the shard sets `done` and notifies under `mtx`; the caller
+    // always takes `mtx` before returning, so the shard is done with the
+    // task (which lives on the caller's stack) by then.
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+  };
+
+  // Intrusive MPSC queue (Vyukov): producers swing `head` with one
+  // exchange; only the shard thread moves `tail`.
+  struct Shard {
+    alignas(64) std::atomic<Task*> head;
+    alignas(64) Task* tail;
+    Task stub;
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool> sleeping{false};
+    std::mutex parkMtx;
+    std::condition_variable parkCv;
+    std::atomic<std::uint64_t> tasks{0};
+    int cpu = -1;
+    std::thread thread;
+
+    Shard() : head(&stub), tail(&stub) {}
+    void push(Task* t);
+    Task* pop();
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<bool> stop_{false};
+
+  void submit(std::size_t shard, Task& task);
+  void loop(std::size_t index);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "Records.hpp"
+#include "SnapshotJson.hpp"
+
+// Binary snapshot format (*.hbs), version 3 (version 1, without record ids,
+// and version 2, without archived segments, are still read).
+//
+// Built to be mmap'ed and walked with fixed-offset reads instead of parsed:
+//
+//   Header        64 bytes, magic "HBSNAP\0\0", version, counts, offsets
+//   User dir      one fixed-size entry per user (profile + ArrayRefs)
+//   Records       packed arrays of fixed-size water / sleep / activity /
+//                 category / category-item records, each with its id,
+//                 and archived segment descriptors
+//   String table  every string once (deduplicated), referenced by
+//                 {offset, length} from the structs above
+//
+// All integers are host-endian; the header carries an endian tag and the
+// reader rejects files written on a machine with the other byte order.
+bool writeBinarySnapshot(std::ostream& out, const UserMap& users, std::uint64_t journalSeq,
+                         const SnapshotProgress& progress = nullptr);
+
+// mmap `path` and rebuild `users` from it. Returns false if the file is
+// missing, truncated or not a version 1, 2 or 3 snapshot.
+bool readBinarySnapshot(const std::string& path, UserMap& users, std::uint64_t& journalSeq);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// Streaming codec for compressed snapshots (*.json.gz).
+//
+// Both directions go through a fixed-size buffer, so neither the writer nor
+// the reader ever holds the whole uncompressed image: the snapshot writer
+// streams one user at a time into CompressedOStream, and the SAX loader
+// pulls from CompressedIStream.
+//
+// Built with zlib (HEALTH_HAVE_ZLIB, set by CMake when it finds zlib) the
+// files are gzip (and plain files still read fine). Without it the codec is
+// a passthrough: *.json.gz files are written as plain JSON, and only such
+// files can be read back.
+namespace codec {
+
+// "zlib" or "none".
+const char* name();
+
+// zlib level 1 (fastest) .. 9 (smallest); ignored by the passthrough.
+constexpr int kDefaultLevel = 6;
+
+class CompressedOStream : public std::ostream {
+ public:
+  explicit CompressedOStream(const std::string& path, int level = kDefaultLevel);
+  ~CompressedOStream() override;
+
+  // Flush the last block and close the file; false (and failbit) if any
+  // write failed. The destructor closes too, but cannot report errors.
+  bool close();
+
+ private:
+  std::unique_ptr<std::streambuf> buf_;
+};
+
+class CompressedIStream : public std::istream {
+ public:
+  explicit CompressedIStream(const std::string& path);
+  ~CompressedIStream() override;
+
+ private:
+  std::unique_ptr<std::streambuf> buf_;
+};
+
+}  // namespace codec
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+#include "../../third_party/json.hpp"
+#include "Records.hpp"
+
+// Reports (usersWritten, usersTotal) while a snapshot is being written.
+using SnapshotProgress = std::function<void(std::size_t, std::size_t)>;
+
+// -------- record <-> JSON (snapshot + journal share these keys) --------
+nlohmann::json toJson(const WaterRecord& w);
+nlohmann::json toJson(const SleepRecord& s);
+nlohmann::json toJson(const ActivityRecord& a);
+nlohmann::json toJson(const CategoryItem& item);
+
+void fromJson(const nlohmann::json& j, WaterRecord& w);
+void fromJson(const nlohmann::json& j, SleepRecord& s);
+void fromJson(const nlohmann::json& j, ActivityRecord& a);
+void fromJson(const nlohmann::json& j, CategoryItem& item);
+
+// An archived segment's descriptor (snapshot "segments" and the "archive" journal op).
+nlohmann::json segmentToJson(const Segment& seg);
+void segmentFromJson(const nlohmann::json& j, Segment& seg);
+
+// Profile + password only; used for the snapshot and the user.create journal entry.
+nlohmann::json profileToJson(const UserData& data);
+void profileFromJson(const nlohmann::json& ju, UserData& data);
+
+// -------- whole snapshot: {"journalSeq": N, "users": [...]} --------
+nlohmann::json usersToJson(const UserMap& users, std::uint64_t journalSeq, const SnapshotProgress& progress = nullptr);
+// Returns false (and leaves `users` untouched) if `j` is not a snapshot.
+bool usersFromJson(const nlohmann::json& j, UserMap& users, std::uint64_t& journalSeq);
+
+// Streaming equivalent of `out << usersToJson(...).dump(indent)` (-1 is
+// compact): one user is converted and written at a time, so the whole
+// document never exists in memory.
+bool writeJsonSnapshot(std::ostream& out, const UserMap& users, std::uint64_t journalSeq, int indent = 2,
+                       const SnapshotProgress& progress = nullptr);
+
+// Streaming equivalent of parsing `path` and calling usersFromJson: records
+// are filled straight from SAX events, so peak memory stays close to the
+// resulting UserMap instead of file + DOM + UserMap.
+bool readJsonSnapshot(const std::string& path, UserMap& users, std::uint64_t& journalSeq);
+// Same, from a stream (e.g. codec::CompressedIStream).
+bool readJsonSnapshot(std::istream& in, UserMap& users, std::uint64_t& journalSeq);
@@ -1,25 +1,125 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "../../third_party/json.hpp"
+#include "Journal.hpp"
+#include "Records.hpp"
+#include "SnapshotJson.hpp"
 
 class Storage {
  public:
+  // Snapshot file format, picked from the extension: *.hbs → Binary
+  // (see SnapshotBinary.hpp), *.gz → CompressedJson (compact JSON through
+  // the streaming codec in SnapshotCodec.hpp), anything else → Json.
+  enum class Format { Json, Binary, CompressedJson };
+  static Format formatForPath(const std::string& path);
+  static const char* formatName(Format f);
+
+  // Single: one snapshot file holding every user.
+  // Sharded: one snapshot file per user under <dir>/users/<hash-prefix>/,
+  //          in the format of the configured path, so a save only rewrites
+  //          the users that changed (UserData::dirty).
+  enum class Layout { Single, Sharded };
+  // "single" | "sharded"; anything else falls back to Single.
+  static Layout parseLayout(const std::string& s);
+  static const char* layoutName(Layout l);
+
+  // Path defaults to data/storage.json; STORAGE_PATH overrides it.
+  // STORAGE_LAYOUT picks the layout (default single).
   Storage();
-  explicit Storage(const std::string& path);
+  explicit Storage(const std::string& path, Layout layout = Layout::Single);
+  ~Storage();
 
   std::string path() const { return storagePath; }
+  Format format() const { return format_; }
+  Layout layout() const { return layout_; }
+
+  // Sharded layout: root directory and the file holding `user`.
+  std::string shardRoot() const;
+  std::string shardPathFor(const std::string& user) const;
+
+  // Sharded layout, one user at a time (lazy loading / cache eviction).
+  // loadUser sets persistedSeq; saveUser stamps the shard with `journalSeq`.
+  bool userExists(const std::string& user) const;
+  bool loadUser(const std::string& user, UserData& out) const;
+  bool saveUser(const std::string& user, const UserData& data, std::uint64_t journalSeq) const;
+  // Every shard file on disk, and loading one of them (background warm-up).
+  std::vector<std::string> shardFiles() const;
+  bool loadShardFile(const std::string& file, UserMap& users) const;
+
+  // <shardRoot>/MANIFEST, rewritten after every full shard save: the highest
+  // journalSeq any shard can carry. Lets a lazy start seed the journal
+  // without reading every shard. Returns false if there is none yet.
+  bool readManifest(std::uint64_t& journalSeq) const;
+
+  // Load the snapshot into `users`; returns false on missing file or parse error.
+  // Sets each user's persistedSeq; `journalSeq` is where journal replay has
+  // to start (0 for shards, which are stamped one by one). Shards are loaded
+  // in parallel.
+  bool loadSnapshot(UserMap& users, std::uint64_t& journalSeq) const;
+
+  // Save the snapshot atomically (temp file + fsync + rename); returns true on success.
+  // Sharded: only users marked dirty are written, each to its own file.
+  bool saveSnapshot(const UserMap& users, std::uint64_t journalSeq, const SnapshotProgress& progress = nullptr) const;
+
+  // -------- Archived segments (Archive.hpp) --------
 
-  // Load JSON from storage; returns empty json object on missing or parse error
-  nlohmann::json load() const;
+  // <dir>/archive/<hash-prefix>/<user>/<collection>-<id>.seg.gz, whatever
+  // the layout and format.
+  std::string segmentPathFor(const std::string& user, const Segment& seg) const;
+  // Write a segment file atomically (temp file + fsync + rename), compressed
+  // through the streaming codec; `write` produces the body.
+  bool writeSegmentFile(const std::string& user, const Segment& seg,
+                        const std::function<bool(std::ostream&)>& write) const;
+  void removeSegmentFile(const std::string& user, const Segment& seg) const;
 
-  // Save JSON to storage; returns true on success
-  bool save(const nlohmann::json& j) const;
+  // -------- Write-ahead journal (<path>.wal) --------
+
+  // Replay journal entries newer than the snapshot's `journalSeq`.
+  std::size_t replayJournal(std::uint64_t snapshotSeq, const std::function<void(const nlohmann::json&)>& apply);
+
+  // Append one mutation; returns its seq. Blocks for the group fsync only
+  // when STORAGE_DURABILITY=sync (see Journal::Durability).
+  std::uint64_t appendJournal(nlohmann::json entry);
+
+  // Highest seq handed out so far; a snapshot taken now covers everything up to it.
+  std::uint64_t journalSeq() const;
+  // Never hand out a seq <= `seq` (shards can be newer than where replay started).
+  void advanceJournalSeq(std::uint64_t seq);
+
+  // True once the journal has grown past the checkpoint threshold
+  // (STORAGE_CHECKPOINT_BYTES, default 1 MiB).
+  bool needsCheckpoint() const;
+
+  // Write the snapshot, then drop the journal entries it now contains.
+  bool checkpoint(const UserMap& users, std::uint64_t journalSeq);
+
+  // Background snapshots: seal the journal right before forking, drop the
+  // sealed part once the child's snapshot has been renamed into place.
+  bool sealJournal();
+  void dropSealedJournal();
+
+  Journal::Durability durability() const;
+  Journal::Stats journalStats() const;
+  std::uintmax_t journalBytes() const;
 
  private:
   std::string storagePath;
+  Format format_ = Format::Json;
+  Layout layout_ = Layout::Single;
+  std::unique_ptr<Journal> journal_;
+  std::uintmax_t checkpointBytes_ = 1024 * 1024;
 
   static bool dirExists(const std::string& path);
-  void ensureStorageDirExists() const;
+  static void ensureParentDirExists(const std::string& file);
+  void initJournal();
+
+  bool loadShards(UserMap& users, std::uint64_t& journalSeq) const;
+  bool saveShards(const UserMap& users, std::uint64_t journalSeq, const SnapshotProgress& progress) const;
 };
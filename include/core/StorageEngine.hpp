@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../third_party/json.hpp"
+#include "Records.hpp"
+
+// A storage engine persists users and their records one record at a time.
+//
+// Engines are interchangeable behind this interface: test/storage_conformance
+// checks that every engine behaves the same (including across a reopen), and
+// bench/engine_bench runs our request mix against each of them, so a new
+// engine can be compared before HealthBackend is moved onto it.
+//
+// Records are addressed like in the HTTP API: a collection plus the record's
+// id, and for custom categories the category name. Every method is
+// thread-safe.
+class StorageEngine {
+ public:
+  static constexpr std::uint64_t kAppend = 0;  // no record has id 0
+
+  struct RecordRef {
+    std::string coll;            // "waters" | "sleeps" | "activities" | "categories"
+    std::uint64_t id = kAppend;  // kAppend: putRecord adds a new record
+    std::string category{};      // coll == "categories" only
+  };
+
+  struct Stats {
+    std::uint64_t users = 0;
+    std::uint64_t writes = 0;        // successful record-level writes since open()
+    std::uint64_t checkpoints = 0;
+    std::uint64_t journalBytes = 0;  // not yet folded into a checkpoint
+  };
+
+  virtual ~StorageEngine() = default;
+
+  virtual std::string name() const = 0;
+
+  // Load whatever is on disk. Call once, before anything else; false if the
+  // existing data could not be read (an empty directory is fine).
+  virtual bool open() = 0;
+
+  // Profile + password of `user.profile.name`; false if the name is taken.
+  virtual bool createUser(const UserData& user) = 0;
+
+  // Add (ref.id == kAppend) or replace one record; `record` uses the
+  // snapshot keys (see toJson in SnapshotJson.hpp). A new record gets the
+  // user's next id, as in HealthBackend. False on an unknown user,
+  // collection, category or record id.
+  virtual bool putRecord(const std::string& user, const RecordRef& ref, const nlohmann::json& record) = 0;
+  virtual bool deleteRecord(const std::string& user, const RecordRef& ref) = 0;
+
+  virtual bool createCategory(const std::string& user, const std::string& category) = 0;
+  virtual bool dropCategory(const std::string& user, const std::string& category) = 0;
+
+  // A copy of one user; false if there is no such user.
+  virtual bool loadUser(const std::string& user, UserData& out) const = 0;
+  // Every user, in name order.
+  virtual void forEachUser(const std::function<void(const UserData&)>& fn) const = 0;
+
+  // Fold everything written so far into the engine's snapshot, so the next
+  // open() does not have to replay it.
+  virtual bool checkpoint() = 0;
+
+  virtual Stats stats() const = 0;
+};
+
+// Engines kept in `dir`, by name (see storageEngineNames):
+//   json            one JSON snapshot + journal (the default server setup)
+//   json-gz         one compressed JSON (*.json.gz) snapshot + journal
+//   binary          one binary (*.hbs) snapshot + journal
+//   sharded         one JSON snapshot per user + shared journal
+//   sharded-gz      one compressed JSON snapshot per user + shared journal
+//   sharded-binary  one binary snapshot per user + shared journal
+// Returns nullptr for an unknown name.
+std::unique_ptr<StorageEngine> makeStorageEngine(const std::string& name, const std::string& dir);
+std::vector<std::string> storageEngineNames();
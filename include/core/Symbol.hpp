@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// ----------------------
+// Interned strings
+// ----------------------
+//
+// A Symbol is a 4-byte handle to a string in one process-wide pool. Equal
+// strings share one entry, so values that repeat across records and users
+// (intensities, collection names) are stored once and compared by id.
+// Interning is thread-safe; reading a symbol's text takes no lock.
+//
+// The pool never shrinks, so it is for small, closed vocabularies; names a
+// client makes up (categories, genders) stay owned by their user. It is
+// bounded (1M symbols, 64 MiB of text): interning a new string into a full
+// pool throws std::length_error rather than losing the value.
+class Symbol {
+ public:
+  Symbol() = default;  // the empty string
+  Symbol(std::string_view s) : id_(intern(s)) {}  // NOLINT(google-explicit-constructor)
+  Symbol(const std::string& s) : Symbol(std::string_view(s)) {}  // NOLINT(google-explicit-constructor)
+  Symbol(const char* s) : Symbol(std::string_view(s)) {}  // NOLINT(google-explicit-constructor)
+
+  std::string_view view() const;
+  std::string str() const { return std::string(view()); }
+  std::uint32_t id() const { return id_; }
+  bool empty() const { return id_ == 0; }
+
+  friend bool operator==(Symbol a, Symbol b) { return a.id_ == b.id_; }
+  friend bool operator!=(Symbol a, Symbol b) { return a.id_ != b.id_; }
+
+  struct PoolStats {
+    std::size_t symbols = 0;
+    std::size_t bytes = 0;  // text plus index, roughly
+  };
+  static PoolStats poolStats();
+
+ private:
+  std::uint32_t id_ = 0;
+  static std::uint32_t intern(std::string_view s);
+};
+
+// Orders by text (so maps keyed by Symbol iterate in name order, as maps
+// keyed by std::string did) and finds by string without interning it.
+struct SymbolLess {
+  using is_transparent = void;
+  bool operator()(Symbol a, Symbol b) const { return a != b && a.view() < b.view(); }
+  template <typename S, typename = std::enable_if_t<std::is_convertible_v<const S&, std::string_view>>>
+  bool operator()(Symbol a, const S& b) const {
+    return a.view() < std::string_view(b);
+  }
+  template <typename S, typename = std::enable_if_t<std::is_convertible_v<const S&, std::string_view>>>
+  bool operator()(const S& a, Symbol b) const {
+    return std::string_view(a) < b.view();
+  }
+};
+
+template <>
+struct std::hash<Symbol> {
+  std::size_t operator()(Symbol s) const noexcept { return std::hash<std::uint32_t>{}(s.id()); }
+};
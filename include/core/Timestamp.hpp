@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+// ----------------------
+// Record timestamps
+// ----------------------
+//
+// Record datetimes arrive as ISO 8601 text ("2024-01-01T08:00:00.000Z") and
+// are parsed once, when the record is added or loaded, into milliseconds
+// since the Unix epoch (UTC). Everything time-based (ordering, ranges)
+// compares those integers and never looks at the text again.
+
+// Stored for datetimes that do not parse. Sorts before every real time, so
+// such records only show up in queries without a lower bound.
+constexpr std::int64_t kNoTime = std::numeric_limits<std::int64_t>::min();
+
+// Accepts YYYY-MM-DD, optionally followed by 'T' (or a space) and HH:MM,
+// HH:MM:SS or HH:MM:SS.fraction, then an optional zone: 'Z', +HH:MM, +HHMM
+// or -... . A missing zone is taken as UTC. kNoTime if `text` is anything
+// else.
+std::int64_t parseTimestamp(std::string_view text);
+
+// ----------------------
+// Canonical datetime text
+// ----------------------
+//
+// Clients send ISO 8601 in the form JavaScript's toISOString() produces,
+// "2024-01-01T08:00:00.000Z", and the API echoes the text back unchanged.
+// That text is a pure function of the time, so records keep it only when it
+// is something else (DatetimeText).
+
+constexpr std::size_t kCanonicalTimeLen = 24;  // "YYYY-MM-DDTHH:MM:SS.sssZ"
+
+// Writes the canonical text of `ms` into `out`; false (out untouched) for a
+// time outside years 0000-9999, which has none.
+bool formatTimestamp(std::int64_t ms, char (&out)[kCanonicalTimeLen]);
+
+// True if `text` is exactly the canonical text of `ms` (its parse).
+bool isCanonicalTimestamp(std::string_view text, std::int64_t ms);
+
+// A record's datetime as text, built without allocating: the text kept with
+// the record, or, when none was kept, the canonical text rebuilt from the
+// time into an inline buffer. Views into it are valid while it is.
+class DatetimeText {
+ public:
+  DatetimeText(std::int64_t ms, std::string_view kept) : kept_(kept) {
+    if (kept.empty() && ms != kNoTime) canonical_ = formatTimestamp(ms, buf_);
+  }
+  std::string_view view() const { return canonical_ ? std::string_view(buf_, kCanonicalTimeLen) : kept_; }
+  operator std::string_view() const { return view(); }  // NOLINT(google-explicit-constructor)
+
+ private:
+  std::string_view kept_;
+  bool canonical_ = false;
+  char buf_[kCanonicalTimeLen];
+};
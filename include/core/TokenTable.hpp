@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+struct UserHandle;  // UserVersion.hpp
+
+// Session token → UserHandle, read on every authenticated request.
+//
+// Open addressing with linear probing over a power-of-two array of atomic
+// entry pointers, keyed by the fixed-length token. Lookups take a
+// std::string_view (straight out of the Authorization header), allocate
+// nothing and take no lock: they probe under an EpochDomain pin. Inserts are
+// serialised by a mutex; when the table gets half full they build an array
+// twice the size and publish it, and the old array is retired through the
+// epoch domain. Entries are shared by both arrays and live as long as the
+// table. Tokens are never removed (there is no logout).
+class TokenTable {
+ public:
+  static constexpr std::size_t kTokenLength = 32;
+
+  explicit TokenTable(std::size_t initialCapacity = 1024);
+  ~TokenTable();
+  TokenTable(const TokenTable&) = delete;
+  TokenTable& operator=(const TokenTable&) = delete;
+
+  // nullptr unless `token` was inserted. Lock-free.
+  const UserHandle* find(std::string_view token) const;
+
+  // False if the token has the wrong length or is already present.
+  bool insert(std::string_view token, const UserHandle* user);
+
+  std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+  std::size_t capacity() const;
+
+ private:
+  struct Entry {
+    char token[kTokenLength];
+    const UserHandle* user;
+  };
+  struct Array {
+    explicit Array(std::size_t n) : mask(n - 1), slots(new std::atomic<Entry*>[n]) {
+      for (std::size_t i = 0; i < n; ++i) slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    std::size_t mask;
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+  };
+
+  std::atomic<Array*> array_;
+  std::atomic<std::size_t> size_{0};
+  std::mutex writeMtx_;
+  std::vector<std::unique_ptr<Entry>> entries_;  // owned here; writers only
+
+  static std::size_t hash(std::string_view token);
+  static void place(Array& array, Entry* entry);
+  void grow();
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bookkeeping for the resident-user cache: recency (LRU), an approximate
+// byte count of what is resident and hit / miss / eviction counters.
+//
+// It does not own any UserData; HealthBackend keeps the users and decides
+// what can be evicted (a dirty user has to be written to its shard first).
+// A budget of 0 means unbounded: every user stays resident, as before.
+class UserCache {
+ public:
+  struct Stats {
+    std::uint64_t budgetBytes = 0;  // 0 = unbounded
+    std::uint64_t residentBytes = 0;
+    std::uint64_t residentUsers = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+  };
+
+  explicit UserCache(std::size_t budgetBytes = 0) : budget_(budgetBytes) {}
+
+  // STORAGE_CACHE_BYTES (accepts a K / M / G suffix); 0 or unset = unbounded.
+  static std::size_t budgetFromEnv();
+  // A byte count from `var`, with the same suffixes; `fallback` if unset or invalid.
+  static std::size_t bytesFromEnv(const char* var, std::size_t fallback);
+
+  bool bounded() const { return budget_ > 0; }
+  std::size_t budget() const { return budget_; }
+
+  // A lookup found `name` resident.
+  void hit(const std::string& name);
+  // `name` became resident: loaded from storage (miss) or just registered.
+  void admit(const std::string& name, std::size_t bytes, bool miss);
+  // A resident user grew or shrank.
+  void resize(std::int64_t delta) { bytes_ += delta; }
+  // `name` was dropped from memory.
+  void evict(const std::string& name, std::size_t bytes);
+
+  bool overBudget() const { return bounded() && bytes_.load() > static_cast<std::int64_t>(budget_); }
+  // Evict down to this, so we do not evict again on the very next miss.
+  std::size_t target() const { return budget_ - budget_ / 10; }
+  std::size_t residentBytes() const { return static_cast<std::size_t>(std::max<std::int64_t>(0, bytes_.load())); }
+
+  // Resident users, least recently used first.
+  std::vector<std::string> coldest() const;
+
+  Stats stats() const;
+
+ private:
+  std::size_t budget_;
+  std::atomic<std::int64_t> bytes_{0};
+  std::atomic<std::uint64_t> users_{0};
+  std::atomic<std::uint64_t> hits_{0};
+  std::atomic<std::uint64_t> misses_{0};
+  std::atomic<std::uint64_t> evictions_{0};
+
+  // Most recently used at the front.
+  mutable std::mutex lruMtx_;
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, std::list<std::string>::iterator> pos_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../../third_party/json.hpp"
+#include "Records.hpp"
+
+// Record-level mutations, in the form they are written to the journal:
+//
+//   {"op": "add", "coll": "waters" | "sleeps" | "activities", "rec": {"id": id, ...}}
+//   {"op": "update" | "delete", "coll": ..., "id": id, "rec": {...}}
+//   {"op": "create" | "drop" | "add" | "update" | "delete", "coll": "categories", "category": name, ...}
+//   {"op": "archive", "coll": ..., ["category": name,] "before": ms, "segment": {"id": id, ...}}
+//   {"op": "restore", "coll": ..., ["category": name,] "segment": id, "recs": [{...}, ...]}
+//
+// "archive" moves every record with a time before "before" (isArchivable)
+// into the segment it names (Archive.hpp), whose file is already on disk;
+// "restore" moves a segment's records ("recs", read from its file) back
+// into memory and forgets the segment; "drop" of a category forgets the
+// category's segments too.
+//
+// Records are addressed by their stable id (RecordSet in Records.hpp).
+// Entries written before records had ids carry an "index" (position)
+// instead, and "add" entries without an id take the user's next one; both
+// still replay to the same result.
+//
+// HealthBackend and every StorageEngine apply them through applyUserOp, so a
+// replayed journal reproduces exactly what the requests did.
+
+nlohmann::json makeUserOp(const char* kind, const char* coll);
+
+// For an "add" op: stamps the id the new record will get into op["rec"], so
+// the journal entry names it, and returns it. 0 for any other op.
+std::uint64_t assignRecordId(const UserData& user, nlohmann::json& op);
+
+// Whether a record at `timeMs` goes into a segment cut at `before`: records
+// whose datetime did not parse (kNoTime) never do.
+bool isArchivable(std::int64_t timeMs, std::int64_t before);
+
+// Apply one op to `user`, keeping user.bytes (approxBytes) current. Returns
+// false, leaving `user` untouched, if the op does not apply (unknown
+// collection, category or record id, or an "add" reusing an id); throws
+// json::exception on a malformed "rec", also before touching `user`.
+bool applyUserOp(UserData& user, const nlohmann::json& op);
+
+// Whether applyUserOp would apply `op` to `user`, checked without changing
+// it, so a writer can log an op before applying it. Does not parse "rec":
+// a malformed one still fails only in applyUserOp.
+bool canApplyUserOp(const UserData& user, const nlohmann::json& op);
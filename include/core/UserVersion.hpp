@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "RecordColumns.hpp"
+#include "Records.hpp"
+#include "Timestamp.hpp"
+
+// ----------------------
+// Published user versions (MVCC)
+// ----------------------
+//
+// Readers never look at UserData, which writers change in place. Each write
+// instead publishes a new immutable UserVersion into the user's UserHandle
+// and retires the old one through EpochDomain. Versions share structure: a
+// write copies the one list it changed and reuses every other list, so a
+// reader holding an older version (or just one list of it) keeps a
+// consistent view.
+
+// A time-ordered listing (RecordList::page). Records are ordered by
+// (timeMs, id); `resume` continues behind the last record of an earlier page,
+// so pages stay consistent while records are added or deleted in between.
+struct RecordQuery {
+  std::int64_t from = kNoTime;                                 // inclusive
+  std::int64_t to = std::numeric_limits<std::int64_t>::max();  // exclusive
+  std::size_t limit = 0;                                       // 0 = no limit
+  bool resume = false;
+  std::int64_t afterTime = 0;
+  std::uint64_t afterId = 0;
+};
+
+// A read-only list of records. Copying one only bumps a reference count, and
+// the list stays valid (and unchanged) after later writes.
+//
+// The records are stored column by column (RecordColumns.hpp) and read back
+// as views (WaterView ...), in id (write) order. columns() exposes the
+// arrays themselves for scans such as sums over a field.
+//
+// A time index over `timeMs` is built with the list, so a time range is two
+// binary searches and then touches only the records inside it. Records
+// usually arrive in time order; the index is then the list itself and costs
+// one pass to confirm.
+template <typename T>
+class RecordList {
+ public:
+  using Columns = RecordColumns<T>;
+  using View = typename Columns::View;
+
+  RecordList() = default;
+  // From any sequence of T in id order (a RecordSet, a vector).
+  template <typename Records>
+  explicit RecordList(const Records& records) {
+    auto data = std::make_shared<Data>();
+    std::size_t textBytes = 0;
+    for (const T& r : records) textBytes += arenaBytes(r);
+    data->cols.reserve(records.size(), textBytes);
+    for (const T& r : records) data->cols.append(r);
+
+    const std::vector<std::int64_t>& t = data->cols.timeMs;
+    if (!std::is_sorted(t.begin(), t.end())) {
+      data->byTime.resize(t.size());
+      for (std::uint32_t i = 0; i < t.size(); ++i) data->byTime[i] = i;
+      std::stable_sort(data->byTime.begin(), data->byTime.end(),
+                       [&t](std::uint32_t a, std::uint32_t b) { return t[a] < t[b]; });
+    }
+    data_ = std::move(data);
+  }
+
+  // Yields views by value; `byTime` walks the time index instead of id order.
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = View;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = View;
+
+    struct Arrow {
+      View v;
+      const View* operator->() const { return &v; }
+    };
+
+    const_iterator(const RecordList* list, std::size_t k, bool byTime) : list_(list), k_(k), byTime_(byTime) {}
+    View operator*() const { return byTime_ ? list_->byTime(k_) : (*list_)[k_]; }
+    Arrow operator->() const { return Arrow{**this}; }
+    const_iterator& operator++() {
+      ++k_;
+      return *this;
+    }
+    bool operator==(const const_iterator& o) const { return k_ == o.k_; }
+    bool operator!=(const const_iterator& o) const { return k_ != o.k_; }
+
+   private:
+    const RecordList* list_;
+    std::size_t k_;
+    bool byTime_;
+  };
+
+  bool empty() const { return size() == 0; }
+  std::size_t size() const { return data_ ? data_->cols.id.size() : 0; }
+  View operator[](std::size_t i) const { return data_->cols.row(i); }
+  const_iterator begin() const { return const_iterator(this, 0, false); }
+  const_iterator end() const { return const_iterator(this, size(), false); }
+
+  const Columns& columns() const {
+    static const Columns none;
+    return data_ ? data_->cols : none;
+  }
+  // Heap bytes of the columns and the time index.
+  std::size_t bytes() const {
+    return data_ ? data_->cols.bytes() + data_->byTime.capacity() * sizeof(std::uint32_t) : 0;
+  }
+
+  // The record with this id, if any. Ids are increasing, so this is a binary
+  // search over the id column.
+  std::optional<View> find(std::uint64_t id) const {
+    const std::vector<std::uint64_t>& ids = columns().id;
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) return std::nullopt;
+    return (*this)[static_cast<std::size_t>(it - ids.begin())];
+  }
+
+  // Records with from <= timeMs < to, oldest first (equal times in id
+  // order). Valid while this list is.
+  class TimeRange {
+   public:
+    TimeRange(const RecordList* list, std::size_t lo, std::size_t hi) : list_(list), lo_(lo), hi_(hi) {}
+    const_iterator begin() const { return const_iterator(list_, lo_, true); }
+    const_iterator end() const { return const_iterator(list_, hi_, true); }
+    std::size_t size() const { return hi_ - lo_; }
+    bool empty() const { return lo_ == hi_; }
+
+   private:
+    const RecordList* list_;
+    std::size_t lo_, hi_;  // positions in time order
+  };
+
+  TimeRange between(std::int64_t from, std::int64_t to) const {
+    const std::size_t lo = firstAtOrAfter(from);
+    return TimeRange(this, lo, std::max(lo, firstAtOrAfter(to)));
+  }
+
+  struct Page {
+    TimeRange records;
+    bool more = false;  // the range goes on after this page
+  };
+
+  // Cost follows the page, not the list: three binary searches, then only
+  // the page's records are touched.
+  Page page(const RecordQuery& q) const {
+    std::size_t lo = firstAtOrAfter(q.from);
+    const std::size_t hi = std::max(lo, firstAtOrAfter(q.to));
+    if (q.resume) lo = std::min(hi, std::max(lo, firstAfter(q.afterTime, q.afterId)));
+    const std::size_t last = q.limit > 0 ? std::min(hi, lo + q.limit) : hi;
+    return Page{TimeRange(this, lo, last), last < hi};
+  }
+
+  // The k-th record in time order.
+  View byTime(std::size_t k) const { return (*this)[position(k)]; }
+
+ private:
+  struct Data {
+    Columns cols;
+    std::vector<std::uint32_t> byTime;  // positions by timeMs; empty if already in order
+  };
+  std::shared_ptr<const Data> data_;
+
+  std::size_t position(std::size_t k) const { return data_->byTime.empty() ? k : data_->byTime[k]; }
+
+  // Position (in time order) of the first record with timeMs >= t.
+  std::size_t firstAtOrAfter(std::int64_t t) const {
+    std::size_t lo = 0, hi = size();
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      if (data_->cols.timeMs[position(mid)] < t) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // Position (in time order) of the first record after (t, id).
+  std::size_t firstAfter(std::int64_t t, std::uint64_t id) const {
+    std::size_t lo = 0, hi = size();
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      const std::size_t at = position(mid);
+      const std::int64_t mt = data_->cols.timeMs[at];
+      if (mt < t || (mt == t && data_->cols.id[at] <= id)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+};
+
+struct UserVersion {
+  std::uint64_t version = 0;  // 1 for the first published, +1 per change
+  UserProfile profile;
+  RecordList<WaterRecord> waters;
+  RecordList<SleepRecord> sleeps;
+  RecordList<ActivityRecord> activities;
+  std::map<std::string, RecordList<CategoryItem>, std::less<>> categories;
+  // The user's archived segments (UserData::segments), shared until one is
+  // added or dropped. Never null.
+  std::shared_ptr<const std::vector<Segment>> segments;
+};
+
+// One per user that has been in memory, kept (and reused) across eviction,
+// so a session token can point at it for good. `published` is null until the
+// user is first read and again after it is evicted.
+struct UserHandle {
+  explicit UserHandle(std::string userName) : name(std::move(userName)) {}
+  const std::string name;
+  std::atomic<const UserVersion*> published{nullptr};
+};
+
+// Everything copied from `u` (first publication).
+std::unique_ptr<UserVersion> makeUserVersion(const UserData& u);
+
+// `prev` with the collection a journal op ({"coll", "category"}) touched
+// re-copied from `u`; the other lists are shared with `prev`.
+std::unique_ptr<UserVersion> nextUserVersion(const UserVersion& prev, const UserData& u, const std::string& coll,
+                                             const std::string& category);
+
+// ----------------------
+// Memory accounting
+// ----------------------
+//
+// What one resident user costs, per collection: its records in UserData
+// (slots, id array, packed text; heapBytes in Records.hpp) and the
+// published lists readers see (columns, text arena, time index;
+// RecordList::bytes). Capacities are counted and allocator overhead is not,
+// so the total is a little under what the process's RSS grows by.
+struct CollectionFootprint {
+  std::size_t records = 0;
+  std::size_t recordBytes = 0;     // UserData
+  std::size_t publishedBytes = 0;  // UserVersion
+  std::size_t bytes() const { return recordBytes + publishedBytes; }
+  CollectionFootprint& operator+=(const CollectionFootprint& o) {
+    records += o.records;
+    recordBytes += o.recordBytes;
+    publishedBytes += o.publishedBytes;
+    return *this;
+  }
+};
+
+struct UserFootprint {
+  std::string name;
+  CollectionFootprint waters, sleeps, activities;
+  CollectionFootprint categories;  // all of the user's categories together
+  std::size_t otherBytes = 0;      // the user itself: profile, password, map entries
+  std::size_t records() const { return waters.records + sleeps.records + activities.records + categories.records; }
+  std::size_t bytes() const {
+    return otherBytes + waters.bytes() + sleeps.bytes() + activities.bytes() + categories.bytes();
+  }
+};
+
+// `published` is u's current version, or null if it has none (not read
+// since it was loaded); the caller keeps both from changing meanwhile.
+UserFootprint footprintOf(const UserData& u, const UserVersion* published);
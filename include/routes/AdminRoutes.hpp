@@ -6,4 +6,4 @@ namespace httplib {
 class Server;
 }
 
-void registerSleepRoutes(httplib::Server& svr, HealthBackend& backend);
+void registerAdminRoutes(httplib::Server& svr, HealthBackend& backend);
@@ -1,18 +1,348 @@
 #pragma once
 
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "../third_party/httplib.h"
+#include "../third_party/json.hpp"
+#include "core/RecordSchema.hpp"
+#include "core/UserVersion.hpp"
+#include "utils/RequestArena.hpp"
 
-inline std::string getTokenFromAuthHeader(const httplib::Request& req) {
+// ----------------------
+// Request-scoped JSON
+// ----------------------
+//
+// Route handlers parse bodies and build responses as RequestJson: the same
+// ordered JSON as nlohmann::ordered_json, with every node and string in the
+// worker's RequestArena (utils/RequestArena.hpp). A RequestJson must not
+// outlive the request that made it.
+using ArenaString = std::basic_string<char, std::char_traits<char>, util::ArenaAllocator<char>>;
+using RequestJson = nlohmann::basic_json<nlohmann::ordered_map, std::vector, ArenaString, bool, std::int64_t,
+                                         std::uint64_t, double, util::ArenaAllocator>;
+
+// A string field of a parsed body, without copying it; throws, like
+// get<std::string>(), if it is not a string.
+inline std::string_view jsonString(const RequestJson& j) {
+  return j.get_ref<const ArenaString&>();
+}
+
+inline void sendJson(httplib::Response& res, int status, const RequestJson& body) {
+  static const std::string kContentType = "application/json";
+  const ArenaString text = body.dump();
+  res.status = status;
+  res.set_content(text.data(), text.size(), kContentType);
+}
+
+// ----------------------
+// Records as JSON text
+// ----------------------
+//
+// Record responses are written straight into one arena string from the
+// schema (RecordSchema.hpp) instead of being built as a RequestJson and
+// dumped: no node per field, and no key strings copied. The text is byte for
+// byte what dump() prints for the same document.
+
+inline void appendJsonString(ArenaString& out, std::string_view s) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  out += '"';
+  std::size_t from = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    const auto c = static_cast<unsigned char>(s[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    out.append(s.data() + from, i - from);
+    from = i + 1;
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\b':
+        out += "\\b";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\f':
+        out += "\\f";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      default:
+        out += "\\u00";
+        out += kHex[c >> 4];
+        out += kHex[c & 0xf];
+        break;
+    }
+  }
+  out.append(s.data() + from, s.size() - from);
+  out += '"';
+}
+
+inline void appendJsonNumber(ArenaString& out, double v) {
+  if (!std::isfinite(v)) {
+    out += "null";
+    return;
+  }
+  char buf[64];
+  out.append(buf, nlohmann::detail::to_chars(buf, buf + sizeof(buf), v));  // what dump() uses
+}
+
+inline void appendJsonNumber(ArenaString& out, int v) {
+  char buf[16];
+  out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+}
+
+// {"id": "<id>", "datetime": ..., <the schema's API fields>}: a record as the
+// routes return it. `id` is the text to send (ids go out as strings).
+template <typename Schema>
+void appendRecordJson(ArenaString& out, std::string_view id, const typename Schema::View& r) {
+  out += "{\"id\":";
+  appendJsonString(out, id);
+  out += ",\"datetime\":";
+  appendJsonString(out, r.datetime.view());
+  forEachField<Schema>([&](const auto& f) {
+    if (!f.api) return;
+    out += ",\"";
+    out += f.key;
+    out += "\":";
+    if constexpr (std::decay_t<decltype(f)>::kNumber) {
+      appendJsonNumber(out, r.*f.view);
+    } else {
+      appendJsonString(out, r.*f.view);
+    }
+  });
+  out += '}';
+}
+
+template <typename Schema>
+void appendRecordJson(ArenaString& out, const typename Schema::View& r) {
+  char buf[24];
+  const char* end = std::to_chars(buf, buf + sizeof(buf), r.id).ptr;
+  appendRecordJson<Schema>(out, std::string_view(buf, static_cast<std::size_t>(end - buf)), r);
+}
+
+inline void sendJsonText(httplib::Response& res, int status, const ArenaString& text) {
+  static const std::string kContentType = "application/json";
+  res.status = status;
+  res.set_content(text.data(), text.size(), kContentType);
+}
+
+// The bearer token of the request, as a view into its Authorization header
+// (valid as long as `req`); empty if there is none. Allocates nothing.
+inline std::string_view getTokenFromAuthHeader(const httplib::Request& req) {
   auto it = req.headers.find("Authorization");
   if (it == req.headers.end()) {
-    return "";
+    return {};
   }
-  const std::string& auth = it->second;
-  const std::string prefix = "Bearer ";
+  const std::string_view auth = it->second;
+  constexpr std::string_view prefix = "Bearer ";
   if (auth.size() >= prefix.size() && auth.compare(0, prefix.size(), prefix) == 0) {
     return auth.substr(prefix.size());
   }
-  return "";
+  return {};
+}
+
+// Capture group `i` of the route pattern, as a view into the request path.
+inline std::string_view pathParam(const httplib::Request& req, std::size_t i) {
+  return std::string_view(req.path).substr(static_cast<std::size_t>(req.matches.position(i)),
+                                           static_cast<std::size_t>(req.matches.length(i)));
+}
+
+// ----------------------
+// List routes: ?from=&to=&limit=&cursor=
+// ----------------------
+//
+// `from` / `to` are datetimes as records take them (from inclusive, to
+// exclusive), `limit` caps the page, and `cursor` is the X-Next-Cursor header
+// of the previous page. Without any of them a list route returns the whole
+// list in insertion order, as it always did. With any of them records come
+// oldest first, and X-Next-Cursor is set while more remain.
+
+// A cursor names the last record sent, (timeMs, id), as 32 hex digits.
+inline std::string encodeCursor(std::int64_t timeMs, std::uint64_t id) {
+  char buf[33];
+  std::snprintf(buf, sizeof(buf), "%016llx%016llx", static_cast<unsigned long long>(timeMs),
+                static_cast<unsigned long long>(id));
+  return buf;
+}
+
+inline bool decodeCursor(std::string_view cursor, std::int64_t& timeMs, std::uint64_t& id) {
+  if (cursor.size() != 32) return false;
+  std::uint64_t parts[2] = {0, 0};
+  for (std::size_t i = 0; i < cursor.size(); ++i) {
+    const char c = cursor[i];
+    int v = 0;
+    if (c >= '0' && c <= '9') {
+      v = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      v = c - 'a' + 10;
+    } else {
+      return false;
+    }
+    parts[i / 16] = parts[i / 16] << 4 | static_cast<std::uint64_t>(v);
+  }
+  timeMs = static_cast<std::int64_t>(parts[0]);
+  id = parts[1];
+  return true;
+}
+
+// The value of query parameter `key`, as a view into `req`.
+inline std::string_view queryParam(const httplib::Request& req, const char* key) {
+  auto it = req.params.find(key);
+  return it == req.params.end() ? std::string_view() : std::string_view(it->second);
+}
+
+// False, with `error` set, if a parameter is malformed. `paged` says whether
+// any was given.
+inline bool parseRecordQuery(const httplib::Request& req, RecordQuery& q, bool& paged, std::string& error) {
+  paged = false;
+  if (req.has_param("from")) {
+    paged = true;
+    q.from = parseTimestamp(queryParam(req, "from"));
+    if (q.from == kNoTime) {
+      error = "Invalid from";
+      return false;
+    }
+  }
+  if (req.has_param("to")) {
+    paged = true;
+    q.to = parseTimestamp(queryParam(req, "to"));
+    if (q.to == kNoTime) {
+      error = "Invalid to";
+      return false;
+    }
+  }
+  if (req.has_param("limit")) {
+    paged = true;
+    try {
+      const long long n = std::stoll(std::string(queryParam(req, "limit")));
+      if (n <= 0) throw std::out_of_range("limit");
+      q.limit = static_cast<std::size_t>(n);
+    } catch (...) {
+      error = "Invalid limit";
+      return false;
+    }
+  }
+  if (req.has_param("cursor")) {
+    paged = true;
+    q.resume = decodeCursor(queryParam(req, "cursor"), q.afterTime, q.afterId);
+    if (!q.resume) {
+      error = "Invalid cursor";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Calls emit(view) for the records of `ranges` (RecordLists or their
+// TimeRanges, each already in `less` order) merged into one `less` order,
+// until emit returns false. Each record's view is made once.
+template <typename Range, typename Less, typename Emit>
+void mergeRecords(const std::vector<Range>& ranges, Less&& less, Emit&& emit) {
+  using It = decltype(ranges.front().begin());
+  using View = typename std::iterator_traits<It>::value_type;
+  struct Head {
+    It it, end;
+    View view;
+  };
+  std::vector<Head> heads;
+  heads.reserve(ranges.size());
+  for (const Range& r : ranges) {
+    if (r.begin() != r.end()) heads.push_back(Head{r.begin(), r.end(), *r.begin()});
+  }
+  while (!heads.empty()) {
+    std::size_t next = 0;
+    for (std::size_t i = 1; i < heads.size(); ++i) {
+      if (less(heads[i].view, heads[next].view)) next = i;
+    }
+    if (!emit(heads[next].view)) return;
+    Head& h = heads[next];
+    if (++h.it != h.end) {
+      h.view = *h.it;
+    } else {
+      heads.erase(heads.begin() + static_cast<std::ptrdiff_t>(next));
+    }
+  }
+}
+
+// The body of a GET list route. `fetch(query)` returns the lists holding
+// the collection (HealthBackend::queryRecords ...: the in-memory list, then
+// any archived segment the query reaches; no id is in two of them), whose
+// records are rendered with appendRecordJson<Schema>. The lists are merged:
+// by id without a query, by time with one. With a query, only the page is
+// rendered, so the response follows the page size rather than the length of
+// the history.
+template <typename Schema, typename Fetch>
+void sendRecordList(const httplib::Request& req, httplib::Response& res, Fetch&& fetch) {
+  using json = RequestJson;
+  RecordQuery q;
+  bool paged = false;
+  std::string error;
+  if (!parseRecordQuery(req, q, paged, error)) {
+    json err;
+    err["errorMessage"] = error;
+    sendJson(res, 400, err);
+    return;
+  }
+  const auto lists = fetch(q);
+  ArenaString out;
+  out += '[';
+  auto emit = [&out](const typename Schema::View& r) {
+    if (out.size() > 1) out += ',';
+    appendRecordJson<Schema>(out, r);
+  };
+  if (!paged) {
+    std::size_t total = 0;
+    for (const auto& list : lists) total += list.size();
+    out.reserve(total * 64 + 2);  // about one record's text each
+    mergeRecords(
+        lists, [](const auto& a, const auto& b) { return a.id < b.id; },
+        [&](const auto& r) {
+          emit(r);
+          return true;
+        });
+  } else {
+    // Each list's page holds the first `limit` of that list after the
+    // cursor, so the merged page is the first `limit` of their union.
+    using Page = decltype(lists.front().page(q));
+    std::vector<decltype(Page::records)> ranges;
+    bool more = false;
+    for (const auto& list : lists) {
+      const Page page = list.page(q);
+      ranges.push_back(page.records);
+      more = more || page.more;
+    }
+    std::size_t sent = 0;
+    std::int64_t lastTime = 0;
+    std::uint64_t lastId = 0;
+    mergeRecords(
+        ranges, [](const auto& a, const auto& b) { return a.timeMs < b.timeMs || (a.timeMs == b.timeMs && a.id < b.id); },
+        [&](const auto& r) {
+          if (q.limit > 0 && sent == q.limit) {
+            more = true;  // left over from another list's page
+            return false;
+          }
+          emit(r);
+          lastTime = r.timeMs;
+          lastId = r.id;
+          ++sent;
+          return true;
+        });
+    if (more) res.set_header("X-Next-Cursor", encodeCursor(lastTime, lastId));
+  }
+  out += ']';
+  sendJsonText(res, 200, out);
 }
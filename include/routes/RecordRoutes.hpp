@@ -0,0 +1,12 @@
+#pragma once
+
+#include "core/HealthBackend.hpp"
+
+namespace httplib {
+class Server;
+}
+
+// POST /<collection>, GET /<collection>, PATCH and DELETE /<collection>/{id}
+// for every schema in RecordSchemas (core/RecordSchema.hpp): /waters,
+// /sleeps and /activities.
+void registerRecordRoutes(httplib::Server& svr, HealthBackend& backend);
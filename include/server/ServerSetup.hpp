@@ -9,7 +9,8 @@ namespace server {
 // Initialize the global logger from environment variables `LOG_FILE` and `LOG_LEVEL`.
 void initLoggerFromEnv();
 
-// Configure server-wide handlers (CORS, exception handler, logging hooks, pre/post routing hooks).
+// Configure server-wide handlers (worker pool and request lanes, CORS, exception handler, logging hooks,
+// pre/post routing hooks).
 void setupServerCommon(httplib::Server &svr);
 
 // Prompt for (or detect) port and start the server (blocks until server stops).
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../third_party/httplib.h"
+
+namespace server {
+
+// httplib task queue: one task per accepted connection.
+//
+// Each of `workers` threads owns a deque. Connections are dealt round-robin
+// onto the deques. A worker serves its own deque from the front and, when it
+// is empty, steals from the back of the others, so no single queue lock is
+// shared by every accept and every worker.
+//
+// httplib only hands us whole connections, so requests cannot be routed to
+// a separate pool by type once parsed. Instead every request runs in a lane
+// (LaneScope, set up by setupServerCommon). Writes and logins go to the
+// write lane. At most `writeSlots` of them run at once, and while one runs
+// (or waits for a slot) its worker counts as blocked: the pool starts an
+// extra thread, up to `maxWorkers`, whenever fewer than `workers` threads
+// are left to serve everything else. Slow persistence therefore ties up
+// extra threads, never the ones that serve cheap GETs. Extra threads exit
+// after a second without work.
+class WorkStealingPool : public httplib::TaskQueue {
+ public:
+  struct Options {
+    std::size_t workers = 8;      // HTTP_WORKERS (default: httplib's pool size)
+    std::size_t maxWorkers = 32;  // HTTP_MAX_WORKERS: workers + extra threads (default 4x workers)
+    std::size_t writeSlots = 8;   // HTTP_WRITE_CONCURRENCY: writes running at once (default workers)
+    std::size_t maxQueued = 0;    // HTTP_MAX_QUEUED: connections waiting; 0 = unbounded
+  };
+  static Options optionsFromEnv();
+
+  explicit WorkStealingPool(const Options& opts);
+  ~WorkStealingPool() override;
+
+  bool enqueue(std::function<void()> fn) override;
+  void shutdown() override;
+
+  enum class Lane { Read, Write };
+
+  // One request on the calling worker's pool; a no-op off pool threads. A
+  // write waits for a write slot and counts as blocked until it ends.
+  class LaneScope {
+   public:
+    explicit LaneScope(Lane lane);
+    ~LaneScope();
+    LaneScope(const LaneScope&) = delete;
+    LaneScope& operator=(const LaneScope&) = delete;
+
+   private:
+    WorkStealingPool* pool_;
+    Lane lane_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  struct LaneStats {
+    std::uint64_t requests = 0;
+    std::size_t inFlight = 0;
+    std::size_t waiting = 0;  // write lane: waiting for a slot
+    double avgMs = 0.0;
+    double maxMs = 0.0;
+  };
+  struct Stats {
+    std::size_t workers = 0;
+    std::size_t maxWorkers = 0;
+    std::size_t threads = 0;  // workers + extra threads alive
+    std::size_t busy = 0;     // threads running a connection
+    std::size_t blocked = 0;  // threads inside the write lane
+    std::size_t queued = 0;   // connections waiting for a thread
+    std::uint64_t completed = 0;
+    std::uint64_t steals = 0;
+    std::uint64_t rejected = 0;       // over maxQueued
+    std::uint64_t extraStarted = 0;   // extra threads started so far
+    double queueWaitAvgMs = 0.0;      // accept → a thread picks the connection up
+    double queueWaitMaxMs = 0.0;
+    LaneStats read, write;
+  };
+  Stats stats() const;
+
+  // The pool currently serving (nullptr if none), for GET /admin/stats.
+  static WorkStealingPool* active();
+
+ private:
+  struct Task {
+    std::function<void()> fn;
+    std::chrono::steady_clock::time_point queuedAt;
+  };
+  struct Deque {
+    std::mutex mtx;
+    std::deque<Task> tasks;
+  };
+  struct LaneCounters {
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::size_t> inFlight{0};
+    std::atomic<std::size_t> waiting{0};
+    std::atomic<std::uint64_t> totalUs{0};
+    std::atomic<std::uint64_t> maxUs{0};
+  };
+
+  const Options opts_;
+  std::vector<std::unique_ptr<Deque>> deques_;
+  std::atomic<std::size_t> nextDeque_{0};
+
+  // Sleeping workers wait here; `queued_` counts tasks in the deques.
+  mutable std::mutex sleepMtx_;
+  std::condition_variable wake_;
+  std::atomic<std::size_t> queued_{0};
+  bool shutdown_ = false;
+
+  // Threads. Extra threads that exited are joined the next time one starts.
+  std::mutex threadsMtx_;
+  std::vector<std::thread> workers_;
+  std::map<std::uint64_t, std::thread> extras_;
+  std::vector<std::uint64_t> finished_;
+  std::uint64_t nextExtra_ = 0;
+  std::atomic<std::size_t> threads_{0};
+  std::atomic<std::size_t> blocked_{0};
+
+  // Write lane slots.
+  std::mutex slotsMtx_;
+  std::condition_variable slotFreed_;
+  std::size_t slotsUsed_ = 0;
+
+  std::atomic<std::size_t> busy_{0};
+  std::atomic<std::uint64_t> completed_{0}, steals_{0}, rejected_{0}, extraStarted_{0};
+  std::atomic<std::uint64_t> waitTotalUs_{0}, waitMaxUs_{0};
+  LaneCounters lanes_[2];
+
+  void workerLoop(std::size_t own, bool extra, std::uint64_t extraId);
+  bool take(std::size_t own, Task& out);
+  void beginBlocking();
+  void endBlocking();
+  void startExtraIfNeeded();
+  void acquireWriteSlot();
+  void releaseWriteSlot();
+};
+
+}  // namespace server
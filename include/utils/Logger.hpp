@@ -1,9 +1,11 @@
 #pragma once
 
-#include <string>
-#include <mutex>
+#include <atomic>
+#include <cstddef>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <string_view>
 
 namespace util {
 
@@ -14,18 +16,21 @@ public:
     static void init(const std::string &filePath, LogLevel level = LogLevel::Info);
     static void shutdown();
 
-    static void debug(const std::string &msg);
-    static void info(const std::string &msg);
-    static void warn(const std::string &msg);
-    static void error(const std::string &msg);
+    // Formats without allocating; check enabled() first to skip building
+    // a message that would be dropped.
+    static bool enabled(LogLevel level) { return level >= level_.load(std::memory_order_relaxed); }
+    static void debug(std::string_view msg);
+    static void info(std::string_view msg);
+    static void warn(std::string_view msg);
+    static void error(std::string_view msg);
 
 private:
-    static std::string timeStamp();
-    static void log(LogLevel level, const std::string &msg);
+    static std::size_t timeStamp(char *buf, std::size_t size);
+    static void log(LogLevel level, std::string_view msg);
 
     static std::mutex mtx_;
     static std::ofstream out_;    // optional file
-    static LogLevel level_;
+    static std::atomic<LogLevel> level_;
 };
 
 } // namespace util
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace util {
+
+// ----------------------
+// Per-request arena
+// ----------------------
+//
+// Each thread that serves requests owns a monotonic arena: allocating is a
+// pointer bump, freeing is a no-op, and reset() (called by the server when a
+// request starts) takes the whole arena back at once. The arena keeps its
+// buffer between requests and grows it after a request overflows, so a
+// worker serving similar requests stops calling malloc after warming up.
+//
+// Only request-scoped temporaries belong here: parsed request bodies,
+// response documents, scratch strings. Nothing allocated from it may outlive
+// the request (or be handed to another thread).
+//
+// REQUEST_ARENA_KB sets the starting buffer size per thread (default 64);
+// 0 turns the arena off, and resource() is then plain new / delete.
+class RequestArena {
+ public:
+  static bool enabled();
+  static std::pmr::memory_resource* resource();  // the calling thread's arena
+  static void reset();
+
+  struct Stats {
+    std::size_t bufferBytes = 0;    // the calling thread's buffer
+    std::size_t overflowBytes = 0;  // taken from the heap since the last reset
+  };
+  static Stats stats();
+};
+
+// Allocator for containers that live in the current request (RequestJson in
+// routes/Helpers.hpp). Stateless: it always uses the calling thread's arena,
+// so every instance compares equal.
+template <typename T>
+struct ArenaAllocator {
+  using value_type = T;
+
+  ArenaAllocator() noexcept = default;
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>&) noexcept {}  // NOLINT(google-explicit-constructor)
+
+  T* allocate(std::size_t n) { return static_cast<T*>(RequestArena::resource()->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T* p, std::size_t n) noexcept { RequestArena::resource()->deallocate(p, n * sizeof(T), alignof(T)); }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>&) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace util
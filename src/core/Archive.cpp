@@ -0,0 +1,70 @@
+#include "../../include/core/Archive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ostream>
+
+#include "../../include/core/SnapshotCodec.hpp"
+#include "../../include/core/SnapshotJson.hpp"
+
+using nlohmann::json;
+
+static long long envNumber(const char* name, long long fallback) {
+  const char* v = std::getenv(name);
+  if (!v || !*v) return fallback;
+  char* end = nullptr;
+  const long long n = std::strtoll(v, &end, 10);
+  return end == v || n < 0 ? fallback : n;
+}
+
+ArchivePolicy ArchivePolicy::fromEnv() {
+  ArchivePolicy p;
+  p.ageMs = static_cast<std::int64_t>(envNumber("STORAGE_ARCHIVE_DAYS", 0)) * 24 * 60 * 60 * 1000;
+  p.minRecords = static_cast<std::size_t>(std::max(1LL, envNumber("STORAGE_ARCHIVE_BATCH", 256)));
+  return p;
+}
+
+std::int64_t ArchivePolicy::cutoff() const {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count() - ageMs;
+}
+
+// One record per line, so a segment reads back with any JSON tool after gunzip.
+template <typename Rec>
+bool writeSegment(std::ostream& out, const std::vector<const Rec*>& records) {
+  out << '[';
+  for (std::size_t i = 0; i < records.size(); ++i) out << (i ? ",\n" : "\n") << toJson(*records[i]).dump();
+  out << "\n]\n";
+  return static_cast<bool>(out);
+}
+
+template <typename Rec>
+bool readSegment(const std::string& path, std::vector<Rec>& out) {
+  out.clear();
+  codec::CompressedIStream in(path);
+  if (!in) return false;
+  try {
+    const json arr = json::parse(in);
+    if (!arr.is_array()) return false;
+    out.reserve(arr.size());
+    for (const json& jr : arr) {
+      Rec r;
+      fromJson(jr, r);
+      out.push_back(std::move(r));
+    }
+    return true;
+  } catch (...) {
+    out.clear();
+    return false;
+  }
+}
+
+template bool writeSegment(std::ostream&, const std::vector<const WaterRecord*>&);
+template bool writeSegment(std::ostream&, const std::vector<const SleepRecord*>&);
+template bool writeSegment(std::ostream&, const std::vector<const ActivityRecord*>&);
+template bool writeSegment(std::ostream&, const std::vector<const CategoryItem*>&);
+template bool readSegment(const std::string&, std::vector<WaterRecord>&);
+template bool readSegment(const std::string&, std::vector<SleepRecord>&);
+template bool readSegment(const std::string&, std::vector<ActivityRecord>&);
+template bool readSegment(const std::string&, std::vector<CategoryItem>&);
@@ -0,0 +1,155 @@
+#include "../../include/core/BackgroundSnapshot.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "../../include/utils/Logger.hpp"
+
+static std::int64_t nowMs() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+const char* BackgroundSnapshot::stateName(State s) {
+  switch (s) {
+    case State::Running:
+      return "running";
+    case State::Succeeded:
+      return "succeeded";
+    case State::Failed:
+      return "failed";
+    case State::Idle:
+      break;
+  }
+  return "idle";
+}
+
+BackgroundSnapshot::~BackgroundSnapshot() {
+  wait();
+}
+
+bool BackgroundSnapshot::running() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return status_.state == State::Running;
+}
+
+BackgroundSnapshot::Status BackgroundSnapshot::status() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return status_;
+}
+
+void BackgroundSnapshot::wait() {
+  std::thread t;
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    t = std::move(monitor_);
+  }
+  if (t.joinable()) t.join();
+}
+
+bool BackgroundSnapshot::start(std::uint64_t journalSeq, Writer write, OnFinish onFinish) {
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (status_.state == State::Running) return false;
+  }
+  wait();  // reap the previous monitor thread
+
+  int fds[2];
+  if (::pipe(fds) != 0) return false;
+
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    util::Logger::error(std::string("Snapshot: fork failed: ") + std::strerror(errno));
+    return false;
+  }
+
+  if (pid == 0) {
+    // ---- child: only this thread exists here ----
+    ::close(fds[0]);
+    const int out = fds[1];
+    Progress progress = [out](std::size_t written, std::size_t total) {
+      char buf[64];
+      int n = std::snprintf(buf, sizeof(buf), "%zu %zu\n", written, total);
+      if (n > 0) (void)!::write(out, buf, static_cast<std::size_t>(n));
+    };
+    bool ok = false;
+    try {
+      ok = write(progress);
+    } catch (...) {
+      ok = false;
+    }
+    ::close(out);
+    // _exit: never run the parent's atexit handlers or destructors here.
+    ::_exit(ok ? 0 : 1);
+  }
+
+  ::close(fds[1]);
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    status_.state = State::Running;
+    status_.pid = pid;
+    status_.journalSeq = journalSeq;
+    status_.usersTotal = 0;
+    status_.usersWritten = 0;
+    status_.startedAtMs = nowMs();
+    status_.finishedAtMs = 0;
+    monitor_ = std::thread([this, fd = fds[0], pid, onFinish = std::move(onFinish)] { monitor(fd, pid, onFinish); });
+  }
+  util::Logger::info(std::string("Snapshot: background save started by pid ") + std::to_string(pid) +
+                     " (journalSeq=" + std::to_string(journalSeq) + ")");
+  return true;
+}
+
+void BackgroundSnapshot::monitor(int progressFd, pid_t pid, OnFinish onFinish) {
+  // Progress lines "<written> <total>\n" until the child closes the pipe.
+  std::string buf;
+  char chunk[256];
+  while (true) {
+    ssize_t n = ::read(progressFd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    buf.append(chunk, static_cast<std::size_t>(n));
+    std::size_t nl;
+    while ((nl = buf.find('\n')) != std::string::npos) {
+      std::size_t written = 0, total = 0;
+      if (std::sscanf(buf.c_str(), "%zu %zu", &written, &total) == 2) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        status_.usersWritten = written;
+        status_.usersTotal = total;
+      }
+      buf.erase(0, nl + 1);
+    }
+  }
+  ::close(progressFd);
+
+  int wstatus = 0;
+  while (::waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {
+  }
+  const bool ok = WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0;
+
+  if (onFinish) onFinish(ok);
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  status_.finishedAtMs = nowMs();
+  status_.pid = 0;
+  if (ok) {
+    status_.state = State::Succeeded;
+    status_.lastSuccessAtMs = status_.finishedAtMs;
+    status_.lastSuccessSeq = status_.journalSeq;
+    status_.lastError.clear();
+    util::Logger::info(std::string("Snapshot: background save done in ") +
+                       std::to_string(status_.finishedAtMs - status_.startedAtMs) + " ms");
+  } else {
+    status_.state = State::Failed;
+    status_.lastError = WIFSIGNALED(wstatus) ? "child killed by signal " + std::to_string(WTERMSIG(wstatus))
+                                             : "child exited with status " + std::to_string(WEXITSTATUS(wstatus));
+    util::Logger::error(std::string("Snapshot: background save failed: ") + status_.lastError);
+  }
+}
@@ -0,0 +1,120 @@
+#include "../../include/core/Epoch.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Hands the thread's reader record back to the domain when the thread exits.
+struct ThreadReader {
+  EpochDomain::Reader* reader = nullptr;
+  ~ThreadReader() {
+    if (reader) reader->inUse.store(false, std::memory_order_release);
+  }
+};
+
+thread_local ThreadReader tlsReader;
+
+}  // namespace
+
+EpochDomain& EpochDomain::global() {
+  static EpochDomain* domain = new EpochDomain();
+  return *domain;
+}
+
+// ----------------------
+// Readers
+// ----------------------
+
+EpochDomain::Reader* EpochDomain::acquireReader() {
+  for (Reader* r = readers_.load(std::memory_order_acquire); r; r = r->next) {
+    bool free = false;
+    if (!r->inUse.load(std::memory_order_relaxed) && r->inUse.compare_exchange_strong(free, true)) return r;
+  }
+  auto* r = new Reader();
+  r->inUse.store(true, std::memory_order_relaxed);
+  Reader* head = readers_.load(std::memory_order_relaxed);
+  do {
+    r->next = head;
+  } while (!readers_.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+  return r;
+}
+
+void EpochDomain::pin() {
+  if (!tlsReader.reader) tlsReader.reader = acquireReader();
+  Reader* r = tlsReader.reader;
+  if (r->depth++ > 0) return;
+  r->epoch.store(epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  // Announce the pin before the caller loads any protected pointer; pairs
+  // with the fence in retire().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochDomain::unpin() {
+  Reader* r = tlsReader.reader;
+  if (--r->depth == 0) r->epoch.store(0, std::memory_order_release);
+}
+
+EpochDomain::Guard::Guard() {
+  EpochDomain::global().pin();
+}
+
+EpochDomain::Guard::~Guard() {
+  EpochDomain::global().unpin();
+}
+
+std::uint64_t EpochDomain::oldestPinned() const {
+  std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+  for (Reader* r = readers_.load(std::memory_order_acquire); r; r = r->next) {
+    const std::uint64_t e = r->epoch.load(std::memory_order_acquire);
+    if (e != 0) oldest = std::min(oldest, e);
+  }
+  return oldest;
+}
+
+// ----------------------
+// Reclamation
+// ----------------------
+
+// A reader pinned at epoch <= E may still hold what was unlinked before the
+// bump to E + 1. One that pins later reads the new epoch, and (fences on
+// both sides) the new pointer too.
+void EpochDomain::retire(std::function<void()> free) {
+  std::vector<std::function<void()>> ready;
+  {
+    std::lock_guard<std::mutex> lk(retiredMtx_);
+    const std::uint64_t e = epoch_.fetch_add(1, std::memory_order_seq_cst);
+    retired_.push_back({e, std::move(free)});
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    takeFreeable(ready);
+  }
+  for (auto& f : ready) f();
+}
+
+std::size_t EpochDomain::collect() {
+  std::vector<std::function<void()>> ready;
+  {
+    std::lock_guard<std::mutex> lk(retiredMtx_);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    takeFreeable(ready);
+  }
+  for (auto& f : ready) f();
+  return ready.size();
+}
+
+void EpochDomain::takeFreeable(std::vector<std::function<void()>>& ready) {
+  const std::uint64_t oldest = oldestPinned();
+  auto keep = std::partition(retired_.begin(), retired_.end(), [oldest](const Retired& r) { return r.epoch >= oldest; });
+  for (auto it = keep; it != retired_.end(); ++it) ready.push_back(std::move(it->free));
+  freed_ += static_cast<std::uint64_t>(retired_.end() - keep);
+  retired_.erase(keep, retired_.end());
+}
+
+EpochDomain::Stats EpochDomain::stats() const {
+  std::lock_guard<std::mutex> lk(retiredMtx_);
+  Stats st;
+  st.epoch = epoch_.load();
+  st.pending = retired_.size();
+  st.freed = freed_;
+  return st;
+}
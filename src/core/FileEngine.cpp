@@ -0,0 +1,188 @@
+#include "../../include/core/FileEngine.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+
+#include "../../include/core/SnapshotJson.hpp"
+#include "../../include/core/UserOps.hpp"
+#include "../../include/utils/Logger.hpp"
+
+using nlohmann::json;
+
+FileEngine::FileEngine(std::string name, const std::string& path, Storage::Layout layout)
+    : name_(std::move(name)), storage_(std::make_unique<Storage>(path, layout)) {}
+
+FileEngine::~FileEngine() = default;
+
+// ----------------------
+// open：snapshot + journal replay
+// ----------------------
+
+bool FileEngine::open() {
+  std::unique_lock<std::shared_mutex> lk(mtx_);
+  users_.clear();
+
+  std::uint64_t snapshotSeq = 0;
+  if (!storage_->loadSnapshot(users_, snapshotSeq)) {
+    // Nothing on disk yet is fine; a snapshot we cannot read is not.
+    std::error_code ec;
+    const bool exists = std::filesystem::exists(storage_->path(), ec) || !storage_->shardFiles().empty();
+    if (exists) {
+      util::Logger::error(std::string("FileEngine: cannot read snapshot ") + storage_->path());
+      return false;
+    }
+    users_.clear();
+    snapshotSeq = 0;
+  }
+  for (auto& [_, u] : users_) u.bytes = approxBytes(u);
+
+  storage_->replayJournal(snapshotSeq, [this](const json& entry) { replayEntry(entry); });
+
+  std::uint64_t newest = snapshotSeq;
+  for (const auto& [_, u] : users_) newest = std::max(newest, u.persistedSeq);
+  storage_->advanceJournalSeq(newest);
+  return true;
+}
+
+// Same rules as HealthBackend::replayEntry: shards are stamped one by one, so
+// skip what a user's own snapshot already holds.
+void FileEngine::replayEntry(const json& entry) {
+  const std::string name = entry.value("user", "");
+  const std::uint64_t seq = entry.value("seq", std::uint64_t{0});
+  auto it = users_.find(name);
+  if (it != users_.end() && seq <= it->second.persistedSeq) return;
+
+  if (entry.value("op", "") == "user.create") {
+    UserData data;
+    profileFromJson(entry.value("profile", json::object()), data);
+    data.bytes = approxBytes(data);
+    data.lastSeq = seq;
+    data.dirty = true;
+    users_[name] = std::move(data);
+    return;
+  }
+  if (it == users_.end() || !applyUserOp(it->second, entry)) return;
+  it->second.lastSeq = seq;
+  it->second.dirty = true;
+}
+
+// ----------------------
+// Writes
+// ----------------------
+
+bool FileEngine::createUser(const UserData& user) {
+  const std::string& name = user.profile.name;
+  if (name.empty()) return false;
+
+  std::unique_lock<std::shared_mutex> lk(mtx_);
+  if (users_.count(name)) return false;
+
+  UserData data;
+  data.profile = user.profile;
+  data.password = user.password;
+  data.bytes = approxBytes(data);
+
+  json op;
+  op["op"] = "user.create";
+  op["user"] = name;
+  op["profile"] = profileToJson(data);
+  data.lastSeq = storage_->appendJournal(std::move(op));
+  data.dirty = true;
+  users_.emplace(name, std::move(data));
+  ++writes_;
+  return true;
+}
+
+json FileEngine::recordOp(const char* kind, const RecordRef& ref) {
+  json op = makeUserOp(kind, ref.coll.c_str());
+  if (ref.id != kAppend) op["id"] = ref.id;
+  if (ref.coll == "categories") op["category"] = ref.category;
+  return op;
+}
+
+bool FileEngine::putRecord(const std::string& user, const RecordRef& ref, const json& record) {
+  json op = recordOp(ref.id == kAppend ? "add" : "update", ref);
+  op["rec"] = record;
+  return commit(user, std::move(op));
+}
+
+bool FileEngine::deleteRecord(const std::string& user, const RecordRef& ref) {
+  if (ref.id == kAppend) return false;
+  return commit(user, recordOp("delete", ref));
+}
+
+bool FileEngine::createCategory(const std::string& user, const std::string& category) {
+  json op = makeUserOp("create", "categories");
+  op["category"] = category;
+  return commit(user, std::move(op));
+}
+
+bool FileEngine::dropCategory(const std::string& user, const std::string& category) {
+  json op = makeUserOp("drop", "categories");
+  op["category"] = category;
+  return commit(user, std::move(op));
+}
+
+bool FileEngine::commit(const std::string& user, json op) {
+  std::unique_lock<std::shared_mutex> lk(mtx_);
+  auto it = users_.find(user);
+  if (it == users_.end()) return false;
+  try {
+    assignRecordId(it->second, op);
+    if (!applyUserOp(it->second, op)) return false;
+  } catch (const json::exception&) {
+    return false;  // malformed record
+  }
+  op["user"] = user;
+  it->second.lastSeq = storage_->appendJournal(std::move(op));
+  it->second.dirty = true;
+  ++writes_;
+  return true;
+}
+
+// ----------------------
+// Reads
+// ----------------------
+
+bool FileEngine::loadUser(const std::string& user, UserData& out) const {
+  std::shared_lock<std::shared_mutex> lk(mtx_);
+  auto it = users_.find(user);
+  if (it == users_.end()) return false;
+  out = it->second;
+  return true;
+}
+
+void FileEngine::forEachUser(const std::function<void(const UserData&)>& fn) const {
+  std::shared_lock<std::shared_mutex> lk(mtx_);
+  for (const auto& [_, u] : users_) fn(u);
+}
+
+// ----------------------
+// Checkpoint
+// ----------------------
+
+bool FileEngine::checkpoint() {
+  std::unique_lock<std::shared_mutex> lk(mtx_);
+  const std::uint64_t seq = storage_->journalSeq();
+  if (!storage_->checkpoint(users_, seq)) return false;
+  for (auto& [_, u] : users_) {
+    if (!u.dirty) continue;
+    u.dirty = false;
+    u.persistedSeq = seq;
+  }
+  ++checkpoints_;
+  return true;
+}
+
+StorageEngine::Stats FileEngine::stats() const {
+  Stats st;
+  {
+    std::shared_lock<std::shared_mutex> lk(mtx_);
+    st.users = users_.size();
+  }
+  st.writes = writes_;
+  st.checkpoints = checkpoints_;
+  st.journalBytes = storage_->journalBytes();
+  return st;
+}
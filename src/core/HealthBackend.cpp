@@ -2,7 +2,9 @@
 
 #include <unistd.h>  // readlink
 
+#include "../../include/core/SnapshotJson.hpp"
 #include "../../include/core/Storage.hpp"
+#include "../../include/core/UserOps.hpp"
 #include "../../third_party/json.hpp"
 #ifdef __APPLE__
 #include <mach-o/dyld.h>  // _NSGetExecutablePath
@@ -11,9 +13,12 @@
 #include <sys/stat.h>  // stat, mkdir
 #include <sys/types.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <shared_mutex>
 
 #include "../../include/utils/Logger.hpp"
 
@@ -26,14 +31,35 @@ using nlohmann::json;
 // 建構 / 解構：處理載入 / 儲存
 // ----------------------
 
-HealthBackend::HealthBackend() {
+// STORAGE_WARMUP = blocking | background (default blocking)
+// EXECUTOR_SHARDS = 0 | N | auto (default 0: writers lock the user's stripe)
+HealthBackend::HealthBackend() : cache_(UserCache::budgetFromEnv()) {
+  if (const std::size_t shards = ShardExecutor::shardsFromEnv()) executor_ = std::make_unique<ShardExecutor>(shards);
   storage_ = std::make_unique<Storage>();
+  if (const char* env = std::getenv("STORAGE_WARMUP")) background_ = std::string(env) == "background";
+
+  const bool sharded = storage_->layout() == Storage::Layout::Sharded;
+  if (cache_.bounded() && !sharded) {
+    util::Logger::warn("STORAGE_CACHE_BYTES needs STORAGE_LAYOUT=sharded; keeping every user in memory");
+  }
+  lazy_ = sharded && (cache_.bounded() || background_);
+
+  if (background_) {
+    startWarmup();
+    return;
+  }
   loadFromFile();
+  markReady();
 }
 
 HealthBackend::~HealthBackend() {
   try {
+    executor_.reset();  // runs what was handed to the shards, then joins them
+    stopWarmup_ = true;
+    for (auto& t : warmers_) t.join();
+    snapshotter_.wait();
     saveToFile();
+    for (auto& [_, u] : usersByName) retireVersion(u);
   } catch (...) {
     // 不讓 destructor 拋例外
   }
@@ -82,173 +108,476 @@ std::string HealthBackend::generateToken() const {
 // ----------------------
 
 void HealthBackend::loadFromFile() {
-  // Load from storage
-  json j = storage_->load();
-  if (j.is_null()) {
-    // file missing or parse error → treat as empty DB
-    return;
+  std::uint64_t snapshotSeq = 0;
+  std::uint64_t manifestSeq = 0;
+  if (lazy_ && storage_->readManifest(manifestSeq)) {
+    // Users are paged in on first access; replay pages in whoever the
+    // journal touches and skips what their shard already holds.
+    snapshotSeq = 0;
+  } else {
+    // Load from storage; file missing or parse error → treat as empty DB
+    storage_->loadSnapshot(usersByName, snapshotSeq);
+    for (auto& [name, u] : usersByName) {
+      u.handle = handleFor(name);
+      u.bytes = approxBytes(u);
+      cache_.admit(name, u.bytes, false);
+    }
   }
 
-  if (!j.contains("users") || !j["users"].is_array()) {
-    return;
+  // Re-apply everything that happened after the snapshot was taken. With
+  // shards, replayEntry skips what each user's shard already holds.
+  std::size_t replayed = storage_->replayJournal(snapshotSeq, [this](const json& entry) { replayEntry(entry); });
+  if (replayed > 0) {
+    util::Logger::info(std::string("Replayed ") + std::to_string(replayed) + " journal entries");
   }
 
-  for (const auto& ju : j["users"]) {
-    if (!ju.contains("name")) continue;
-    std::string name = ju.value("name", "");
+  std::uint64_t newest = std::max(snapshotSeq, manifestSeq);
+  for (const auto& [_, u] : usersByName) newest = std::max(newest, u.persistedSeq);
+  storage_->advanceJournalSeq(newest);
 
-    UserData data;
-    data.profile.id = ju.value("id", name);
-    data.profile.name = name;
-    data.profile.age = ju.value("age", 0);
-    data.profile.weightKg = ju.value("weightKg", 0.0);
-    data.profile.heightM = ju.value("heightM", 0.0);
-    data.profile.gender = ju.value("gender", std::string("other"));
-
-    data.password = ju.value("password", std::string(""));
-
-    // Waters
-    if (ju.contains("waters") && ju["waters"].is_array()) {
-      for (const auto& jw : ju["waters"]) {
-        WaterRecord w;
-        w.datetime = jw.value("datetime", std::string(""));
-        w.amountMl = jw.value("amountMl", 0.0);
-        data.waters.push_back(w);
-      }
-    }
+  if (cache_.overBudget()) evictColdUsers();
+}
 
-    // Sleeps
-    if (ju.contains("sleeps") && ju["sleeps"].is_array()) {
-      for (const auto& js : ju["sleeps"]) {
-        SleepRecord s;
-        s.datetime = js.value("datetime", std::string(""));
-        s.hours = js.value("hours", 0.0);
-        data.sleeps.push_back(s);
-      }
-    }
+// ----------------------
+// Background warm-up
+// ----------------------
 
-    // Activities
-    if (ju.contains("activities") && ju["activities"].is_array()) {
-      for (const auto& ja : ju["activities"]) {
-        ActivityRecord a;
-        a.datetime = ja.value("datetime", std::string(""));
-        a.minutes = ja.value("minutes", 0);
-        a.intensity = ja.value("intensity", std::string(""));
-        data.activities.push_back(a);
-      }
+void HealthBackend::startWarmup() {
+  std::uint64_t manifestSeq = 0;
+  if (!lazy_ || !storage_->readManifest(manifestSeq)) {
+    // No way to load a single user yet (one snapshot file, or shards
+    // written before MANIFEST existed): load everything on one thread and
+    // let lookups wait for it.
+    lookupsWait_ = true;
+    warmersLeft_ = 1;
+    warmers_.emplace_back([this] {
+      loadFromFile();
+      markReady();
+    });
+    return;
+  }
+
+  // The journal is short (bounded by the checkpoint size) and has to be
+  // replayed before the first append, so that part stays synchronous; it
+  // only pages in the users it touches.
+  loadFromFile();
+
+  warmFiles_ = storage_->shardFiles();
+  std::size_t workers = 1;
+  if (const char* env = std::getenv("STORAGE_WARMUP_THREADS")) {
+    try {
+      workers = std::max(1L, std::stol(env));
+    } catch (...) {
+      // keep default
     }
+  } else {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers = std::min(workers, warmFiles_.size() / 16 + 1);
+  util::Logger::info(std::string("Warm-up: loading ") + std::to_string(warmFiles_.size()) + " shards on " +
+                     std::to_string(workers) + " threads");
+  warmersLeft_ = workers;
+  for (std::size_t i = 0; i < workers; ++i) warmers_.emplace_back([this] { warmShards(); });
+}
 
-    // Categories
-    if (ju.contains("categories") && ju["categories"].is_object()) {
-      for (auto it = ju["categories"].begin(); it != ju["categories"].end(); ++it) {
-        const std::string catName = it.key();
-        const auto& arr = it.value();
-        if (!arr.is_array()) continue;
-
-        std::vector<CategoryItem> items;
-        for (const auto& ji : arr) {
-          CategoryItem item;
-          item.datetime = ji.value("datetime", std::string(""));
-          item.note = ji.value("note", std::string(""));
-          item.value = ji.value("value", 0.0);
-          items.push_back(item);
+void HealthBackend::warmShards() {
+  while (!stopWarmup_) {
+    const std::size_t i = warmNext_++;
+    if (i >= warmFiles_.size()) break;
+    // Requests waiting on a user go first.
+    while (demand_ > 0 && !stopWarmup_) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // With a bounded cache, leave the rest of the room to active users.
+    if (cache_.bounded() && cache_.residentBytes() >= cache_.target()) break;
+
+    UserMap loaded;
+    const std::uint64_t gen = evictGen_.load();
+    if (storage_->loadShardFile(warmFiles_[i], loaded)) {
+      std::unique_lock<std::shared_mutex> users(usersMtx_);
+      // After an eviction the file we read may be older than the shard now on disk.
+      if (gen == evictGen_.load()) {
+        for (auto& [name, u] : loaded) {
+          if (!usersByName.count(name)) admitUser(name, std::move(u), false);
         }
-        data.categories[catName] = std::move(items);
       }
     }
+    ++warmLoaded_;
+  }
+  if (--warmersLeft_ == 0) markReady();
+}
 
-    usersByName[name] = std::move(data);
+void HealthBackend::markReady() {
+  {
+    std::lock_guard<std::mutex> lk(readyMtx_);
+    readyAfterMs_ = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                          startedAt_)
+                        .count();
+    ready_ = true;
+  }
+  readyCv_.notify_all();
+  if (background_) {
+    util::Logger::info(std::string("Warm-up: ready after ") + std::to_string(readyAfterMs_.load()) + " ms");
   }
 }
 
-void HealthBackend::saveToFile() const {
-  json j;
-  j["users"] = json::array();
+void HealthBackend::waitReady() const {
+  if (!lookupsWait_ || ready_) return;
+  std::unique_lock<std::mutex> lk(readyMtx_);
+  readyCv_.wait(lk, [this] { return ready_.load(); });
+}
 
-  for (const auto& [name, data] : usersByName) {
-    json ju;
-    ju["id"] = data.profile.id;
-    ju["name"] = data.profile.name;
-    ju["age"] = data.profile.age;
-    ju["weightKg"] = data.profile.weightKg;
-    ju["heightM"] = data.profile.heightM;
-    ju["gender"] = data.profile.gender;
+HealthBackend::WarmupStatus HealthBackend::warmupStatus() const {
+  WarmupStatus st;
+  st.ready = ready_;
+  st.mode = background_ ? "background" : "blocking";
+  st.usersLoaded = warmLoaded_;
+  st.usersTotal = warmFiles_.size();
+  const std::int64_t readyAfter = readyAfterMs_;
+  st.elapsedMs = readyAfter >= 0 ? readyAfter
+                                 : std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       std::chrono::steady_clock::now() - startedAt_)
+                                       .count();
+  return st;
+}
 
-    ju["password"] = data.password;
+// Foreground checkpoint (shutdown): snapshot + empty journal.
+void HealthBackend::saveToFile() {
+  std::shared_lock<std::shared_mutex> users(usersMtx_);
+  std::unique_lock<std::shared_mutex> gate(snapshotGate_);
+  const std::uint64_t seq = storage_->journalSeq();
+  if (!storage_->checkpoint(usersByName, seq)) {
+    util::Logger::error(std::string("Failed to open ") + storage_->path() + " for writing.");
+    return;
+  }
+  markPersisted(seq);
+  removeRetiredSegments(seq);
+}
 
-    // Waters
-    ju["waters"] = json::array();
-    for (const auto& w : data.waters) {
-      json jw;
-      jw["datetime"] = w.datetime;
-      jw["amountMl"] = w.amountMl;
-      ju["waters"].push_back(jw);
+// Caller holds snapshotGate_ exclusively. Users changed after `seq` stay dirty.
+void HealthBackend::markPersisted(std::uint64_t seq) {
+  for (auto& [_, u] : usersByName) {
+    if (u.dirty && u.lastSeq <= seq) {
+      u.dirty = false;
+      u.persistedSeq = seq;
     }
+  }
+}
 
-    // Sleeps
-    ju["sleeps"] = json::array();
-    for (const auto& s : data.sleeps) {
-      json js;
-      js["datetime"] = s.datetime;
-      js["hours"] = s.hours;
-      ju["sleeps"].push_back(js);
-    }
+// ----------------------
+// Journal：每次修改只 append 一筆
+// ----------------------
 
-    // Activities
-    ju["activities"] = json::array();
-    for (const auto& a : data.activities) {
-      json ja;
-      ja["datetime"] = a.datetime;
-      ja["minutes"] = a.minutes;
-      ja["intensity"] = a.intensity;
-      ju["activities"].push_back(ja);
+// Live requests and startup replay both mutate through here, so a replayed
+// journal always reproduces exactly what the requests did.
+bool HealthBackend::applyOp(UserData& user, const json& op) {
+  const std::size_t before = user.bytes;
+  if (!applyUserOp(user, op)) return false;
+  cache_.resize(static_cast<std::int64_t>(user.bytes) - static_cast<std::int64_t>(before));
+  return true;
+}
+
+// The op is logged before it is applied: a rejected sync append leaves the
+// user as it was, so false always means "not applied".
+bool HealthBackend::commit(UserData& user, json op) {
+  {
+    std::shared_lock<std::shared_mutex> gate(snapshotGate_);
+    if (!canApplyUserOp(user, op)) return false;
+    op["user"] = user.profile.name;
+    const std::uint64_t seq = logMutation(op);
+    if (seq == 0) return false;
+    if (!applyOp(user, op)) {
+      // canApplyUserOp said yes; replay skips the entry the same way.
+      util::Logger::error(std::string("Journal entry seq=") + std::to_string(seq) + " did not apply");
+      return false;
     }
+    publish(user, op);
+    user.lastSeq = seq;
+    user.dirty = true;
+  }
+  // Fold the journal into a fresh snapshot once it gets large. The caller's
+  // UserRef already holds usersMtx_.
+  if (storage_->needsCheckpoint()) startBackgroundSnapshotLocked();
+  return true;
+}
 
-    // Categories
-    ju["categories"] = json::object();
-    for (const auto& [catName, items] : data.categories) {
-      json arr = json::array();
-      for (const auto& item : items) {
-        json ji;
-        ji["datetime"] = item.datetime;
-        ji["note"] = item.note;
-        ji["value"] = item.value;
-        arr.push_back(ji);
-      }
-      ju["categories"][catName] = arr;
+std::uint64_t HealthBackend::commitAdd(std::string_view token, json op) {
+  std::uint64_t id = 0;
+  withUser(token, [&](UserData& user) {
+    std::string coll, category;
+    if (archive_.enabled()) {
+      coll = op.value("coll", "");
+      category = op.value("category", "");
     }
+    const std::uint64_t next = assignRecordId(user, op);
+    if (commit(user, std::move(op))) id = next;
+    // Tiering: once enough of this collection has aged, cut a segment.
+    if (id != 0 && archive_.enabled()) archiveCollection(user, coll, category, archive_.minRecords);
+    return id != 0;
+  });
+  return id;
+}
+
+// Caller is the user's only writer (withUser), so versions are published in
+// commit order.
+void HealthBackend::publish(UserData& user, const json& op) {
+  const UserVersion* prev = user.handle->published.load();
+  if (!prev) return;  // never read yet; the first reader publishes
+  auto next = nextUserVersion(*prev, user, op.value("coll", ""), op.value("category", ""));
+  user.handle->published.exchange(next.release());
+  EpochDomain::global().retire([prev] { delete prev; });
+}
+
+void HealthBackend::retireVersion(UserData& user) const {
+  if (const UserVersion* v = user.handle->published.exchange(nullptr)) {
+    EpochDomain::global().retire([v] { delete v; });
+  }
+}
 
-    j["users"].push_back(ju);
+// Caller holds snapshotGate_ (shared) so the change and its journal entry
+// land on the same side of a snapshot's fork. Returns the entry's seq.
+std::uint64_t HealthBackend::logMutation(json op) {
+  std::uint64_t seq = storage_->appendJournal(std::move(op));
+  if (seq == 0) {
+    util::Logger::error(std::string("Failed to append to journal for ") + storage_->path());
   }
+  return seq;
+}
 
-  if (!storage_->save(j)) {
-    util::Logger::error(std::string("Failed to open ") + storage_->path() + " for writing.");
+// ----------------------
+// Background snapshot (fork)
+// ----------------------
+
+bool HealthBackend::startBackgroundSnapshot() {
+  waitReady();
+  std::shared_lock<std::shared_mutex> users(usersMtx_);
+  return startBackgroundSnapshotLocked();
+}
+
+// Caller holds usersMtx_ (either way), so no user is paged in or out meanwhile.
+bool HealthBackend::startBackgroundSnapshotLocked() {
+  // Exclusive gate: no mutation is half-applied while we seal and fork.
+  std::unique_lock<std::shared_mutex> gate(snapshotGate_);
+  if (snapshotter_.running()) return false;
+
+  if (!storage_->sealJournal()) {
+    util::Logger::error(std::string("Snapshot: failed to seal journal for ") + storage_->path());
+    return false;
+  }
+  const std::uint64_t seq = storage_->journalSeq();
+  return snapshotter_.start(
+      seq,
+      [this, seq](const BackgroundSnapshot::Progress& progress) {
+        // Child process: the copy-on-write image is frozen at `seq`.
+        return storage_->saveSnapshot(usersByName, seq, progress);
+      },
+      [this, seq](bool ok) {
+        // Sealed entries are all <= seq; keep them if the snapshot failed.
+        if (!ok) return;
+        storage_->dropSealedJournal();
+        removeRetiredSegments(seq);
+        std::shared_lock<std::shared_mutex> users(usersMtx_);
+        std::unique_lock<std::shared_mutex> gate(snapshotGate_);
+        markPersisted(seq);
+      });
+}
+
+BackgroundSnapshot::Status HealthBackend::snapshotStatus() const {
+  return snapshotter_.status();
+}
+
+void HealthBackend::replayEntry(const json& entry) {
+  const std::string name = entry.value("user", "");
+  const std::uint64_t seq = entry.value("seq", std::uint64_t{0});
+  auto it = usersByName.find(name);
+  if (it == usersByName.end() && lazy_ && pageIn(name)) it = usersByName.find(name);
+  // Already in this user's snapshot (shards are stamped independently).
+  if (it != usersByName.end() && seq <= it->second.persistedSeq) return;
+
+  if (entry.value("op", "") == "user.create") {
+    UserData data;
+    profileFromJson(entry.value("profile", json::object()), data);
+    data.lastSeq = seq;
+    data.dirty = true;
+    if (it != usersByName.end()) {
+      retireVersion(it->second);
+      cache_.evict(name, it->second.bytes);
+      usersByName.erase(it);
+    }
+    admitUser(name, std::move(data), false);
+    if (cache_.overBudget()) evictColdUsers();
+    return;
+  }
+
+  if (it == usersByName.end() || !applyOp(it->second, entry)) {
+    util::Logger::warn(std::string("Journal: skipping unappliable entry seq=") + std::to_string(seq) +
+                       " user=" + name);
     return;
   }
+  it->second.lastSeq = seq;
+  it->second.dirty = true;
+  if (cache_.overBudget()) evictColdUsers();
+}
+
+// ----------------------
+// User cache：lazy load / LRU eviction
+// ----------------------
+
+void HealthBackend::admitUser(const std::string& name, UserData data, bool miss) const {
+  data.handle = handleFor(name);
+  data.bytes = approxBytes(data);
+  const std::size_t bytes = data.bytes;
+  usersByName.emplace(name, std::move(data));
+  cache_.admit(name, bytes, miss);
+}
+
+UserHandle* HealthBackend::handleFor(const std::string& name) const {
+  auto& handle = handles_[name];
+  if (!handle) handle = std::make_unique<UserHandle>(name);
+  return handle.get();
+}
+
+// Load `name` from its shard if it is not resident. False if there is no such user.
+bool HealthBackend::pageIn(const std::string& name) const {
+  if (usersByName.count(name)) return true;
+  if (!lazy_) return false;
+  UserData data;
+  if (!storage_->loadUser(name, data)) return false;
+  admitUser(name, std::move(data), true);
+  return true;
+}
+
+// Miss path for lookups and login. The shard is read without holding
+// usersMtx_, so warm-up threads and other requests keep going, and the
+// result is inserted under the exclusive lock, which is left held in `ex`.
+HealthBackend::UserData* HealthBackend::loadOnDemand(const std::string& name,
+                                                     std::unique_lock<std::shared_mutex>& ex) const {
+  ++demand_;
+  UserData data;
+  const std::uint64_t gen = evictGen_.load();
+  const bool found = storage_->loadUser(name, data);
+  ex = std::unique_lock<std::shared_mutex>(usersMtx_);
+  --demand_;
+
+  auto it = usersByName.find(name);
+  if (it != usersByName.end()) {
+    // Someone else (a warm-up thread, another request) got there first.
+    cache_.hit(name);
+    return &it->second;
+  }
+  if (gen != evictGen_.load()) {
+    // An eviction may have rewritten the shard while we read it.
+    if (!pageIn(name)) return nullptr;
+  } else if (found) {
+    admitUser(name, std::move(data), true);
+  } else {
+    return nullptr;
+  }
+  return &usersByName.find(name)->second;
+}
+
+// Drop least recently used users until we are back under the budget. Dirty
+// users are written to their shard first, except while a background
+// snapshot runs: its child may be writing the very same shard.
+void HealthBackend::evictColdUsers() const {
+  if (!lazy_) return;
+  std::unique_lock<std::shared_mutex> users(usersMtx_);
+  if (!cache_.overBudget()) return;
+
+  const bool snapshotRunning = snapshotter_.running();
+  for (const std::string& name : cache_.coldest()) {
+    if (cache_.residentBytes() <= cache_.target()) break;
+    auto it = usersByName.find(name);
+    if (it == usersByName.end()) continue;
+    UserData& u = it->second;
+    if (u.dirty) {
+      if (snapshotRunning) continue;
+      if (!storage_->saveUser(name, u, std::max(u.lastSeq, u.persistedSeq))) {
+        util::Logger::error(std::string("Cache: failed to write shard for ") + name + ", keeping it resident");
+        continue;
+      }
+    }
+    retireVersion(u);
+    cache_.evict(name, u.bytes);
+    usersByName.erase(it);
+    ++evictGen_;
+  }
 }
 
 // ----------------------
 // Token → UserData
 // ----------------------
 
-HealthBackend::UserData* HealthBackend::getUserByToken(const std::string& token) {
-  auto itTok = tokenToName.find(token);
-  if (itTok == tokenToName.end()) return nullptr;
-  auto itUser = usersByName.find(itTok->second);
-  if (itUser == usersByName.end()) return nullptr;
-  return &itUser->second;
+template <typename T>
+HealthBackend::UserRef<T> HealthBackend::acquireUser(std::string_view token) const {
+  waitReady();
+  if (cache_.overBudget()) evictColdUsers();
+
+  const UserHandle* handle = tokens_.find(token);
+  if (!handle) return {};
+  const std::string& name = handle->name;
+  {
+    std::shared_lock<std::shared_mutex> lk(usersMtx_);
+    auto itUser = usersByName.find(name);
+    if (itUser != usersByName.end()) {
+      cache_.hit(name);
+      return UserRef<T>(std::move(lk), stripeFor(name), &itUser->second);
+    }
+    if (!lazy_) return {};
+  }
+
+  // Miss: page the user in and keep the exclusive hold for this one call, so
+  // an evictor cannot take it away again before the caller gets to it.
+  std::unique_lock<std::shared_mutex> ex;
+  UserData* user = loadOnDemand(name, ex);
+  if (!user) return {};
+  return UserRef<T>(std::move(ex), stripeFor(name), user);
+}
+
+std::shared_mutex* HealthBackend::stripeFor(const std::string& name) const {
+  if (executor_) return nullptr;
+  return &userStripes_[std::hash<std::string>{}(name) % kUserStripes];
 }
 
-const HealthBackend::UserData* HealthBackend::getUserByToken(const std::string& token) const {
-  auto itTok = tokenToName.find(token);
-  if (itTok == tokenToName.end()) return nullptr;
-  auto itUser = usersByName.find(itTok->second);
-  if (itUser == usersByName.end()) return nullptr;
-  return &itUser->second;
+// Locked: the stripe makes this thread the user's only writer. Shard-per-core:
+// the user's shard is, so hop there first; the token → name lookup is
+// lock-free and the handle outlives the user's residency.
+template <typename F>
+bool HealthBackend::withUser(std::string_view token, F&& fn) const {
+  if (!executor_) {
+    auto user = acquireUser<UserData>(token);
+    return user && fn(*user);
+  }
+  const UserHandle* handle = tokens_.find(token);
+  if (!handle) return false;
+  bool ok = false;
+  executor_->run(executor_->shardFor(handle->name), [&] {
+    auto user = acquireUser<UserData>(token);
+    ok = user && fn(*user);
+  });
+  return ok;
 }
 
-bool HealthBackend::hasUserForToken(const std::string& token) const {
-  return getUserByToken(token) != nullptr;
+// Hit: token → handle → version, two lock-free loads. The pin keeps the
+// version alive even if a write replaces it or the user is evicted meanwhile.
+HealthBackend::PinnedVersion::PinnedVersion(const HealthBackend& backend, std::string_view token) {
+  backend.waitReady();
+  const UserHandle* handle = backend.tokens_.find(token);
+  if (!handle) return;
+  version_ = handle->published.load();
+  if (version_) {
+    backend.cache_.hit(handle->name);
+    return;
+  }
+
+  // Never read, or paged out: page in / publish as the user's writer.
+  backend.withUser(token, [this](UserData& user) {
+    if (!user.handle->published.load()) user.handle->published.exchange(makeUserVersion(user).release());
+    version_ = user.handle->published.load();
+    return true;
+  });
+}
+
+bool HealthBackend::hasUserForToken(std::string_view token) const {
+  return static_cast<bool>(PinnedVersion(*this, token));
 }
 
 // ----------------------
@@ -260,7 +589,10 @@ bool HealthBackend::registerUser(const std::string& name, int age, double weight
   if (name.empty() || password.empty()) return false;
   if (age <= 0 || weightKg <= 0.0 || heightM <= 0.0) return false;
 
-  if (usersByName.find(name) != usersByName.end()) {
+  waitReady();
+  if (cache_.overBudget()) evictColdUsers();
+  std::unique_lock<std::shared_mutex> users(usersMtx_);
+  if (usersByName.find(name) != usersByName.end() || (lazy_ && storage_->userExists(name))) {
     // User already exists
     return false;
   }
@@ -274,39 +606,65 @@ bool HealthBackend::registerUser(const std::string& name, int age, double weight
   data.profile.gender = gender;
   data.password = password;
 
-  usersByName[name] = std::move(data);
-  saveToFile();
-  util::Logger::info(std::string("New User Registered: ") + usersByName[name].profile);
+  json op;
+  op["op"] = "user.create";
+  op["user"] = name;
+  op["profile"] = profileToJson(data);
+
+  const std::string registered = std::string("New User Registered: ") + data.profile;
+  {
+    std::shared_lock<std::shared_mutex> gate(snapshotGate_);
+    data.lastSeq = logMutation(std::move(op));
+    if (data.lastSeq == 0) return false;  // a rejected sync append: not registered
+    data.dirty = true;
+    admitUser(name, std::move(data), false);
+  }
+  if (storage_->needsCheckpoint()) startBackgroundSnapshotLocked();
+  util::Logger::info(registered);
   return true;
 }
 
 std::string HealthBackend::login(const std::string& name, const std::string& password) {
+  waitReady();
+  if (cache_.overBudget()) evictColdUsers();
+  // The password never changes after registration, so the directory hold is
+  // enough to read it; no stripe needed.
+  std::shared_lock<std::shared_mutex> users(usersMtx_);
+  std::unique_lock<std::shared_mutex> pagedIn;  // held instead when the user had to be loaded
+  const UserData* user = nullptr;
   auto it = usersByName.find(name);
-  if (it == usersByName.end()) {
+  if (it != usersByName.end()) {
+    cache_.hit(name);
+    user = &it->second;
+  } else if (lazy_) {
+    users.unlock();
+    user = loadOnDemand(name, pagedIn);
+  }
+  if (!user) {
     util::Logger::warn(std::string("login: user not found: ") + name);
     return "INVALID";
   }
-  if (it->second.password != password) {
+  if (user->password != password) {
     util::Logger::warn(std::string("login: bad password for user: ") + name);
     return "INVALID";
   }
 
-  // 產生新的 token
+  // 產生新的 token（重複的機率極低，但還是換一個）
   std::string token = generateToken();
-  tokenToName[token] = name;
+  while (!tokens_.insert(token, user->handle)) token = generateToken();
   util::Logger::info(std::string("login: user= ") + name + " token=" + token);
   return token;
 }
 
-bool HealthBackend::getUserProfile(const std::string& token, UserProfile& outProfile) const {
-  const UserData* user = getUserByToken(token);
+bool HealthBackend::getUserProfile(std::string_view token, UserProfile& outProfile) const {
+  PinnedVersion user(*this, token);
   if (!user) return false;
   outProfile = user->profile;
   return true;
 }
 
-double HealthBackend::getBMI(const std::string& token) const {
-  const UserData* user = getUserByToken(token);
+double HealthBackend::getBMI(std::string_view token) const {
+  PinnedVersion user(*this, token);
   if (!user) return 0.0;
 
   double height = user->profile.heightM;
@@ -320,242 +678,525 @@ double HealthBackend::getBMI(const std::string& token) const {
 }
 
 // ----------------------
-// Waters
+// Record collections (RecordSchema.hpp)
 // ----------------------
 
-bool HealthBackend::addWater(const std::string& token, const std::string& datetime, double amountMl) {
-  if (amountMl <= 0.0 || amountMl >= 5000.0) return false;
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
+template <typename Schema>
+std::uint64_t HealthBackend::addRecord(std::string_view token, typename Schema::Record rec) {
+  if (!validRecord<Schema>(rec)) {
+    util::Logger::warn(std::string("add: ") + Schema::kNoun + " record out of range");
+    return 0;
+  }
+  rec.id = 0;
+  json op = makeUserOp("add", Schema::kCollection);
+  op["rec"] = recordToJson<Schema>(rec);
+  return commitAdd(token, std::move(op));
+}
 
-  WaterRecord w;
-  w.datetime = datetime;
-  w.amountMl = amountMl;
-  user->waters.push_back(w);
-  saveToFile();
-  return true;
+template <typename Schema>
+RecordList<typename Schema::Record> HealthBackend::getRecords(std::string_view token) const {
+  PinnedVersion user(*this, token);
+  if (!user) return {};
+  return Schema::published(*user);
+}
+
+template <typename Schema>
+bool HealthBackend::updateRecord(std::string_view token, std::uint64_t id, typename Schema::Record rec) {
+  if (!validRecord<Schema>(rec)) return false;
+  rec.id = 0;
+  json op = makeUserOp("update", Schema::kCollection);
+  op["id"] = id;
+  op["rec"] = recordToJson<Schema>(rec);
+  return withUser(token, [&](UserData& user) {
+    if (!Schema::records(user).find(id) && !restoreArchived<Schema>(user, "", id)) return false;
+    return commit(user, std::move(op));
+  });
 }
 
-std::vector<WaterRecord> HealthBackend::getAllWater(const std::string& token) const {
-  const UserData* user = getUserByToken(token);
+template <typename Schema>
+bool HealthBackend::deleteRecord(std::string_view token, std::uint64_t id) {
+  json op = makeUserOp("delete", Schema::kCollection);
+  op["id"] = id;
+  return withUser(token, [&](UserData& user) {
+    if (!Schema::records(user).find(id) && !restoreArchived<Schema>(user, "", id)) return false;
+    return commit(user, std::move(op));
+  });
+}
+
+template <typename Schema>
+std::optional<typename Schema::Record> HealthBackend::findRecord(std::string_view token, std::uint64_t id) const {
+  PinnedVersion user(*this, token);
+  if (!user) return std::nullopt;
+  return findInTiers<Schema>(*user, Schema::published(*user), "", id);
+}
+
+template <typename Schema>
+std::vector<RecordList<typename Schema::Record>> HealthBackend::queryRecords(std::string_view token,
+                                                                             const RecordQuery& q) const {
+  PinnedVersion user(*this, token);
   if (!user) return {};
-  return user->waters;
+  return withArchived(*user, Schema::published(*user), Schema::kCollection, "", q);
 }
 
-bool HealthBackend::updateWater(const std::string& token, std::size_t index, const std::string& newDatetime,
+// One instantiation per schema in RecordSchemas.
+template std::uint64_t HealthBackend::addRecord<WaterSchema>(std::string_view, WaterSchema::Record);
+template RecordList<WaterSchema::Record> HealthBackend::getRecords<WaterSchema>(std::string_view) const;
+template bool HealthBackend::updateRecord<WaterSchema>(std::string_view, std::uint64_t, WaterSchema::Record);
+template bool HealthBackend::deleteRecord<WaterSchema>(std::string_view, std::uint64_t);
+template std::optional<WaterSchema::Record> HealthBackend::findRecord<WaterSchema>(std::string_view, std::uint64_t) const;
+template std::vector<RecordList<WaterSchema::Record>> HealthBackend::queryRecords<WaterSchema>(std::string_view,
+                                                                          const RecordQuery&) const;
+template std::uint64_t HealthBackend::addRecord<SleepSchema>(std::string_view, SleepSchema::Record);
+template RecordList<SleepSchema::Record> HealthBackend::getRecords<SleepSchema>(std::string_view) const;
+template bool HealthBackend::updateRecord<SleepSchema>(std::string_view, std::uint64_t, SleepSchema::Record);
+template bool HealthBackend::deleteRecord<SleepSchema>(std::string_view, std::uint64_t);
+template std::optional<SleepSchema::Record> HealthBackend::findRecord<SleepSchema>(std::string_view, std::uint64_t) const;
+template std::vector<RecordList<SleepSchema::Record>> HealthBackend::queryRecords<SleepSchema>(std::string_view,
+                                                                          const RecordQuery&) const;
+template std::uint64_t HealthBackend::addRecord<ActivitySchema>(std::string_view, ActivitySchema::Record);
+template RecordList<ActivitySchema::Record> HealthBackend::getRecords<ActivitySchema>(std::string_view) const;
+template bool HealthBackend::updateRecord<ActivitySchema>(std::string_view, std::uint64_t, ActivitySchema::Record);
+template bool HealthBackend::deleteRecord<ActivitySchema>(std::string_view, std::uint64_t);
+template std::optional<ActivitySchema::Record> HealthBackend::findRecord<ActivitySchema>(std::string_view, std::uint64_t) const;
+template std::vector<RecordList<ActivitySchema::Record>> HealthBackend::queryRecords<ActivitySchema>(std::string_view,
+                                                                          const RecordQuery&) const;
+
+// By type.
+
+std::uint64_t HealthBackend::addWater(std::string_view token, std::string_view datetime, double amountMl) {
+  return addRecord<WaterSchema>(token, makeRecord<WaterSchema>(datetime, amountMl));
+}
+RecordList<WaterRecord> HealthBackend::getAllWater(std::string_view token) const {
+  return getRecords<WaterSchema>(token);
+}
+bool HealthBackend::updateWater(std::string_view token, std::uint64_t id, std::string_view newDatetime,
                                 double newAmountMl) {
-  if (newAmountMl <= 0.0 || newAmountMl >= 5000.0) return false;
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  if (index >= user->waters.size()) return false;
-
-  user->waters[index].datetime = newDatetime;
-  user->waters[index].amountMl = newAmountMl;
-  saveToFile();
-  return true;
+  return updateRecord<WaterSchema>(token, id, makeRecord<WaterSchema>(newDatetime, newAmountMl));
+}
+bool HealthBackend::deleteWater(std::string_view token, std::uint64_t id) {
+  return deleteRecord<WaterSchema>(token, id);
 }
 
-bool HealthBackend::deleteWater(const std::string& token, std::size_t index) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  if (index >= user->waters.size()) return false;
+std::uint64_t HealthBackend::addSleep(std::string_view token, std::string_view datetime, double hours) {
+  return addRecord<SleepSchema>(token, makeRecord<SleepSchema>(datetime, hours));
+}
+RecordList<SleepRecord> HealthBackend::getAllSleep(std::string_view token) const {
+  return getRecords<SleepSchema>(token);
+}
+bool HealthBackend::updateSleep(std::string_view token, std::uint64_t id, std::string_view newDatetime,
+                                double newHours) {
+  return updateRecord<SleepSchema>(token, id, makeRecord<SleepSchema>(newDatetime, newHours));
+}
+bool HealthBackend::deleteSleep(std::string_view token, std::uint64_t id) {
+  return deleteRecord<SleepSchema>(token, id);
+}
 
-  user->waters.erase(user->waters.begin() + static_cast<long>(index));
-  saveToFile();
-  return true;
+std::uint64_t HealthBackend::addActivity(std::string_view token, std::string_view datetime, int minutes,
+                                         std::string_view intensity) {
+  return addRecord<ActivitySchema>(token, makeRecord<ActivitySchema>(datetime, minutes, intensity));
+}
+RecordList<ActivityRecord> HealthBackend::getAllActivity(std::string_view token) const {
+  return getRecords<ActivitySchema>(token);
+}
+bool HealthBackend::updateActivity(std::string_view token, std::uint64_t id, std::string_view newDatetime,
+                                   int newMinutes, std::string_view newIntensity) {
+  return updateRecord<ActivitySchema>(token, id, makeRecord<ActivitySchema>(newDatetime, newMinutes, newIntensity));
+}
+bool HealthBackend::deleteActivity(std::string_view token, std::uint64_t id) {
+  return deleteRecord<ActivitySchema>(token, id);
 }
 
 // ----------------------
-// Sleeps
+// Custom Categories
 // ----------------------
 
-bool HealthBackend::addSleep(const std::string& token, const std::string& datetime, double hours) {
-  if (hours < 0.0 || hours > 24.0) {
-    util::Logger::warn(std::string("addSleep: invalid hours: ") + std::to_string(hours));
-    return false;
+std::vector<std::string> HealthBackend::getOtherCategories(std::string_view token) const {
+  PinnedVersion user(*this, token);
+  if (!user) return {};
+
+  std::vector<std::string> cats;
+  cats.reserve(user->categories.size());
+  for (const auto& [name, _vec] : user->categories) {
+    cats.push_back(name);
   }
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
+  return cats;
+}
 
-  SleepRecord s;
-  s.datetime = datetime;
-  s.hours = hours;
-  user->sleeps.push_back(s);
-  saveToFile();
-  util::Logger::info(std::string("addSleep: user token found, added sleep for token: ") + token);
-  return true;
+bool HealthBackend::createCategory(std::string_view token, std::string_view name) {
+  if (name.empty()) return false;
+
+  json op = makeUserOp("create", "categories");  // 建立空 category
+  op["category"] = name;
+  return withUser(token, [&](UserData& user) {
+    if (user.categories.find(name) != user.categories.end()) return false;  // 已存在
+    return commit(user, std::move(op));
+  });
 }
 
-std::vector<SleepRecord> HealthBackend::getAllSleep(const std::string& token) const {
-  const UserData* user = getUserByToken(token);
+std::uint64_t HealthBackend::addOtherRecord(std::string_view token, std::string_view categoryName,
+                                            std::string_view datetime, double value, std::string_view note) {
+  json op = makeUserOp("add", "categories");  // category 不存在 → 0
+  op["category"] = categoryName;
+  op["rec"] = toJson(makeRecord<CategoryItemSchema>(datetime, note, value));
+  return commitAdd(token, std::move(op));
+}
+
+RecordList<CategoryItem> HealthBackend::getOtherRecords(std::string_view token,
+                                                        std::string_view categoryName) const {
+  PinnedVersion user(*this, token);
   if (!user) return {};
-  return user->sleeps;
+  auto it = user->categories.find(categoryName);
+  if (it == user->categories.end()) return {};
+  return it->second;
 }
 
-bool HealthBackend::updateSleep(const std::string& token, std::size_t index, const std::string& newDatetime,
-                                double newHours) {
-  if (newHours < 0.0 || newHours > 24.0) return false;
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  if (index >= user->sleeps.size()) return false;
+bool HealthBackend::updateOtherRecord(std::string_view token, std::string_view categoryName, std::uint64_t id,
+                                      std::string_view newDatetime, double newValue, std::string_view newNote) {
+  json op = makeUserOp("update", "categories");
+  op["category"] = categoryName;
+  op["id"] = id;
+  op["rec"] = toJson(makeRecord<CategoryItemSchema>(newDatetime, newNote, newValue));
+  return withUser(token, [&](UserData& user) {
+    auto it = user.categories.find(categoryName);
+    if (it == user.categories.end()) return false;
+    if (!it->second.find(id) && !restoreArchived<CategoryItemSchema>(user, std::string(categoryName), id)) {
+      return false;
+    }
+    return commit(user, std::move(op));
+  });
+}
 
-  user->sleeps[index].datetime = newDatetime;
-  user->sleeps[index].hours = newHours;
-  saveToFile();
-  return true;
+bool HealthBackend::deleteOtherRecord(std::string_view token, std::string_view categoryName, std::uint64_t id) {
+  json op = makeUserOp("delete", "categories");
+  op["category"] = categoryName;
+  op["id"] = id;
+  return withUser(token, [&](UserData& user) {
+    auto it = user.categories.find(categoryName);
+    if (it == user.categories.end()) return false;
+    if (!it->second.find(id) && !restoreArchived<CategoryItemSchema>(user, std::string(categoryName), id)) {
+      return false;
+    }
+    return commit(user, std::move(op));
+  });
 }
 
-bool HealthBackend::deleteSleep(const std::string& token, std::size_t index) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  if (index >= user->sleeps.size()) return false;
+std::optional<CategoryItem> HealthBackend::findOtherRecord(std::string_view token, std::string_view categoryName,
+                                                           std::uint64_t id) const {
+  PinnedVersion user(*this, token);
+  if (!user) return std::nullopt;
+  auto it = user->categories.find(categoryName);
+  if (it == user->categories.end()) return std::nullopt;
+  return findInTiers<CategoryItemSchema>(*user, it->second, categoryName, id);
+}
 
-  user->sleeps.erase(user->sleeps.begin() + static_cast<long>(index));
-  saveToFile();
-  return true;
+// 刪掉整個 category，不管裡面有沒有 item
+bool HealthBackend::deleteCategory(std::string_view token, std::string_view categoryName) {
+  json op = makeUserOp("drop", "categories");  // 直接整個刪掉這個 category
+  op["category"] = categoryName;
+  return withUser(token, [&](UserData& user) {
+    if (user.categories.find(categoryName) == user.categories.end()) return false;
+    std::vector<Segment> archived;
+    for (const Segment& seg : user.segments) {
+      if (seg.collection.view() == "categories" && seg.category == categoryName) archived.push_back(seg);
+    }
+    if (!commit(user, std::move(op))) return false;
+    // Not unlinked here: until a snapshot covers the drop, a replay after a
+    // crash brings the category and its segments back.
+    retireSegments(user, archived);
+    return true;
+  });
 }
 
 // ----------------------
-// Activities
+// Tiering：old records → archived segments
 // ----------------------
 
-bool HealthBackend::addActivity(const std::string& token, const std::string& datetime, int minutes,
-                                const std::string& intensity) {
-  if (minutes <= 0 || minutes > 1440.0) return false;
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
+std::vector<RecordList<WaterRecord>> HealthBackend::queryWater(std::string_view token, const RecordQuery& q) const {
+  return queryRecords<WaterSchema>(token, q);
+}
 
-  ActivityRecord a;
-  a.datetime = datetime;
-  a.minutes = minutes;
-  a.intensity = intensity;
-  user->activities.push_back(a);
-  saveToFile();
-  return true;
+std::vector<RecordList<SleepRecord>> HealthBackend::querySleep(std::string_view token, const RecordQuery& q) const {
+  return queryRecords<SleepSchema>(token, q);
 }
 
-std::vector<ActivityRecord> HealthBackend::getAllActivity(const std::string& token) const {
-  const UserData* user = getUserByToken(token);
-  if (!user) return {};
-  return user->activities;
+std::vector<RecordList<ActivityRecord>> HealthBackend::queryActivity(std::string_view token,
+                                                                     const RecordQuery& q) const {
+  return queryRecords<ActivitySchema>(token, q);
 }
 
-bool HealthBackend::updateActivity(const std::string& token, std::size_t index, const std::string& newDatetime,
-                                   int newMinutes, const std::string& newIntensity) {
-  if (newMinutes <= 0 || newMinutes > 1440.0) return false;
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  if (index >= user->activities.size()) return false;
+std::vector<RecordList<CategoryItem>> HealthBackend::queryOtherRecords(std::string_view token,
+                                                                       std::string_view categoryName,
+                                                                       const RecordQuery& q) const {
+  PinnedVersion user(*this, token);
+  if (!user) return {};
+  auto it = user->categories.find(categoryName);
+  if (it == user->categories.end()) return {};
+  return withArchived(*user, it->second, "categories", categoryName, q);
+}
 
-  user->activities[index].datetime = newDatetime;
-  user->activities[index].minutes = newMinutes;
-  user->activities[index].intensity = newIntensity;
-  saveToFile();
-  return true;
+std::size_t HealthBackend::countOtherRecords(std::string_view token, std::string_view categoryName) const {
+  PinnedVersion user(*this, token);
+  if (!user) return 0;
+  auto it = user->categories.find(categoryName);
+  if (it == user->categories.end()) return 0;
+  std::size_t n = it->second.size();
+  for (const Segment& seg : *user->segments) {
+    if (seg.collection.view() == "categories" && seg.category == categoryName) n += seg.records;
+  }
+  return n;
 }
 
-bool HealthBackend::deleteActivity(const std::string& token, std::size_t index) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  if (index >= user->activities.size()) return false;
+// A query that stays inside the recent window (the usual dashboard range)
+// reaches no segment; one that reaches history reads each segment from disk
+// only the first time, while it stays in the cache.
+template <typename T>
+std::vector<RecordList<T>> HealthBackend::withArchived(const UserVersion& user, RecordList<T> published,
+                                                       std::string_view coll, std::string_view category,
+                                                       const RecordQuery& q) const {
+  std::vector<RecordList<T>> lists;
+  lists.push_back(std::move(published));
+  for (const Segment& seg : *user.segments) {
+    if (seg.collection.view() != coll || seg.category != category) continue;
+    if (seg.toMs < q.from || seg.fromMs >= q.to || (q.resume && seg.toMs < q.afterTime)) continue;
+    if (auto list = segmentList<T>(user.profile.name, seg)) lists.push_back(std::move(*list));
+  }
+  return lists;
+}
 
-  user->activities.erase(user->activities.begin() + static_cast<long>(index));
-  saveToFile();
-  return true;
+template <typename T>
+std::optional<RecordList<T>> HealthBackend::segmentList(const std::string& user, const Segment& seg) const {
+  const std::string path = storage_->segmentPathFor(user, seg);
+  if (auto cached = segmentCache_.get<T>(path)) return cached;
+  std::vector<T> records;
+  ++segmentReads_;
+  if (!readSegment(path, records)) {
+    ++segmentReadErrors_;
+    util::Logger::warn(std::string("Archive: cannot read segment ") + path + ", skipping it");
+    return std::nullopt;
+  }
+  // Files are in time order, lists in id order.
+  std::sort(records.begin(), records.end(), [](const T& a, const T& b) { return a.id < b.id; });
+  RecordList<T> list(records);
+  segmentCache_.put(path, list);
+  return list;
 }
 
-// ----------------------
-// Custom Categories
-// ----------------------
+template <typename Schema>
+std::optional<typename Schema::Record> HealthBackend::findInTiers(
+    const UserVersion& user, const RecordList<typename Schema::Record>& published, std::string_view category,
+    std::uint64_t id) const {
+  using Record = typename Schema::Record;
+  if (auto v = published.find(id)) return recordOf<Schema>(*v);
+  for (const Segment& seg : *user.segments) {
+    if (seg.collection.view() != Schema::kCollection || seg.category != category) continue;
+    const auto list = segmentList<Record>(user.profile.name, seg);
+    if (!list) continue;
+    if (auto v = list->find(id)) return recordOf<Schema>(*v);
+  }
+  return std::nullopt;
+}
 
-std::vector<std::string> HealthBackend::getOtherCategories(const std::string& token) const {
-  const UserData* user = getUserByToken(token);
-  if (!user) return {};
+template <typename Schema>
+bool HealthBackend::restoreArchived(UserData& user, const std::string& category, std::uint64_t id) {
+  using Record = typename Schema::Record;
+  for (const Segment& seg : user.segments) {
+    if (seg.collection.view() != Schema::kCollection || seg.category != category) continue;
+    const auto list = segmentList<Record>(user.profile.name, seg);
+    if (!list || !list->find(id)) continue;
+
+    json op = makeUserOp("restore", Schema::kCollection);
+    if (!category.empty()) op["category"] = category;
+    op["segment"] = seg.id;
+    json recs = json::array();
+    for (const auto& v : *list) recs.push_back(toJson(recordOf<Schema>(v)));
+    op["recs"] = std::move(recs);
+
+    const Segment restored = seg;  // commit() erases it from user.segments
+    if (!commit(user, std::move(op))) return false;
+    retireSegments(user, {restored});
+    ++segmentsRestored_;
+    return true;
+  }
+  return false;
+}
 
-  std::vector<std::string> cats;
-  for (const auto& [name, _vec] : user->categories) {
-    cats.push_back(name);
+// Caller is the user's writer. Called after the op that lets go of the
+// segments was committed: whichever are gone from the user are queued,
+// behind every journal entry so far.
+void HealthBackend::retireSegments(const UserData& user, const std::vector<Segment>& segments) {
+  const std::uint64_t seq = storage_->journalSeq();
+  std::lock_guard<std::mutex> lk(retiredMtx_);
+  for (const Segment& seg : segments) {
+    const bool kept = std::any_of(user.segments.begin(), user.segments.end(), [&](const Segment& s) {
+      return s.id == seg.id && s.collection == seg.collection;
+    });
+    if (kept) continue;
+    segmentCache_.erase(storage_->segmentPathFor(user.profile.name, seg));
+    retired_.push_back(RetiredSegment{user.profile.name, seg, seq});
   }
-  return cats;
 }
 
-bool HealthBackend::createCategory(const std::string& token, const std::string& name) {
-  if (name.empty()) return false;
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
+void HealthBackend::removeRetiredSegments(std::uint64_t seq) {
+  std::lock_guard<std::mutex> lk(retiredMtx_);
+  auto covered = std::stable_partition(retired_.begin(), retired_.end(),
+                                       [seq](const RetiredSegment& r) { return r.seq > seq; });
+  for (auto it = covered; it != retired_.end(); ++it) storage_->removeSegmentFile(it->user, it->segment);
+  retired_.erase(covered, retired_.end());
+}
 
-  if (user->categories.find(name) != user->categories.end()) return false;  // 已存在
+bool HealthBackend::archiveCollection(UserData& user, const std::string& coll, const std::string& category,
+                                      std::size_t minRecords) {
+  bool written = false;
+  forEachRecordSchema([&](auto schema) {
+    using Schema = decltype(schema);
+    if (coll == Schema::kCollection) written = archiveRecords(user, Schema::records(user), coll, category, minRecords);
+  });
+  if (coll == "categories") {
+    auto it = user.categories.find(category);
+    if (it == user.categories.end()) return false;
+    return archiveRecords(user, it->second, coll, category, minRecords);
+  }
+  return written;
+}
 
-  user->categories[name] = {};  // 建立空 category
-  saveToFile();
+// The file goes to disk first, then the "archive" op moves the records out
+// of memory and into the user's segment list (applyUserOp).
+template <typename Rec>
+bool HealthBackend::archiveRecords(UserData& user, const RecordSet<Rec>& records, const std::string& coll,
+                                   const std::string& category, std::size_t minRecords) {
+  const std::int64_t before = archive_.cutoff();
+  std::vector<const Rec*> old;
+  for (const Rec& r : records) {
+    if (isArchivable(r.timeMs, before)) old.push_back(&r);
+  }
+  if (old.empty() || old.size() < minRecords) return false;
+  // Ids increase, so equal times stay in id order.
+  std::stable_sort(old.begin(), old.end(), [](const Rec* a, const Rec* b) { return a->timeMs < b->timeMs; });
+
+  // Never the id of an earlier segment, even a restored or dropped one
+  // whose file is still waiting for removal (applyArchiveOp bumps the counter).
+  Segment seg;
+  seg.id = user.nextRecordId;
+  for (const Segment& s : user.segments) seg.id = std::max(seg.id, s.id + 1);
+  seg.collection = coll;
+  seg.category = category;
+  seg.fromMs = old.front()->timeMs;
+  seg.toMs = old.back()->timeMs;
+  seg.records = old.size();
+  if (!storage_->writeSegmentFile(user.profile.name, seg,
+                                  [&old](std::ostream& out) { return writeSegment(out, old); })) {
+    util::Logger::error(std::string("Archive: failed to write ") + storage_->segmentPathFor(user.profile.name, seg));
+    return false;
+  }
+
+  json op = makeUserOp("archive", coll.c_str());
+  if (!category.empty()) op["category"] = category;
+  op["before"] = before;
+  op["segment"] = segmentToJson(seg);
+  if (!commit(user, std::move(op))) {
+    storage_->removeSegmentFile(user.profile.name, seg);  // nothing refers to it
+    return false;
+  }
+  ++segmentsWritten_;
+  recordsArchived_ += seg.records;
   return true;
 }
 
-bool HealthBackend::addOtherRecord(const std::string& token, const std::string& categoryName,
-                                   const std::string& datetime, double value, const std::string& note) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
+std::size_t HealthBackend::archiveNow() {
+  if (!archive_.enabled()) return 0;
+  waitReady();
+  // Every writer holds usersMtx_ shared (acquireUser), so holding it
+  // exclusively makes this each user's only writer.
+  std::unique_lock<std::shared_mutex> users(usersMtx_);
+  std::size_t written = 0;
+  for (auto& [_, u] : usersByName) {
+    forEachRecordSchema([&](auto schema) { written += archiveCollection(u, decltype(schema)::kCollection, "", 1); });
+    for (const auto& [name, _items] : u.categories) written += archiveCollection(u, "categories", name, 1);
+  }
+  return written;
+}
 
-  auto it = user->categories.find(categoryName);
-  if (it == user->categories.end()) return false;  // ❌ category 不存在 → 回傳 false
+HealthBackend::ArchiveStats HealthBackend::archiveStats() const {
+  ArchiveStats st;
+  st.ageMs = archive_.ageMs;
+  st.minRecords = archive_.minRecords;
+  st.segmentsWritten = segmentsWritten_;
+  st.recordsArchived = recordsArchived_;
+  st.segmentReads = segmentReads_;
+  st.segmentReadErrors = segmentReadErrors_;
+  st.segmentsRestored = segmentsRestored_;
+  st.cache = segmentCache_.stats();
+  return st;
+}
 
-  CategoryItem item;
-  item.datetime = datetime;
-  item.note = note;
-  item.value = value;
+// ----------------------
+// Persistence stats
+// ----------------------
 
-  it->second.push_back(item);
-  saveToFile();
-  return true;
+Journal::Stats HealthBackend::persistenceStats() const {
+  return storage_->journalStats();
 }
 
-std::vector<CategoryItem> HealthBackend::getOtherRecords(const std::string& token,
-                                                         const std::string& categoryName) const {
-  const UserData* user = getUserByToken(token);
-  if (!user) return {};
-  auto it = user->categories.find(categoryName);
-  if (it == user->categories.end()) return {};
-  return it->second;
+std::string HealthBackend::durabilityMode() const {
+  return Journal::durabilityName(storage_->durability());
 }
 
-bool HealthBackend::updateOtherRecord(const std::string& token, const std::string& categoryName, std::size_t index,
-                                      const std::string& newDatetime, double newValue, const std::string& newNote) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  auto it = user->categories.find(categoryName);
-  if (it == user->categories.end()) return false;
-  auto& vec = it->second;
-  if (index >= vec.size()) return false;
-
-  vec[index].datetime = newDatetime;
-  vec[index].note = newNote;
-  vec[index].value = newValue;
-  saveToFile();
-  return true;
+std::string HealthBackend::storageLayout() const {
+  return Storage::layoutName(storage_->layout());
 }
 
-bool HealthBackend::deleteOtherRecord(const std::string& token, const std::string& categoryName, std::size_t index) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  auto it = user->categories.find(categoryName);
-  if (it == user->categories.end()) return false;
+std::size_t HealthBackend::dirtyUsers() const {
+  if (lookupsWait_ && !ready_) return 0;  // the loader thread owns the map until then
+  // Writers set `dirty` under their stripe with the gate held shared; the
+  // exclusive gate waits them out without taking all the stripes.
+  std::shared_lock<std::shared_mutex> users(usersMtx_);
+  std::unique_lock<std::shared_mutex> gate(snapshotGate_);
+  std::size_t n = 0;
+  for (const auto& [_, u] : usersByName) n += u.dirty ? 1 : 0;
+  return n;
+}
 
-  auto& vec = it->second;
-  if (index >= vec.size()) return false;
+UserCache::Stats HealthBackend::cacheStats() const {
+  return cache_.stats();
+}
 
-  vec.erase(vec.begin() + static_cast<long>(index));
-  saveToFile();
-  return true;
+// As dirtyUsers: the exclusive gate holds writers off, so records and
+// published versions stay put; the pin covers a first publication by a
+// reader, which does not take the gate.
+HealthBackend::MemoryReport HealthBackend::memoryReport(std::size_t limit) const {
+  MemoryReport report;
+  if (lookupsWait_ && !ready_) return report;
+  std::shared_lock<std::shared_mutex> users(usersMtx_);
+  std::unique_lock<std::shared_mutex> gate(snapshotGate_);
+  EpochDomain::Guard pin;
+  auto smaller = [](const UserFootprint& a, const UserFootprint& b) { return a.bytes() < b.bytes(); };
+  for (const auto& [_, u] : usersByName) {
+    UserFootprint f = footprintOf(u, u.handle ? u.handle->published.load() : nullptr);
+    ++report.users;
+    report.bytes += f.bytes();
+    report.waters += f.waters;
+    report.sleeps += f.sleeps;
+    report.activities += f.activities;
+    report.categories += f.categories;
+    if (limit == 0) continue;
+    report.largest.push_back(std::move(f));
+    if (report.largest.size() > limit) {  // keep the `limit` biggest
+      report.largest.erase(std::min_element(report.largest.begin(), report.largest.end(), smaller));
+    }
+  }
+  std::sort(report.largest.rbegin(), report.largest.rend(), smaller);
+  return report;
 }
 
-// 刪掉整個 category，不管裡面有沒有 item
-bool HealthBackend::deleteCategory(const std::string& token, const std::string& categoryName) {
-  UserData* user = getUserByToken(token);
-  if (!user) return false;
-  auto it = user->categories.find(categoryName);
-  if (it == user->categories.end()) return false;
+// ----------------------
+// Execution stats
+// ----------------------
 
-  user->categories.erase(it);  // 直接整個刪掉這個 category
-  saveToFile();
-  return true;
-}
\ No newline at end of file
+std::string HealthBackend::executionMode() const {
+  return executor_ ? "shard-per-core" : "locked";
+}
+
+std::vector<ShardExecutor::ShardStats> HealthBackend::executorStats() const {
+  if (!executor_) return {};
+  return executor_->stats();
+}
@@ -0,0 +1,389 @@
+#include "../../include/core/Journal.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+
+#include "../../include/utils/Logger.hpp"
+
+using nlohmann::json;
+
+// Wake the flusher early in Async mode once this much is queued.
+static constexpr std::size_t kEagerFlushBytes = 256 * 1024;
+
+// Appends the whole of `from` (which may be missing or empty) to `to`,
+// fsyncing `to` afterwards when `sync` is set. On failure `to` is cut back
+// to its old size, so a retry does not repeat entries.
+static bool appendFile(const std::string& from, const std::string& to, bool sync) {
+  const int in = ::open(from.c_str(), O_RDONLY);
+  if (in < 0) return errno == ENOENT;
+  const int out = ::open(to.c_str(), O_WRONLY | O_APPEND);
+  if (out < 0) {
+    ::close(in);
+    return false;
+  }
+  struct stat st{};
+  const off_t before = ::fstat(out, &st) == 0 ? st.st_size : -1;
+  char buf[64 * 1024];
+  bool ok = before >= 0;
+  for (;;) {
+    ssize_t n = ::read(in, buf, sizeof(buf));
+    if (n == 0) break;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      ok = false;
+      break;
+    }
+    for (ssize_t done = 0; ok && done < n;) {
+      const ssize_t w = ::write(out, buf + done, static_cast<std::size_t>(n - done));
+      if (w < 0 && errno == EINTR) continue;
+      if (w < 0) ok = false;
+      else done += w;
+    }
+    if (!ok) break;
+  }
+  if (ok && sync) ok = ::fsync(out) == 0;
+  if (!ok && before >= 0 && ::ftruncate(out, before) != 0) {
+    util::Logger::error(std::string("Journal: failed to truncate ") + to);
+  }
+  ::close(in);
+  ::close(out);
+  return ok;
+}
+
+// fsync the directory holding `path`, so a rename / unlink in it is durable.
+static bool syncParentDir(const std::string& path) {
+  std::filesystem::path dir = std::filesystem::path(path).parent_path();
+  if (dir.empty()) dir = ".";
+  const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) return false;
+  const bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+
+Journal::Durability Journal::parseDurability(const std::string& s) {
+  if (s == "sync") return Durability::Sync;
+  if (s == "none") return Durability::None;
+  return Durability::Async;
+}
+
+const char* Journal::durabilityName(Durability d) {
+  switch (d) {
+    case Durability::Sync:
+      return "sync";
+    case Durability::None:
+      return "none";
+    case Durability::Async:
+      break;
+  }
+  return "async";
+}
+
+Journal::Journal(const std::string& path, Durability mode, std::chrono::milliseconds flushInterval)
+    : journalPath(path), sealedPath(path + ".1"), mode_(mode), flushInterval_(flushInterval) {
+  flusher_ = std::thread([this] { flusherLoop(); });
+}
+
+Journal::~Journal() {
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  if (flusher_.joinable()) flusher_.join();
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool Journal::openForAppend() {
+  if (fd_ >= 0) return true;
+  std::filesystem::path p(journalPath);
+  if (p.has_parent_path()) {
+    std::error_code ec;
+    std::filesystem::create_directories(p.parent_path(), ec);
+  }
+  fd_ = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  return fd_ >= 0;
+}
+
+bool Journal::writeAll(const std::string& data) {
+  if (!openForAppend()) {
+    util::Logger::error(std::string("Journal: failed to open ") + journalPath + " for appending.");
+    return false;
+  }
+  const char* p = data.data();
+  std::size_t left = data.size();
+  while (left > 0) {
+    ssize_t n = ::write(fd_, p, left);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      util::Logger::error(std::string("Journal: write failed for ") + journalPath);
+      return false;
+    }
+    p += n;
+    left -= static_cast<std::size_t>(n);
+  }
+  if (mode_ == Durability::None) return true;
+#ifdef __APPLE__
+  const int synced = ::fsync(fd_);
+#else
+  const int synced = ::fdatasync(fd_);
+#endif
+  if (synced != 0) {
+    util::Logger::error(std::string("Journal: fsync failed for ") + journalPath);
+    return false;
+  }
+  return true;
+}
+
+std::size_t Journal::replay(std::uint64_t afterSeq, const std::function<void(const json&)>& apply) {
+  std::uint64_t maxSeq = afterSeq;
+  std::size_t applied = replayFile(sealedPath, afterSeq, maxSeq, apply);
+  applied += replayFile(journalPath, afterSeq, maxSeq, apply);
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  seq_ = std::max(seq_, maxSeq);
+  durableSeq_ = seq_;
+  struct stat st{};
+  size_ = ::stat(journalPath.c_str(), &st) == 0 ? static_cast<std::uintmax_t>(st.st_size) : 0;
+  return applied;
+}
+
+std::size_t Journal::replayFile(const std::string& file, std::uint64_t afterSeq, std::uint64_t& maxSeq,
+                                const std::function<void(const json&)>& apply) {
+  std::ifstream in(file, std::ios::binary);
+
+  std::size_t applied = 0;
+  std::streamoff goodEnd = 0;
+  bool torn = false;
+  std::string line;
+  while (in && std::getline(in, line)) {
+    // A line without its trailing '\n' was never fully written.
+    if (in.eof()) {
+      torn = true;
+      break;
+    }
+    if (line.empty()) {
+      goodEnd = in.tellg();
+      continue;
+    }
+    json entry = json::parse(line, nullptr, false);
+    if (entry.is_discarded() || !entry.is_object() || !entry.contains("seq")) {
+      torn = true;
+      break;
+    }
+    goodEnd = in.tellg();
+
+    std::uint64_t seq = entry.value("seq", std::uint64_t{0});
+    maxSeq = std::max(maxSeq, seq);
+    if (seq <= afterSeq) continue;  // already folded into the snapshot
+    apply(entry);
+    ++applied;
+  }
+  in.close();
+
+  if (torn) {
+    util::Logger::warn(std::string("Journal: discarding torn tail of ") + file + " at offset " +
+                       std::to_string(goodEnd));
+    if (::truncate(file.c_str(), static_cast<off_t>(goodEnd)) != 0) {
+      util::Logger::error(std::string("Journal: failed to truncate ") + file);
+    }
+  }
+  return applied;
+}
+
+std::uint64_t Journal::append(json entry) {
+  std::unique_lock<std::mutex> lk(mtx_);
+  const std::uint64_t seq = ++seq_;
+  entry["seq"] = seq;
+  std::string line = entry.dump();
+  line.push_back('\n');
+
+  if (pendingCount_ == 0) oldestPending_ = std::chrono::steady_clock::now();
+  pending_ += line;
+  ++pendingCount_;
+  size_ += line.size();
+
+  if (mode_ == Durability::Sync || pending_.size() >= kEagerFlushBytes) wake_.notify_one();
+  if (mode_ == Durability::Sync) {
+    durable_.wait(lk, [&] { return durableSeq_ >= seq || failedBatchOf(seq) != failed_.end() || stop_; });
+    auto failed = failedBatchOf(seq);
+    if (failed != failed_.end()) {
+      // Every writer of the batch collects its verdict exactly once.
+      if (--failed->waiters == 0) failed_.erase(failed);
+      return 0;
+    }
+  }
+  return seq;
+}
+
+std::vector<Journal::FailedBatch>::iterator Journal::failedBatchOf(std::uint64_t seq) {
+  return std::find_if(failed_.begin(), failed_.end(),
+                      [&](const FailedBatch& b) { return seq >= b.from && seq <= b.upTo; });
+}
+
+bool Journal::writeBatch(const std::string& data) {
+  if (!openForAppend()) {
+    util::Logger::error(std::string("Journal: failed to open ") + journalPath + " for appending.");
+    return false;
+  }
+  struct stat st{};
+  const off_t before = ::fstat(fd_, &st) == 0 ? st.st_size : -1;
+  if (writeAll(data)) return true;
+
+  // Cut off whatever part of the batch made it out, so replay never stops at
+  // a torn line with intact entries behind it.
+  if (before < 0 || ::ftruncate(fd_, before) != 0) {
+    util::Logger::error(std::string("Journal: failed to roll back a partial batch in ") + journalPath);
+  }
+  return false;
+}
+
+// Caller holds mtx_. A failed batch leaves durableSeq_ where it was, and its
+// Sync-mode writers get 0 back from append().
+void Journal::settleBatch(bool ok, std::uint64_t upTo, std::uint64_t count, std::size_t bytes) {
+  if (ok) {
+    durableSeq_ = std::max(durableSeq_, upTo);
+  } else {
+    ++failedBatches_;
+    size_ -= std::min<std::uintmax_t>(size_, bytes);
+    if (mode_ == Durability::Sync) failed_.push_back(FailedBatch{upTo - count + 1, upTo, count});
+    util::Logger::error(std::string("Journal: lost ") + std::to_string(count) + " entries up to seq " +
+                        std::to_string(upTo) + " in " + journalPath);
+  }
+  durable_.notify_all();
+}
+
+void Journal::flusherLoop() {
+  std::unique_lock<std::mutex> lk(mtx_);
+  while (true) {
+    if (mode_ == Durability::Sync) {
+      wake_.wait(lk, [&] { return stop_ || pendingCount_ > 0; });
+    } else {
+      wake_.wait_for(lk, flushInterval_, [&] { return stop_ || pending_.size() >= kEagerFlushBytes; });
+    }
+
+    if (pendingCount_ == 0) {
+      if (stop_) break;
+      continue;
+    }
+
+    // Everyone who queued before this point rides on the same write + fsync.
+    std::string batch;
+    batch.swap(pending_);
+    const std::uint64_t upTo = seq_;
+    const std::uint64_t count = pendingCount_;
+    pendingCount_ = 0;
+    writing_ = true;
+
+    lk.unlock();
+    const bool ok = writeBatch(batch);
+    lk.lock();
+
+    writing_ = false;
+    ++flushes_;
+    maxBatch_ = std::max(maxBatch_, count);
+    settleBatch(ok, upTo, count, batch.size());
+  }
+}
+
+bool Journal::reset() {
+  std::unique_lock<std::mutex> lk(mtx_);
+  // Let an in-flight batch land first so it is not written after the truncate.
+  durable_.wait(lk, [&] { return !writing_; });
+  pending_.clear();
+  pendingCount_ = 0;
+  durableSeq_ = seq_;
+  durable_.notify_all();
+
+  size_ = 0;
+  ::unlink(sealedPath.c_str());
+  if (!openForAppend()) return false;
+  return ::ftruncate(fd_, 0) == 0;
+}
+
+bool Journal::seal() {
+  std::unique_lock<std::mutex> lk(mtx_);
+  durable_.wait(lk, [&] { return !writing_; });
+
+  // Write out the queue synchronously so the sealed file holds every seq so far.
+  if (pendingCount_ > 0) {
+    const bool ok = writeBatch(pending_);
+    const std::size_t bytes = pending_.size();
+    const std::uint64_t count = pendingCount_;
+    pending_.clear();
+    pendingCount_ = 0;
+    settleBatch(ok, seq_, count, bytes);
+    if (!ok) return false;
+  }
+  durableSeq_ = seq_;
+  durable_.notify_all();
+
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  const bool sync = mode_ != Durability::None;
+  struct stat st{};
+  if (::stat(sealedPath.c_str(), &st) != 0) {
+    // Common case: the previous sealed segment was dropped, just rename.
+    if (::rename(journalPath.c_str(), sealedPath.c_str()) != 0 && errno != ENOENT) return false;
+  } else {
+    // A previous background snapshot failed; its sealed entries are still
+    // needed, so append the live file behind them. The live file goes only
+    // once that copy is on disk: its entries may already be acknowledged.
+    if (!appendFile(journalPath, sealedPath, sync)) {
+      util::Logger::error(std::string("Journal: failed to append ") + journalPath + " to " + sealedPath);
+      return false;
+    }
+    ::unlink(journalPath.c_str());
+  }
+  if (sync && !syncParentDir(journalPath)) {
+    util::Logger::warn(std::string("Journal: failed to sync the directory of ") + journalPath);
+  }
+  size_ = 0;
+  return true;
+}
+
+void Journal::dropSealed() {
+  ::unlink(sealedPath.c_str());
+}
+
+std::uint64_t Journal::lastSeq() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return seq_;
+}
+
+void Journal::advanceSeq(std::uint64_t seq) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (seq > seq_) seq_ = seq;
+  durableSeq_ = seq_;
+}
+
+std::uintmax_t Journal::sizeBytes() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return size_;
+}
+
+Journal::Stats Journal::stats() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  Stats s;
+  s.lastSeq = seq_;
+  s.durableSeq = durableSeq_;
+  s.pendingEntries = seq_ - durableSeq_;
+  if (pendingCount_ > 0) {
+    s.lagMs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             std::chrono::steady_clock::now() - oldestPending_)
+                                             .count());
+  }
+  s.flushes = flushes_;
+  s.maxBatch = maxBatch_;
+  s.failedBatches = failedBatches_;
+  return s;
+}
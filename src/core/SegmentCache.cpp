@@ -0,0 +1,41 @@
+#include "../../include/core/SegmentCache.hpp"
+
+#include "../../include/core/UserCache.hpp"
+
+std::size_t SegmentCache::budgetFromEnv() {
+  return UserCache::bytesFromEnv("STORAGE_ARCHIVE_CACHE_BYTES", std::size_t{32} << 20);
+}
+
+void SegmentCache::insert(const std::string& path, AnyList list, std::size_t bytes) {
+  if (bytes > budget_) return;  // would evict everything else; also covers a budget of 0
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto it = pos_.find(path);
+  if (it != pos_.end()) eraseLocked(it);  // raced with another reader of the same segment
+  lru_.push_front(Entry{path, std::move(list), bytes});
+  pos_.emplace(path, lru_.begin());
+  bytes_ += bytes;
+  while (bytes_ > budget_) eraseLocked(pos_.find(lru_.back().path));
+}
+
+void SegmentCache::erase(const std::string& path) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto it = pos_.find(path);
+  if (it != pos_.end()) eraseLocked(it);
+}
+
+void SegmentCache::eraseLocked(std::unordered_map<std::string, std::list<Entry>::iterator>::iterator it) {
+  bytes_ -= it->second->bytes;
+  lru_.erase(it->second);
+  pos_.erase(it);
+}
+
+SegmentCache::Stats SegmentCache::stats() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  Stats s;
+  s.budgetBytes = budget_;
+  s.bytes = bytes_;
+  s.segments = lru_.size();
+  s.hits = hits_;
+  s.misses = misses_;
+  return s;
+}
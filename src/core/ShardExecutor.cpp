@@ -0,0 +1,189 @@
+#include "../../include/core/ShardExecutor.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+#include "../../include/utils/Logger.hpp"
+
+namespace {
+
+thread_local const ShardExecutor* tlsExecutor = nullptr;
+thread_local std::size_t tlsShard = 0;
+
+// Best effort: pin `t` to `cpu`; -1 if the platform or the kernel says no.
+int pinToCpu(std::thread& t, int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0) return cpu;
+#else
+  (void)t;
+  (void)cpu;
+#endif
+  return -1;
+}
+
+}  // namespace
+
+std::size_t ShardExecutor::shardsFromEnv() {
+  const char* env = std::getenv("EXECUTOR_SHARDS");
+  if (!env) return 0;
+  if (std::string(env) == "auto") return std::max(1u, std::thread::hardware_concurrency());
+  try {
+    return static_cast<std::size_t>(std::max(0L, std::stol(env)));
+  } catch (...) {
+    return 0;
+  }
+}
+
+ShardExecutor::ShardExecutor(std::size_t shards) {
+  const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t i = 0; i < std::max<std::size_t>(1, shards); ++i) shards_.push_back(std::make_unique<Shard>());
+  std::size_t pinned = 0;
+  for (std::size_t i = 0; i < shards_.size(); ++i) {
+    Shard& s = *shards_[i];
+    s.thread = std::thread([this, i] { loop(i); });
+    s.cpu = pinToCpu(s.thread, static_cast<int>(i % cpus));
+    pinned += s.cpu >= 0 ? 1 : 0;
+  }
+  util::Logger::info(std::string("Executor: ") + std::to_string(shards_.size()) + " shards, " +
+                     std::to_string(pinned) + " pinned to a core");
+}
+
+// Shards drain their queues before they exit.
+ShardExecutor::~ShardExecutor() {
+  stop_ = true;
+  for (auto& s : shards_) {
+    {
+      std::lock_guard<std::mutex> lk(s->parkMtx);
+      s->sleeping = false;
+    }
+    s->parkCv.notify_one();
+  }
+  for (auto& s : shards_) {
+    if (s->thread.joinable()) s->thread.join();
+  }
+}
+
+std::size_t ShardExecutor::shardFor(std::string_view key) const {
+  return std::hash<std::string_view>{}(key) % shards_.size();
+}
+
+bool ShardExecutor::onShard(std::size_t shard) const {
+  return tlsExecutor == this && tlsShard == shard;
+}
+
+// ----------------------
+// MPSC queue
+// ----------------------
+
+void ShardExecutor::Shard::push(Task* t) {
+  t->next.store(nullptr, std::memory_order_relaxed);
+  Task* prev = head.exchange(t, std::memory_order_acq_rel);
+  prev->next.store(t, std::memory_order_release);
+}
+
+// Shard thread only. Null when empty, or when the newest push has swung
+// `head` but not linked its node yet (`pending` still counts it).
+ShardExecutor::Task* ShardExecutor::Shard::pop() {
+  Task* t = tail;
+  Task* next = t->next.load(std::memory_order_acquire);
+  if (t == &stub) {
+    if (!next) return nullptr;
+    tail = next;
+    t = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next) {
+    tail = next;
+    return t;
+  }
+  if (t != head.load(std::memory_order_acquire)) return nullptr;
+  // `t` is the last node: put the stub behind it so `t` can be handed back
+  // without the queue pointing at it any more.
+  push(&stub);
+  next = t->next.load(std::memory_order_acquire);
+  if (next) {
+    tail = next;
+    return t;
+  }
+  return nullptr;
+}
+
+// ----------------------
+// Submit / shard loop
+// ----------------------
+
+void ShardExecutor::submit(std::size_t shard, Task& task) {
+  Shard& s = *shards_[shard];
+  // Counted before the push, so a shard that finds the queue empty but
+  // `pending` > 0 knows a push is in flight and does not park. Paired with
+  // the shard's store to `sleeping` then load of `pending` (both seq_cst):
+  // either it sees our task or we see it asleep.
+  ++s.pending;
+  s.push(&task);
+  if (s.sleeping.load()) {
+    {
+      std::lock_guard<std::mutex> lk(s.parkMtx);
+      s.sleeping = false;
+    }
+    s.parkCv.notify_one();
+  }
+  std::unique_lock<std::mutex> lk(task.mtx);
+  task.cv.wait(lk, [&task] { return task.done; });
+}
+
+void ShardExecutor::loop(std::size_t index) {
+  Shard& s = *shards_[index];
+  tlsExecutor = this;
+  tlsShard = index;
+  for (;;) {
+    if (Task* t = s.pop()) {
+      --s.pending;
+      try {
+        t->call(t->ctx);
+      } catch (...) {
+        t->error = std::current_exception();
+      }
+      ++s.tasks;
+      std::lock_guard<std::mutex> lk(t->mtx);
+      t->done = true;
+      t->cv.notify_one();
+      continue;
+    }
+    if (s.pending.load() > 0) {
+      std::this_thread::yield();  // a push is half done
+      continue;
+    }
+    if (stop_) break;
+
+    std::unique_lock<std::mutex> lk(s.parkMtx);
+    s.sleeping = true;
+    if (s.pending.load() > 0 || stop_) {
+      s.sleeping = false;
+      continue;
+    }
+    s.parkCv.wait(lk, [&s] { return !s.sleeping.load(); });
+  }
+  tlsExecutor = nullptr;
+}
+
+std::vector<ShardExecutor::ShardStats> ShardExecutor::stats() const {
+  std::vector<ShardStats> out;
+  for (const auto& s : shards_) {
+    ShardStats st;
+    st.tasks = s->tasks;
+    st.queued = s->pending;
+    st.cpu = s->cpu;
+    out.push_back(st);
+  }
+  return out;
+}
@@ -0,0 +1,492 @@
+#include "../../include/core/SnapshotBinary.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../../include/core/Timestamp.hpp"
+
+// ----------------------
+// On-disk layout (version 3)
+// ----------------------
+//
+// Version 2 added record ids and the user's next record id, version 3 the
+// user's archived segments. Older files are still read: version 1 records
+// are numbered on load, like JSON snapshots written before records had ids,
+// and neither has segments.
+
+namespace {
+
+constexpr char kMagic[8] = {'H', 'B', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::uint32_t kVersion = 3;
+constexpr std::uint32_t kVersionNoSegments = 2;
+constexpr std::uint32_t kVersionNoIds = 1;
+constexpr std::uint32_t kEndianTag = 0x01020304;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t endianTag;
+  std::uint64_t journalSeq;
+  std::uint64_t userCount;
+  std::uint64_t userDirOffset;
+  std::uint64_t stringsOffset;
+  std::uint64_t stringsSize;
+  std::uint64_t fileSize;
+};
+
+struct StrRef {
+  std::uint32_t offset;  // into the string table
+  std::uint32_t length;
+};
+
+struct ArrayRef {
+  std::uint64_t offset;  // from the start of the file
+  std::uint64_t count;
+};
+
+// Fields only version 2 has; in version 1 they read as 0 and take no space.
+template <bool V2>
+struct RecordIdField {
+  std::uint64_t id;
+};
+template <>
+struct RecordIdField<false> {
+  static constexpr std::uint64_t id = 0;
+};
+template <bool V2>
+struct NextRecordIdField {
+  std::uint64_t nextRecordId;
+};
+template <>
+struct NextRecordIdField<false> {
+  static constexpr std::uint64_t nextRecordId = 0;
+};
+
+template <bool V3>
+struct SegmentsField {
+  ArrayRef segments;  // of SegmentRec
+};
+template <>
+struct SegmentsField<false> {
+  static constexpr ArrayRef segments{0, 0};
+};
+
+template <bool V2, bool V3 = V2>
+struct UserEntryT : NextRecordIdField<V2>, SegmentsField<V3> {
+  StrRef name;
+  StrRef id;
+  StrRef password;
+  StrRef gender;
+  std::int32_t age;
+  std::uint32_t reserved;
+  double weightKg;
+  double heightM;
+  ArrayRef waters;
+  ArrayRef sleeps;
+  ArrayRef activities;
+  ArrayRef categories;  // of CategoryEntry
+};
+
+template <bool V2>
+struct WaterRecT : RecordIdField<V2> {
+  StrRef datetime;
+  double amountMl;
+};
+
+template <bool V2>
+struct SleepRecT : RecordIdField<V2> {
+  StrRef datetime;
+  double hours;
+};
+
+template <bool V2>
+struct ActivityRecT : RecordIdField<V2> {
+  StrRef datetime;
+  StrRef intensity;
+  std::int32_t minutes;
+  std::uint32_t reserved;
+};
+
+struct CategoryEntry {
+  StrRef name;
+  ArrayRef items;  // of CategoryItemRec
+};
+
+template <bool V2>
+struct CategoryItemRecT : RecordIdField<V2> {
+  StrRef datetime;
+  StrRef note;
+  double value;
+};
+
+struct SegmentRec {
+  std::uint64_t id;
+  StrRef collection;
+  StrRef category;
+  std::int64_t fromMs;
+  std::int64_t toMs;
+  std::uint64_t records;
+};
+
+using UserEntry = UserEntryT<true, true>;
+using WaterRec = WaterRecT<true>;
+using SleepRec = SleepRecT<true>;
+using ActivityRec = ActivityRecT<true>;
+using CategoryItemRec = CategoryItemRecT<true>;
+
+static_assert(sizeof(FileHeader) == 64, "header must stay 64 bytes");
+static_assert(sizeof(UserEntry) % 8 == 0 && sizeof(WaterRec) % 8 == 0 && sizeof(SleepRec) % 8 == 0 &&
+                  sizeof(ActivityRec) % 8 == 0 && sizeof(CategoryEntry) % 8 == 0 && sizeof(CategoryItemRec) % 8 == 0 &&
+                  sizeof(SegmentRec) % 8 == 0,
+              "records must keep 8-byte alignment when packed back to back");
+static_assert(sizeof(UserEntryT<true, false>) == 128, "version 2 layout must not change");
+static_assert(sizeof(UserEntryT<false>) == 120 && sizeof(WaterRecT<false>) == 16 && sizeof(SleepRecT<false>) == 16 &&
+                  sizeof(ActivityRecT<false>) == 24 && sizeof(CategoryItemRecT<false>) == 24,
+              "version 1 layout must not change");
+
+// ----------------------
+// Writer
+// ----------------------
+
+class Builder {
+ public:
+  explicit Builder(std::uint64_t recordsBase) : recordsBase_(recordsBase) {}
+
+  bool ok() const { return ok_; }
+  const std::vector<char>& records() const { return records_; }
+  const std::string& strings() const { return strings_; }
+
+  StrRef str(std::string_view s) { return add(s, true); }
+  // Text built just for this call (a datetime rebuilt from its time): shares
+  // an equal string already written, but is not remembered itself.
+  StrRef transientStr(std::string_view s) { return add(s, false); }
+
+  // Append `count` default records and return a reference to the array.
+  template <typename T>
+  ArrayRef reserve(std::size_t count, std::size_t& at) {
+    at = records_.size();
+    records_.resize(records_.size() + count * sizeof(T));
+    return ArrayRef{recordsBase_ + at, count};
+  }
+
+  template <typename T>
+  void put(std::size_t at, std::size_t i, const T& rec) {
+    std::memcpy(records_.data() + at + i * sizeof(T), &rec, sizeof(T));
+  }
+
+ private:
+  std::uint64_t recordsBase_;
+  std::vector<char> records_;
+  std::string strings_;
+  std::unordered_map<std::string_view, StrRef> interned_;
+  bool ok_ = true;
+
+  StrRef add(std::string_view s, bool remember) {
+    auto it = interned_.find(s);
+    if (it != interned_.end()) return it->second;
+    if (strings_.size() + s.size() > std::numeric_limits<std::uint32_t>::max()) {
+      ok_ = false;
+      return StrRef{0, 0};
+    }
+    StrRef ref{static_cast<std::uint32_t>(strings_.size()), static_cast<std::uint32_t>(s.size())};
+    strings_ += s;
+    if (remember) interned_.emplace(s, ref);  // views into the caller's UserMap or the Symbol pool, alive while writing
+    return ref;
+  }
+};
+
+template <typename Rec, typename Src, typename Fill>
+ArrayRef packArray(Builder& b, const RecordSet<Src>& src, Fill fill) {
+  std::size_t at = 0;
+  ArrayRef ref = b.reserve<Rec>(src.size(), at);
+  std::size_t i = 0;
+  for (const Src& s : src) {
+    Rec rec{};
+    rec.id = s.id;
+    fill(rec, s);
+    b.put(at, i++, rec);
+  }
+  return ref;
+}
+
+// ----------------------
+// Reader
+// ----------------------
+
+class View {
+ public:
+  View(const char* base, const FileHeader& h, std::size_t entrySize) : base_(base), h_(h), entrySize_(entrySize) {}
+
+  bool ok() const { return ok_; }
+
+  std::string str(StrRef r) { return std::string(text(r)); }
+
+  // For Symbols, which copy the text into the pool only if it is new.
+  std::string_view text(StrRef r) {
+    if (static_cast<std::uint64_t>(r.offset) + r.length > h_.stringsSize) {
+      ok_ = false;
+      return std::string_view();
+    }
+    return std::string_view(base_ + h_.stringsOffset + r.offset, r.length);
+  }
+
+  // Record arrays must lie between the user directory and the string table.
+  template <typename T>
+  bool check(ArrayRef a) {
+    const std::uint64_t lo = h_.userDirOffset + h_.userCount * entrySize_;
+    if (a.offset < lo || a.offset > h_.stringsOffset || a.count > (h_.stringsOffset - a.offset) / sizeof(T)) {
+      ok_ = false;
+    }
+    return ok_;
+  }
+
+  template <typename T>
+  T at(std::uint64_t offset, std::size_t i) const {
+    T rec;
+    std::memcpy(&rec, base_ + offset + i * sizeof(T), sizeof(T));
+    return rec;
+  }
+
+ private:
+  const char* base_;
+  FileHeader h_;
+  std::size_t entrySize_;
+  bool ok_ = true;
+};
+
+template <bool V2, bool V3>
+bool readUsers(const char* base, const FileHeader& h, UserMap& out) {
+  using UserEntry = UserEntryT<V2, V3>;
+  using WaterRec = WaterRecT<V2>;
+  using SleepRec = SleepRecT<V2>;
+  using ActivityRec = ActivityRecT<V2>;
+  using CategoryItemRec = CategoryItemRecT<V2>;
+  View v(base, h, sizeof(UserEntry));
+  for (std::uint64_t u = 0; u < h.userCount && v.ok(); ++u) {
+    const UserEntry e = v.at<UserEntry>(h.userDirOffset, u);
+
+    UserData data;
+    data.profile.name = v.str(e.name);
+    data.profile.id = v.str(e.id);
+    data.profile.gender = v.str(e.gender);
+    data.profile.age = e.age;
+    data.profile.weightKg = e.weightKg;
+    data.profile.heightM = e.heightM;
+    data.password = v.str(e.password);
+    data.nextRecordId = std::max<std::uint64_t>(1, e.nextRecordId);
+
+    if (v.check<WaterRec>(e.waters)) {
+      data.waters.reserve(e.waters.count);
+      for (std::size_t i = 0; i < e.waters.count; ++i) {
+        const WaterRec r = v.at<WaterRec>(e.waters.offset, i);
+        WaterRecord w;
+        setDatetime(w, v.text(r.datetime));
+        w.amountMl = r.amountMl;
+        w.id = r.id;
+        data.waters.push_back(std::move(w));
+      }
+    }
+    if (v.check<SleepRec>(e.sleeps)) {
+      data.sleeps.reserve(e.sleeps.count);
+      for (std::size_t i = 0; i < e.sleeps.count; ++i) {
+        const SleepRec r = v.at<SleepRec>(e.sleeps.offset, i);
+        SleepRecord sl;
+        setDatetime(sl, v.text(r.datetime));
+        sl.hours = r.hours;
+        sl.id = r.id;
+        data.sleeps.push_back(std::move(sl));
+      }
+    }
+    if (v.check<ActivityRec>(e.activities)) {
+      data.activities.reserve(e.activities.count);
+      for (std::size_t i = 0; i < e.activities.count; ++i) {
+        const ActivityRec r = v.at<ActivityRec>(e.activities.offset, i);
+        ActivityRecord a;
+        setDatetime(a, v.text(r.datetime));
+        a.minutes = r.minutes;
+        a.intensity = v.text(r.intensity);
+        a.id = r.id;
+        data.activities.push_back(std::move(a));
+      }
+    }
+    if (v.check<CategoryEntry>(e.categories)) {
+      for (std::size_t c = 0; c < e.categories.count; ++c) {
+        const CategoryEntry ce = v.at<CategoryEntry>(e.categories.offset, c);
+        if (!v.check<CategoryItemRec>(ce.items)) break;
+        RecordSet<CategoryItem> items;
+        items.reserve(ce.items.count);
+        for (std::size_t i = 0; i < ce.items.count; ++i) {
+          const CategoryItemRec r = v.at<CategoryItemRec>(ce.items.offset, i);
+          CategoryItem item;
+          setDatetime(item, v.text(r.datetime));
+          item.note = v.text(r.note);
+          item.value = r.value;
+          item.id = r.id;
+          items.push_back(std::move(item));
+        }
+        data.categories.emplace(v.str(ce.name), std::move(items));
+      }
+    }
+    if (e.segments.count > 0 && v.check<SegmentRec>(e.segments)) {
+      data.segments.reserve(e.segments.count);
+      for (std::size_t i = 0; i < e.segments.count; ++i) {
+        const SegmentRec r = v.at<SegmentRec>(e.segments.offset, i);
+        Segment seg;
+        seg.id = r.id;
+        seg.collection = v.text(r.collection);
+        seg.category = v.str(r.category);
+        seg.fromMs = r.fromMs;
+        seg.toMs = r.toMs;
+        seg.records = r.records;
+        data.segments.push_back(seg);
+      }
+    }
+    assignRecordIds(data);
+
+    std::string name = data.profile.name;
+    out.emplace_hint(out.end(), std::move(name), std::move(data));  // written in name order
+  }
+  return v.ok();
+}
+
+}  // namespace
+
+bool writeBinarySnapshot(std::ostream& out, const UserMap& users, std::uint64_t journalSeq,
+                         const SnapshotProgress& progress) {
+  FileHeader h{};
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.endianTag = kEndianTag;
+  h.journalSeq = journalSeq;
+  h.userCount = users.size();
+  h.userDirOffset = sizeof(FileHeader);
+
+  const std::uint64_t recordsBase = h.userDirOffset + users.size() * sizeof(UserEntry);
+  Builder b(recordsBase);
+  std::vector<UserEntry> dir;
+  dir.reserve(users.size());
+
+  std::size_t written = 0;
+  for (const auto& [name, data] : users) {
+    UserEntry e{};
+    e.name = b.str(data.profile.name);
+    e.id = b.str(data.profile.id);
+    e.password = b.str(data.password);
+    e.gender = b.str(data.profile.gender);
+    e.age = data.profile.age;
+    e.weightKg = data.profile.weightKg;
+    e.heightM = data.profile.heightM;
+    e.nextRecordId = data.nextRecordId;
+
+    e.waters = packArray<WaterRec>(b, data.waters, [&](WaterRec& r, const WaterRecord& w) {
+      r.datetime = b.transientStr(datetimeText(w).view());
+      r.amountMl = w.amountMl;
+    });
+    e.sleeps = packArray<SleepRec>(b, data.sleeps, [&](SleepRec& r, const SleepRecord& s) {
+      r.datetime = b.transientStr(datetimeText(s).view());
+      r.hours = s.hours;
+    });
+    e.activities = packArray<ActivityRec>(b, data.activities, [&](ActivityRec& r, const ActivityRecord& a) {
+      r.datetime = b.transientStr(datetimeText(a).view());
+      r.intensity = b.str(a.intensity.view());
+      r.minutes = a.minutes;
+    });
+
+    // Category directory first, then each category's items.
+    std::size_t catAt = 0;
+    e.categories = b.reserve<CategoryEntry>(data.categories.size(), catAt);
+    std::size_t c = 0;
+    for (const auto& [catName, items] : data.categories) {
+      CategoryEntry ce{};
+      ce.name = b.str(catName);
+      ce.items = packArray<CategoryItemRec>(b, items, [&](CategoryItemRec& r, const CategoryItem& item) {
+        r.datetime = b.transientStr(datetimeText(item).view());
+        r.note = b.str(item.note.view());
+        r.value = item.value;
+      });
+      b.put(catAt, c++, ce);
+    }
+
+    std::size_t segAt = 0;
+    e.segments = b.reserve<SegmentRec>(data.segments.size(), segAt);
+    for (std::size_t i = 0; i < data.segments.size(); ++i) {
+      const Segment& seg = data.segments[i];
+      SegmentRec r{};
+      r.id = seg.id;
+      r.collection = b.str(seg.collection.view());
+      r.category = b.str(seg.category);
+      r.fromMs = seg.fromMs;
+      r.toMs = seg.toMs;
+      r.records = seg.records;
+      b.put(segAt, i, r);
+    }
+
+    dir.push_back(e);
+    if (progress && ++written % 256 == 0) progress(written, users.size());
+  }
+  if (!b.ok()) return false;
+
+  h.stringsOffset = recordsBase + b.records().size();
+  h.stringsSize = b.strings().size();
+  h.fileSize = h.stringsOffset + h.stringsSize;
+
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out.write(reinterpret_cast<const char*>(dir.data()), static_cast<std::streamsize>(dir.size() * sizeof(UserEntry)));
+  out.write(b.records().data(), static_cast<std::streamsize>(b.records().size()));
+  out.write(b.strings().data(), static_cast<std::streamsize>(b.strings().size()));
+  if (progress) progress(users.size(), users.size());
+  return static_cast<bool>(out);
+}
+
+bool readBinarySnapshot(const std::string& path, UserMap& users, std::uint64_t& journalSeq) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return false;
+  ::madvise(map, size, MADV_SEQUENTIAL);
+
+  const char* base = static_cast<const char*>(map);
+  FileHeader h;
+  std::memcpy(&h, base, sizeof(h));
+
+  const bool v3 = h.version == kVersion;
+  const bool v2 = v3 || h.version == kVersionNoSegments;
+  const std::size_t entrySize =
+      v3 ? sizeof(UserEntry) : v2 ? sizeof(UserEntryT<true, false>) : sizeof(UserEntryT<false>);
+  bool ok = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && (v2 || h.version == kVersionNoIds) &&
+            h.endianTag == kEndianTag && h.fileSize == size && h.userDirOffset == sizeof(FileHeader) &&
+            h.userCount <= (size - h.userDirOffset) / entrySize &&
+            h.stringsOffset >= h.userDirOffset + h.userCount * entrySize && h.stringsOffset <= size &&
+            h.stringsSize == size - h.stringsOffset;
+
+  UserMap loaded;
+  if (ok) {
+    ok = v3   ? readUsers<true, true>(base, h, loaded)
+         : v2 ? readUsers<true, false>(base, h, loaded)
+              : readUsers<false, false>(base, h, loaded);
+  }
+  ::munmap(map, size);
+  if (!ok) return false;
+
+  for (auto& [name, data] : loaded) users[name] = std::move(data);
+  journalSeq = h.journalSeq;
+  return true;
+}
@@ -0,0 +1,150 @@
+#include "../../include/core/SnapshotCodec.hpp"
+
+#include <fstream>
+
+#ifdef HEALTH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace codec {
+
+namespace {
+
+constexpr std::size_t kBufferBytes = 64 * 1024;
+
+#ifdef HEALTH_HAVE_ZLIB
+
+// Bytes collect in buf_ and go to gzwrite a buffer at a time. A flush only
+// hands them to zlib; it never forces a deflate block boundary.
+class OutBuf : public std::streambuf {
+ public:
+  OutBuf(const std::string& path, int level) {
+    const std::string mode = "wb" + std::to_string(level);
+    file_ = gzopen(path.c_str(), mode.c_str());
+    if (file_) gzbuffer(file_, kBufferBytes);
+    setp(buf_, buf_ + sizeof(buf_));
+  }
+  ~OutBuf() override { finish(); }
+
+  bool ok() const { return file_ != nullptr && !failed_; }
+
+  bool finish() {
+    if (!file_) return false;
+    drain();
+    if (gzclose(file_) != Z_OK) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+  }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (!drain()) return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+  int sync() override { return drain() ? 0 : -1; }
+
+ private:
+  gzFile file_ = nullptr;
+  bool failed_ = false;
+  char buf_[kBufferBytes];
+
+  bool drain() {
+    const int n = static_cast<int>(pptr() - pbase());
+    if (n > 0 && (!file_ || gzwrite(file_, pbase(), static_cast<unsigned>(n)) != n)) failed_ = true;
+    setp(buf_, buf_ + sizeof(buf_));
+    return !failed_;
+  }
+};
+
+// A corrupt or truncated stream reads as a short one; the JSON parser then
+// rejects it.
+class InBuf : public std::streambuf {
+ public:
+  explicit InBuf(const std::string& path) {
+    file_ = gzopen(path.c_str(), "rb");
+    if (file_) gzbuffer(file_, kBufferBytes);
+  }
+  ~InBuf() override {
+    if (file_) gzclose(file_);
+  }
+
+  bool ok() const { return file_ != nullptr; }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if (!file_) return traits_type::eof();
+    const int n = gzread(file_, buf_, sizeof(buf_));
+    if (n <= 0) return traits_type::eof();
+    setg(buf_, buf_, buf_ + n);
+    return traits_type::to_int_type(*gptr());
+  }
+
+ private:
+  gzFile file_ = nullptr;
+  char buf_[kBufferBytes];
+};
+
+#else
+
+// Passthrough: plain buffered file I/O behind the same interface.
+class OutBuf : public std::filebuf {
+ public:
+  OutBuf(const std::string& path, int /*level*/) { open(path, std::ios::out | std::ios::trunc | std::ios::binary); }
+  bool ok() const { return is_open(); }
+  bool finish() { return close() != nullptr; }
+};
+
+class InBuf : public std::filebuf {
+ public:
+  explicit InBuf(const std::string& path) { open(path, std::ios::in | std::ios::binary); }
+  bool ok() const { return is_open(); }
+};
+
+#endif
+
+}  // namespace
+
+const char* name() {
+#ifdef HEALTH_HAVE_ZLIB
+  return "zlib";
+#else
+  return "none";
+#endif
+}
+
+// ----------------------
+// CompressedOStream
+// ----------------------
+
+CompressedOStream::CompressedOStream(const std::string& path, int level)
+    : std::ostream(nullptr), buf_(std::make_unique<OutBuf>(path, level)) {
+  rdbuf(buf_.get());
+  if (!static_cast<OutBuf*>(buf_.get())->ok()) setstate(std::ios::failbit);
+}
+
+CompressedOStream::~CompressedOStream() = default;
+
+bool CompressedOStream::close() {
+  auto* buf = static_cast<OutBuf*>(buf_.get());
+  if (!buf->finish()) setstate(std::ios::failbit);
+  return static_cast<bool>(*this);
+}
+
+// ----------------------
+// CompressedIStream
+// ----------------------
+
+CompressedIStream::CompressedIStream(const std::string& path)
+    : std::istream(nullptr), buf_(std::make_unique<InBuf>(path)) {
+  rdbuf(buf_.get());
+  if (!static_cast<InBuf*>(buf_.get())->ok()) setstate(std::ios::failbit);
+}
+
+CompressedIStream::~CompressedIStream() = default;
+
+}  // namespace codec
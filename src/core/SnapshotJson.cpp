@@ -0,0 +1,499 @@
+#include "../../include/core/SnapshotJson.hpp"
+
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "../../include/core/RecordSchema.hpp"
+#include "../../include/core/Timestamp.hpp"
+
+using nlohmann::json;
+
+// ----------------------
+// JSON 對應：records / users
+// ----------------------
+
+// A string member in place, "" if it is missing or not a string.
+static std::string_view stringField(const json& j, const char* key) {
+  auto it = j.find(key);
+  if (it == j.end() || !it->is_string()) return {};
+  return it->get_ref<const std::string&>();
+}
+
+// The record types' JSON is generated from their schemas (RecordSchema.hpp).
+json toJson(const WaterRecord& w) { return recordToJson<WaterSchema>(w); }
+json toJson(const SleepRecord& s) { return recordToJson<SleepSchema>(s); }
+json toJson(const ActivityRecord& a) { return recordToJson<ActivitySchema>(a); }
+json toJson(const CategoryItem& item) { return recordToJson<CategoryItemSchema>(item); }
+
+void fromJson(const json& jw, WaterRecord& w) { recordFromJson<WaterSchema>(jw, w); }
+void fromJson(const json& js, SleepRecord& s) { recordFromJson<SleepSchema>(js, s); }
+void fromJson(const json& ja, ActivityRecord& a) { recordFromJson<ActivitySchema>(ja, a); }
+void fromJson(const json& ji, CategoryItem& item) { recordFromJson<CategoryItemSchema>(ji, item); }
+
+json segmentToJson(const Segment& seg) {
+  json js;
+  js["id"] = seg.id;
+  js["collection"] = seg.collection.str();
+  if (!seg.category.empty()) js["category"] = seg.category;
+  js["fromMs"] = seg.fromMs;
+  js["toMs"] = seg.toMs;
+  js["records"] = seg.records;
+  return js;
+}
+
+void segmentFromJson(const json& js, Segment& seg) {
+  seg.id = js.value("id", std::uint64_t{0});
+  seg.collection = stringField(js, "collection");
+  seg.category = stringField(js, "category");
+  seg.fromMs = js.value("fromMs", std::int64_t{0});
+  seg.toMs = js.value("toMs", std::int64_t{0});
+  seg.records = js.value("records", std::uint64_t{0});
+}
+
+template <typename Rec>
+static void readArray(const json& ju, const char* key, RecordSet<Rec>& out) {
+  if (!ju.contains(key) || !ju[key].is_array()) return;
+  for (const auto& jr : ju[key]) {
+    Rec r;
+    fromJson(jr, r);
+    out.push_back(std::move(r));
+  }
+}
+
+template <typename Rec>
+static json writeArray(const RecordSet<Rec>& records) {
+  json arr = json::array();
+  for (const auto& r : records) arr.push_back(toJson(r));
+  return arr;
+}
+
+json profileToJson(const UserData& data) {
+  json ju;
+  ju["id"] = data.profile.id;
+  ju["name"] = data.profile.name;
+  ju["age"] = data.profile.age;
+  ju["weightKg"] = data.profile.weightKg;
+  ju["heightM"] = data.profile.heightM;
+  ju["gender"] = data.profile.gender;
+
+  ju["password"] = data.password;
+  return ju;
+}
+
+void profileFromJson(const json& ju, UserData& data) {
+  std::string name = ju.value("name", "");
+  data.profile.id = ju.value("id", name);
+  data.profile.name = name;
+  data.profile.age = ju.value("age", 0);
+  data.profile.weightKg = ju.value("weightKg", 0.0);
+  data.profile.heightM = ju.value("heightM", 0.0);
+  data.profile.gender = ju.value("gender", std::string("other"));
+
+  data.password = ju.value("password", std::string(""));
+}
+
+// ----------------------
+// Snapshot
+// ----------------------
+
+static json userToJson(const UserData& data) {
+  json ju = profileToJson(data);
+  ju["nextRecordId"] = data.nextRecordId;
+  forEachRecordSchema([&](auto schema) {
+    using Schema = decltype(schema);
+    ju[Schema::kCollection] = writeArray(Schema::records(data));
+  });
+
+  // Categories
+  ju["categories"] = json::object();
+  for (const auto& [catName, items] : data.categories) {
+    ju["categories"][catName] = writeArray(items);
+  }
+
+  // Archived segments; older snapshots have none and look the same.
+  if (!data.segments.empty()) {
+    json segs = json::array();
+    for (const Segment& seg : data.segments) segs.push_back(segmentToJson(seg));
+    ju["segments"] = std::move(segs);
+  }
+  return ju;
+}
+
+json usersToJson(const UserMap& users, std::uint64_t journalSeq, const SnapshotProgress& progress) {
+  json j;
+  j["journalSeq"] = journalSeq;
+  j["users"] = json::array();
+
+  std::size_t written = 0;
+  for (const auto& [name, data] : users) {
+    j["users"].push_back(userToJson(data));
+    if (progress && ++written % 256 == 0) progress(written, users.size());
+  }
+  if (progress) progress(users.size(), users.size());
+  return j;
+}
+
+// Byte for byte what usersToJson(...).dump(indent) prints, one user at a
+// time: "journalSeq" sorts before "users", and each user's dump is shifted
+// two levels in.
+bool writeJsonSnapshot(std::ostream& out, const UserMap& users, std::uint64_t journalSeq, int indent,
+                       const SnapshotProgress& progress) {
+  const bool pretty = indent >= 0;
+  const char* nl = pretty ? "\n" : "";
+  const char* colon = pretty ? ": " : ":";
+  const std::string pad1(pretty ? indent : 0, ' ');
+  const std::string pad2(pretty ? 2 * indent : 0, ' ');
+
+  out << '{' << nl << pad1 << "\"journalSeq\"" << colon << journalSeq << ',' << nl << pad1 << "\"users\"" << colon
+      << '[';
+  bool first = true;
+  std::size_t written = 0;
+  for (const auto& [name, data] : users) {
+    out << (first ? "" : ",") << nl << pad2;
+    first = false;
+    const std::string text = userToJson(data).dump(indent);
+    std::size_t from = 0;
+    for (std::size_t at; pretty && (at = text.find('\n', from)) != std::string::npos; from = at + 1) {
+      out.write(text.data() + from, static_cast<std::streamsize>(at + 1 - from));
+      out << pad2;
+    }
+    out.write(text.data() + from, static_cast<std::streamsize>(text.size() - from));
+    if (progress && ++written % 256 == 0) progress(written, users.size());
+  }
+  if (!users.empty()) out << nl << pad1;
+  out << ']' << nl << '}';
+  if (progress) progress(users.size(), users.size());
+  return static_cast<bool>(out);
+}
+
+bool usersFromJson(const json& j, UserMap& users, std::uint64_t& journalSeq) {
+  if (!j.is_object() || !j.contains("users") || !j["users"].is_array()) return false;
+  journalSeq = j.value("journalSeq", std::uint64_t{0});
+
+  for (const auto& ju : j["users"]) {
+    if (!ju.contains("name")) continue;
+    std::string name = ju.value("name", "");
+
+    UserData data;
+    profileFromJson(ju, data);
+    data.nextRecordId = ju.value("nextRecordId", std::uint64_t{1});
+    forEachRecordSchema([&](auto schema) {
+      using Schema = decltype(schema);
+      readArray(ju, Schema::kCollection, Schema::records(data));
+    });
+
+    // Categories
+    if (ju.contains("categories") && ju["categories"].is_object()) {
+      for (auto it = ju["categories"].begin(); it != ju["categories"].end(); ++it) {
+        if (!it.value().is_array()) continue;
+        RecordSet<CategoryItem> items;
+        for (const auto& ji : it.value()) {
+          CategoryItem item;
+          fromJson(ji, item);
+          items.push_back(std::move(item));
+        }
+        data.categories[it.key()] = std::move(items);
+      }
+    }
+    if (ju.contains("segments") && ju["segments"].is_array()) {
+      for (const auto& js : ju["segments"]) {
+        if (!js.is_object()) continue;
+        Segment seg;
+        segmentFromJson(js, seg);
+        data.segments.push_back(seg);
+      }
+    }
+
+    assignRecordIds(data);
+    users[name] = std::move(data);
+  }
+  return true;
+}
+
+// ----------------------
+// Streaming loader (SAX)
+// ----------------------
+
+namespace {
+
+// Fills UserData straight from parser events, so no DOM is ever built.
+// Tracks where it is with a small stack of contexts; anything unexpected
+// (unknown keys, wrong shapes) is skipped like the DOM loader ignores it.
+class SnapshotSax : public json::json_sax_t {
+ public:
+  explicit SnapshotSax(UserMap& out) : out_(out) {}
+
+  std::uint64_t journalSeq = 0;
+  bool sawUsers = false;
+
+  bool null() override { return true; }
+  bool boolean(bool) override { return true; }
+  bool number_integer(number_integer_t v) override { return number(static_cast<double>(v), v < 0 ? 0 : v); }
+  bool number_unsigned(number_unsigned_t v) override { return number(static_cast<double>(v), v); }
+  bool number_float(number_float_t v, const string_t&) override {
+    return number(v, v < 0 ? 0 : static_cast<std::uint64_t>(v));
+  }
+  bool binary(binary_t&) override { return true; }
+
+  bool string(string_t& v) override {
+    switch (top()) {
+      case Ctx::User:
+        if (key_ == "name") {
+          user_.profile.name = std::move(v);
+          hasName_ = true;
+        } else if (key_ == "id") {
+          user_.profile.id = std::move(v);
+          hasId_ = true;
+        } else if (key_ == "gender") {
+          user_.profile.gender = std::move(v);
+          hasGender_ = true;
+        } else if (key_ == "password") {
+          user_.password = std::move(v);
+        }
+        break;
+      case Ctx::Water:
+        recordText(water_, v);
+        break;
+      case Ctx::Sleep:
+        recordText(sleep_, v);
+        break;
+      case Ctx::Activity:
+        recordText(activity_, v);
+        break;
+      case Ctx::Item:
+        recordText(item_, v);
+        break;
+      case Ctx::Segment:
+        if (key_ == "collection") {
+          segment_.collection = v;
+        } else if (key_ == "category") {
+          segment_.category = v;
+        }
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  bool key(string_t& k) override {
+    key_ = std::move(k);
+    return true;
+  }
+
+  bool start_object(std::size_t) override {
+    Ctx next = Ctx::Skip;
+    switch (top()) {
+      case Ctx::None:
+        next = Ctx::Root;
+        break;
+      case Ctx::Users:
+        next = Ctx::User;
+        user_ = UserData{};
+        hasName_ = hasId_ = hasGender_ = false;
+        break;
+      case Ctx::User:
+        if (key_ == "categories") next = Ctx::Categories;
+        break;
+      case Ctx::Waters:
+        next = Ctx::Water;
+        water_ = WaterRecord{};
+        break;
+      case Ctx::Sleeps:
+        next = Ctx::Sleep;
+        sleep_ = SleepRecord{};
+        break;
+      case Ctx::Activities:
+        next = Ctx::Activity;
+        activity_ = ActivityRecord{};
+        break;
+      case Ctx::Items:
+        next = Ctx::Item;
+        item_ = CategoryItem{};
+        break;
+      case Ctx::Segments:
+        next = Ctx::Segment;
+        segment_ = Segment{};
+        break;
+      default:
+        break;
+    }
+    stack_.push_back(next);
+    return true;
+  }
+
+  bool end_object() override {
+    const Ctx done = top();
+    stack_.pop_back();
+    switch (done) {
+      case Ctx::User:
+        if (hasName_) {
+          if (!hasId_) user_.profile.id = user_.profile.name;
+          if (!hasGender_) user_.profile.gender = "other";
+          assignRecordIds(user_);
+          std::string name = user_.profile.name;
+          out_[name] = std::move(user_);
+        }
+        break;
+      case Ctx::Water:
+        user_.waters.push_back(std::move(water_));
+        break;
+      case Ctx::Sleep:
+        user_.sleeps.push_back(std::move(sleep_));
+        break;
+      case Ctx::Activity:
+        user_.activities.push_back(std::move(activity_));
+        break;
+      case Ctx::Item:
+        items_->push_back(std::move(item_));
+        break;
+      case Ctx::Segment:
+        user_.segments.push_back(segment_);
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    Ctx next = Ctx::Skip;
+    switch (top()) {
+      case Ctx::Root:
+        if (key_ == "users") {
+          next = Ctx::Users;
+          sawUsers = true;
+        }
+        break;
+      case Ctx::User:
+        if (key_ == "waters") next = Ctx::Waters;
+        else if (key_ == "sleeps") next = Ctx::Sleeps;
+        else if (key_ == "activities") next = Ctx::Activities;
+        else if (key_ == "segments") next = Ctx::Segments;
+        break;
+      case Ctx::Categories:
+        next = Ctx::Items;
+        items_ = &user_.categories[key_];
+        *items_ = {};
+        break;
+      default:
+        break;
+    }
+    stack_.push_back(next);
+    return true;
+  }
+
+  bool end_array() override {
+    stack_.pop_back();
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override { return false; }
+
+ private:
+  enum class Ctx { None, Root, Users, User, Waters, Water, Sleeps, Sleep, Activities, Activity, Categories, Items, Item,
+                   Segments, Segment, Skip };
+
+  Ctx top() const { return stack_.empty() ? Ctx::None : stack_.back(); }
+
+  // A record's id and datetime, then the fields its schema names.
+  template <typename Rec>
+  void recordText(Rec& r, const string_t& v) {
+    if (key_ == "datetime") {
+      setDatetime(r, v);
+    } else {
+      setRecordText<SchemaFor<Rec>>(r, key_, v);
+    }
+  }
+  template <typename Rec>
+  void recordNumber(Rec& r, double d, std::uint64_t u) {
+    if (key_ == "id") {
+      r.id = u;
+    } else {
+      setRecordNumber<SchemaFor<Rec>>(r, key_, d);
+    }
+  }
+
+  bool number(double d, std::uint64_t u) {
+    switch (top()) {
+      case Ctx::Root:
+        if (key_ == "journalSeq") journalSeq = u;
+        break;
+      case Ctx::User:
+        if (key_ == "age") user_.profile.age = static_cast<int>(d);
+        else if (key_ == "weightKg") user_.profile.weightKg = d;
+        else if (key_ == "heightM") user_.profile.heightM = d;
+        else if (key_ == "nextRecordId") user_.nextRecordId = u;
+        break;
+      case Ctx::Water:
+        recordNumber(water_, d, u);
+        break;
+      case Ctx::Sleep:
+        recordNumber(sleep_, d, u);
+        break;
+      case Ctx::Activity:
+        recordNumber(activity_, d, u);
+        break;
+      case Ctx::Item:
+        recordNumber(item_, d, u);
+        break;
+      case Ctx::Segment:
+        // Times are well inside the range a double holds exactly.
+        if (key_ == "id") segment_.id = u;
+        else if (key_ == "fromMs") segment_.fromMs = static_cast<std::int64_t>(d);
+        else if (key_ == "toMs") segment_.toMs = static_cast<std::int64_t>(d);
+        else if (key_ == "records") segment_.records = u;
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  UserMap& out_;
+  std::vector<Ctx> stack_;
+  std::string key_;
+
+  UserData user_;
+  bool hasName_ = false, hasId_ = false, hasGender_ = false;
+  WaterRecord water_;
+  SleepRecord sleep_;
+  ActivityRecord activity_;
+  CategoryItem item_;
+  RecordSet<CategoryItem>* items_ = nullptr;
+  ::Segment segment_;
+};
+
+}  // namespace
+
+template <typename Input>
+static bool parseSnapshot(Input&& in, UserMap& users, std::uint64_t& journalSeq) {
+  UserMap loaded;
+  SnapshotSax sax(loaded);
+  bool ok = false;
+  try {
+    ok = json::sax_parse(std::forward<Input>(in), &sax) && sax.sawUsers;
+  } catch (...) {
+    ok = false;
+  }
+  if (!ok) return false;
+
+  journalSeq = sax.journalSeq;
+  for (auto& [name, data] : loaded) users[name] = std::move(data);
+  return true;
+}
+
+bool readJsonSnapshot(const std::string& path, UserMap& users, std::uint64_t& journalSeq) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return false;
+  const bool ok = parseSnapshot(f, users, journalSeq);
+  std::fclose(f);
+  return ok;
+}
+
+bool readJsonSnapshot(std::istream& in, UserMap& users, std::uint64_t& journalSeq) {
+  if (!in) return false;
+  return parseSnapshot(in, users, journalSeq);
+}
@@ -1,11 +1,24 @@
 #include "../../include/core/Storage.hpp"
 
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <set>
+#include <thread>
+
+#include "../../include/core/SnapshotBinary.hpp"
+#include "../../include/core/SnapshotCodec.hpp"
+#include "../../include/utils/Logger.hpp"
 
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
@@ -19,10 +32,13 @@ bool Storage::dirExists(const std::string& path) {
   return S_ISDIR(st.st_mode);
 }
 
-void Storage::ensureStorageDirExists() const {
-  auto pos = storagePath.find_last_of("/\\");
-  if (pos == std::string::npos) return;
-  std::string dir = storagePath.substr(0, pos);
+static std::string parentDir(const std::string& file) {
+  auto pos = file.find_last_of("/\\");
+  return pos == std::string::npos ? "." : file.substr(0, pos);
+}
+
+void Storage::ensureParentDirExists(const std::string& file) {
+  std::string dir = parentDir(file);
   if (!dirExists(dir)) {
     std::filesystem::create_directories(dir);
   }
@@ -54,30 +70,450 @@ Storage::Storage() {
   storagePath = dataFolder + "/storage.json";
   // Force project relative at runtime for predictable dev behavior
   storagePath = "data/storage.json";
+  // STORAGE_PATH overrides it; the extension picks the format (.json / .hbs)
+  if (const char* env = std::getenv("STORAGE_PATH")) {
+    if (*env) storagePath = env;
+  }
+  format_ = formatForPath(storagePath);
+  if (const char* env = std::getenv("STORAGE_LAYOUT")) layout_ = parseLayout(env);
+  initJournal();
 }
 
-Storage::Storage(const std::string& path) : storagePath(path) {}
+Storage::Storage(const std::string& path, Layout layout)
+    : storagePath(path), format_(formatForPath(path)), layout_(layout) {
+  initJournal();
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
 
-json Storage::load() const {
-  std::ifstream in(storagePath);
-  if (!in) return json();
-  json j;
+Storage::Format Storage::formatForPath(const std::string& path) {
+  if (endsWith(path, ".hbs")) return Format::Binary;
+  if (endsWith(path, ".gz")) return Format::CompressedJson;
+  return Format::Json;
+}
+
+const char* Storage::formatName(Format f) {
+  switch (f) {
+    case Format::Binary:
+      return "binary";
+    case Format::CompressedJson:
+      return "json.gz";
+    case Format::Json:
+      break;
+  }
+  return "json";
+}
+
+Storage::Layout Storage::parseLayout(const std::string& s) {
+  return s == "sharded" ? Layout::Sharded : Layout::Single;
+}
+
+const char* Storage::layoutName(Layout l) {
+  return l == Layout::Sharded ? "sharded" : "single";
+}
+
+// ----------------------
+// Sharded layout：data/users/<hash-prefix>/<user>.json|hbs
+// ----------------------
+
+std::string Storage::shardRoot() const {
+  return parentDir(storagePath) + "/users";
+}
+
+static const char* shardExtension(Storage::Format f) {
+  switch (f) {
+    case Storage::Format::Binary:
+      return ".hbs";
+    case Storage::Format::CompressedJson:
+      return ".json.gz";
+    case Storage::Format::Json:
+      break;
+  }
+  return ".json";
+}
+
+// FNV-1a: stable across builds and platforms, unlike std::hash.
+static std::uint32_t fnv1a(const std::string& s) {
+  std::uint32_t h = 2166136261u;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// User names are free-form; keep [A-Za-z0-9_-.] and %-escape the rest so a
+// name can never climb out of its directory or clash with a temp file.
+static std::string escapeFileName(const std::string& name) {
+  static const char hex[] = "0123456789ABCDEF";
+  std::string out;
+  out.reserve(name.size());
+  for (std::size_t i = 0; i < name.size(); ++i) {
+    unsigned char c = static_cast<unsigned char>(name[i]);
+    bool plain = std::isalnum(c) || c == '_' || c == '-' || (c == '.' && i > 0);
+    if (plain) {
+      out.push_back(static_cast<char>(c));
+    } else {
+      out.push_back('%');
+      out.push_back(hex[c >> 4]);
+      out.push_back(hex[c & 0xF]);
+    }
+  }
+  return out;
+}
+
+std::string Storage::shardPathFor(const std::string& user) const {
+  char prefix[3];
+  std::snprintf(prefix, sizeof(prefix), "%02x", fnv1a(user) & 0xFFu);
+  return shardRoot() + "/" + prefix + "/" + escapeFileName(user) + shardExtension(format_);
+}
+
+Storage::~Storage() = default;
+
+// STORAGE_DURABILITY = sync | async | none (default async)
+// STORAGE_FLUSH_MS    = async flush interval (default 10)
+void Storage::initJournal() {
+  Journal::Durability mode = Journal::Durability::Async;
+  if (const char* env = std::getenv("STORAGE_DURABILITY")) mode = Journal::parseDurability(env);
+
+  long flushMs = 10;
+  if (const char* env = std::getenv("STORAGE_FLUSH_MS")) {
+    try {
+      flushMs = std::max(1L, std::stol(env));
+    } catch (...) {
+      // keep default
+    }
+  }
+  if (const char* env = std::getenv("STORAGE_CHECKPOINT_BYTES")) {
+    try {
+      checkpointBytes_ = std::stoull(env);
+    } catch (...) {
+      // keep default
+    }
+  }
+
+  std::string journalPath = storagePath + ".wal";
+  if (layout_ == Layout::Sharded) {
+    journalPath = shardRoot() + "/journal.wal";
+    // First start after switching to shards: carry the single-file journal
+    // over, it still holds changes newer than storagePath (see loadShards).
+    if (!dirExists(shardRoot()) && dirExists(parentDir(storagePath))) {
+      std::error_code ec;
+      std::filesystem::create_directories(shardRoot(), ec);
+      for (const char* suffix : {"", ".1"}) {
+        const std::string from = storagePath + ".wal" + suffix;
+        if (::access(from.c_str(), F_OK) == 0) std::filesystem::rename(from, journalPath + suffix, ec);
+      }
+    }
+  }
+  journal_ = std::make_unique<Journal>(journalPath, mode, std::chrono::milliseconds(flushMs));
+}
+
+// ----------------------
+// Snapshot files
+// ----------------------
+
+static bool readSnapshotFile(const std::string& path, Storage::Format format, UserMap& users,
+                             std::uint64_t& journalSeq) {
+  if (format == Storage::Format::Binary) return readBinarySnapshot(path, users, journalSeq);
+  if (format == Storage::Format::CompressedJson) {
+    codec::CompressedIStream in(path);
+    return readJsonSnapshot(in, users, journalSeq);
+  }
+  return readJsonSnapshot(path, users, journalSeq);
+}
+
+// fsync a file or directory by path.
+static bool syncPath(const std::string& path, int flags) {
+  int fd = ::open(path.c_str(), flags);
+  if (fd < 0) return false;
+  bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+
+// Write to a temp file, fsync it and rename it over `path`, so a crash leaves
+// either the old or the new snapshot but never a half-written one. The
+// directory entry is fsynced too unless the caller batches that (syncDir).
+static bool writeSnapshotFile(const std::string& path, Storage::Format format, const UserMap& users,
+                              std::uint64_t journalSeq, const SnapshotProgress& progress, bool syncDir = true) {
+  const std::string tmpPath = path + ".tmp." + std::to_string(::getpid());
   try {
-    in >> j;
+    bool ok = false;
+    if (format == Storage::Format::CompressedJson) {
+      // Compact: indentation is just more bytes to deflate.
+      codec::CompressedOStream out(tmpPath);
+      ok = out && writeJsonSnapshot(out, users, journalSeq, -1, progress) && out.close();
+    } else {
+      std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+      if (out) {
+        ok = format == Storage::Format::Binary ? writeBinarySnapshot(out, users, journalSeq, progress)
+                                               : writeJsonSnapshot(out, users, journalSeq, 2, progress);
+        out.flush();
+        ok = ok && out;
+      }
+    }
+    if (!ok) {
+      ::unlink(tmpPath.c_str());
+      return false;
+    }
+    if (!syncPath(tmpPath, O_RDONLY) || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+      ::unlink(tmpPath.c_str());
+      return false;
+    }
+    if (syncDir) syncPath(parentDir(path), O_RDONLY | O_DIRECTORY);
+    return true;
   } catch (...) {
-    return json();
+    ::unlink(tmpPath.c_str());
+    return false;
   }
-  return j;
 }
 
-bool Storage::save(const json& j) const {
-  ensureStorageDirExists();
-  try {
-    std::ofstream out(storagePath);
-    if (!out) return false;
-    out << j.dump(2);
+bool Storage::loadSnapshot(UserMap& users, std::uint64_t& journalSeq) const {
+  if (layout_ == Layout::Sharded) return loadShards(users, journalSeq);
+
+  if (!readSnapshotFile(storagePath, format_, users, journalSeq)) return false;
+  for (auto& [_, u] : users) u.persistedSeq = journalSeq;
+  return true;
+}
+
+bool Storage::saveSnapshot(const UserMap& users, std::uint64_t journalSeq, const SnapshotProgress& progress) const {
+  if (layout_ == Layout::Sharded) return saveShards(users, journalSeq, progress);
+
+  ensureParentDirExists(storagePath);
+  return writeSnapshotFile(storagePath, format_, users, journalSeq, progress);
+}
+
+std::vector<std::string> Storage::shardFiles() const {
+  namespace fs = std::filesystem;
+  const std::string ext = shardExtension(format_);
+
+  std::vector<std::string> files;
+  std::error_code ec;
+  for (const auto& prefix : fs::directory_iterator(shardRoot(), ec)) {
+    if (!prefix.is_directory(ec)) continue;
+    for (const auto& f : fs::directory_iterator(prefix.path(), ec)) {
+      const std::string name = f.path().string();
+      // Skips leftover "<user>.json.tmp.<pid>" files from an interrupted save.
+      if (name.size() > ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0) {
+        files.push_back(name);
+      }
+    }
+  }
+  return files;
+}
+
+bool Storage::loadShardFile(const std::string& file, UserMap& users) const {
+  UserMap one;
+  std::uint64_t seq = 0;
+  if (!readSnapshotFile(file, format_, one, seq)) return false;
+  for (auto& [_, u] : one) u.persistedSeq = seq;
+  users.merge(one);
+  return true;
+}
+
+bool Storage::loadShards(UserMap& users, std::uint64_t& journalSeq) const {
+  const std::vector<std::string> files = shardFiles();
+
+  if (files.empty()) {
+    // First start after switching STORAGE_LAYOUT: pick up the single-file
+    // snapshot (its journal was moved over in initJournal) and mark everyone
+    // dirty, so the next save writes all shards.
+    if (!readSnapshotFile(storagePath, format_, users, journalSeq)) return false;
+    for (auto& [_, u] : users) {
+      u.dirty = true;
+      u.persistedSeq = journalSeq;
+    }
+    util::Logger::info(std::string("Storage: migrating ") + std::to_string(users.size()) + " users from " +
+                       storagePath + " to " + shardRoot());
     return true;
+  }
+
+  // Shards are independent files: spread them over a few threads, each
+  // filling its own map, then splice the maps together.
+  std::size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, files.size() / 16 + 1);
+
+  std::vector<UserMap> parts(workers);
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> failed{0};
+  auto loadSome = [&](std::size_t w) {
+    for (std::size_t i = next++; i < files.size(); i = next++) {
+      if (!loadShardFile(files[i], parts[w])) ++failed;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (std::size_t w = 1; w < workers; ++w) threads.emplace_back(loadSome, w);
+  loadSome(0);
+  for (auto& t : threads) t.join();
+
+  for (std::size_t w = 0; w < workers; ++w) users.merge(parts[w]);
+  // Shards are stamped independently (a cache eviction writes just one), so
+  // the oldest stamp says nothing about users without a shard: replay the
+  // whole journal and let the per-user persistedSeq filter it.
+  journalSeq = 0;
+  if (failed > 0) {
+    util::Logger::error(std::string("Storage: ") + std::to_string(failed.load()) + " of " +
+                        std::to_string(files.size()) + " shards under " + shardRoot() + " could not be read");
+  }
+  return failed < files.size();
+}
+
+bool Storage::userExists(const std::string& user) const {
+  return ::access(shardPathFor(user).c_str(), F_OK) == 0;
+}
+
+bool Storage::loadUser(const std::string& user, UserData& out) const {
+  UserMap one;
+  std::uint64_t seq = 0;
+  if (!readSnapshotFile(shardPathFor(user), format_, one, seq)) return false;
+  auto it = one.find(user);
+  if (it == one.end()) return false;
+  out = std::move(it->second);
+  out.persistedSeq = seq;
+  return true;
+}
+
+bool Storage::saveUser(const std::string& user, const UserData& data, std::uint64_t journalSeq) const {
+  const std::string file = shardPathFor(user);
+  UserMap one;
+  one.emplace(user, data);
+  try {
+    ensureParentDirExists(file);
+  } catch (...) {
+    return false;
+  }
+  return writeSnapshotFile(file, format_, one, journalSeq, nullptr);
+}
+
+bool Storage::readManifest(std::uint64_t& journalSeq) const {
+  std::ifstream in(shardRoot() + "/MANIFEST");
+  std::string key;
+  return static_cast<bool>(in >> key >> journalSeq) && key == "journalSeq";
+}
+
+// Rewrite the shard of every dirty user. Directory entries are fsynced once
+// per prefix directory at the end instead of once per file.
+bool Storage::saveShards(const UserMap& users, std::uint64_t journalSeq, const SnapshotProgress& progress) const {
+  std::size_t total = 0;
+  for (const auto& [_, u] : users) total += u.dirty ? 1 : 0;
+
+  bool ok = true;
+  std::size_t written = 0;
+  std::set<std::string> dirs;
+  for (const auto& [name, u] : users) {
+    if (!u.dirty) continue;
+    const std::string file = shardPathFor(name);
+    UserMap one;
+    one.emplace(name, u);
+    try {
+      ensureParentDirExists(file);
+    } catch (...) {
+      // writeSnapshotFile reports it
+    }
+    // No logging here: this runs inside the background snapshot child.
+    if (!writeSnapshotFile(file, format_, one, journalSeq, nullptr, false)) ok = false;
+    dirs.insert(parentDir(file));
+    if (progress && ++written % 64 == 0) progress(written, total);
+  }
+  for (const auto& dir : dirs) syncPath(dir, O_RDONLY | O_DIRECTORY);
+
+  if (ok) {
+    // Same temp + fsync + rename dance as the shards themselves.
+    const std::string manifest = shardRoot() + "/MANIFEST";
+    const std::string tmp = manifest + ".tmp." + std::to_string(::getpid());
+    std::error_code ec;
+    std::filesystem::create_directories(shardRoot(), ec);
+    std::ofstream out(tmp, std::ios::trunc);
+    out << "journalSeq " << journalSeq << "\n";
+    out.close();
+    ok = out && syncPath(tmp, O_RDONLY) && ::rename(tmp.c_str(), manifest.c_str()) == 0;
+    if (!ok) ::unlink(tmp.c_str());
+  }
+  syncPath(shardRoot(), O_RDONLY | O_DIRECTORY);
+  if (progress) progress(total, total);
+  return ok;
+}
+
+// ----------------------
+// Archived segments：data/archive/<hash-prefix>/<user>/<collection>-<id>.seg.gz
+// ----------------------
+
+std::string Storage::segmentPathFor(const std::string& user, const Segment& seg) const {
+  char prefix[3];
+  std::snprintf(prefix, sizeof(prefix), "%02x", fnv1a(user) & 0xFFu);
+  return parentDir(storagePath) + "/archive/" + prefix + "/" + escapeFileName(user) + "/" + seg.collection.str() +
+         "-" + std::to_string(seg.id) + ".seg.gz";
+}
+
+bool Storage::writeSegmentFile(const std::string& user, const Segment& seg,
+                               const std::function<bool(std::ostream&)>& write) const {
+  const std::string path = segmentPathFor(user, seg);
+  const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+  try {
+    ensureParentDirExists(path);
+    codec::CompressedOStream out(tmp);
+    const bool ok = out && write(out) && out.close();
+    if (!ok || !syncPath(tmp, O_RDONLY) || ::rename(tmp.c_str(), path.c_str()) != 0) {
+      ::unlink(tmp.c_str());
+      return false;
+    }
   } catch (...) {
+    ::unlink(tmp.c_str());
     return false;
   }
+  return syncPath(parentDir(path), O_RDONLY | O_DIRECTORY);
+}
+
+void Storage::removeSegmentFile(const std::string& user, const Segment& seg) const {
+  ::unlink(segmentPathFor(user, seg).c_str());
+}
+
+std::size_t Storage::replayJournal(std::uint64_t snapshotSeq, const std::function<void(const json&)>& apply) {
+  return journal_->replay(snapshotSeq, apply);
+}
+
+std::uint64_t Storage::appendJournal(json entry) {
+  return journal_->append(std::move(entry));
+}
+
+std::uint64_t Storage::journalSeq() const {
+  return journal_->lastSeq();
+}
+
+void Storage::advanceJournalSeq(std::uint64_t seq) {
+  journal_->advanceSeq(seq);
+}
+
+bool Storage::needsCheckpoint() const {
+  return journal_->sizeBytes() >= checkpointBytes_;
+}
+
+Journal::Durability Storage::durability() const {
+  return journal_->durability();
+}
+
+Journal::Stats Storage::journalStats() const {
+  return journal_->stats();
+}
+
+std::uintmax_t Storage::journalBytes() const {
+  return journal_->sizeBytes();
+}
+
+bool Storage::sealJournal() {
+  return journal_->seal();
+}
+
+void Storage::dropSealedJournal() {
+  journal_->dropSealed();
+}
+
+bool Storage::checkpoint(const UserMap& users, std::uint64_t journalSeq) {
+  if (!saveSnapshot(users, journalSeq)) return false;
+  // Entries up to snapshot["journalSeq"] are now redundant. If we crash before
+  // the truncate, replay skips them by seq, so the order here is safe.
+  return journal_->reset();
 }
@@ -0,0 +1,21 @@
+#include "../../include/core/StorageEngine.hpp"
+
+#include "../../include/core/FileEngine.hpp"
+
+std::vector<std::string> storageEngineNames() {
+  return {"json", "json-gz", "binary", "sharded", "sharded-gz", "sharded-binary"};
+}
+
+std::unique_ptr<StorageEngine> makeStorageEngine(const std::string& name, const std::string& dir) {
+  if (name == "json") return std::make_unique<FileEngine>(name, dir + "/storage.json");
+  if (name == "json-gz") return std::make_unique<FileEngine>(name, dir + "/storage.json.gz");
+  if (name == "binary") return std::make_unique<FileEngine>(name, dir + "/storage.hbs");
+  if (name == "sharded") return std::make_unique<FileEngine>(name, dir + "/storage.json", Storage::Layout::Sharded);
+  if (name == "sharded-gz") {
+    return std::make_unique<FileEngine>(name, dir + "/storage.json.gz", Storage::Layout::Sharded);
+  }
+  if (name == "sharded-binary") {
+    return std::make_unique<FileEngine>(name, dir + "/storage.hbs", Storage::Layout::Sharded);
+  }
+  return nullptr;
+}
@@ -0,0 +1,93 @@
+#include "../../include/core/Symbol.hpp"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// id → text goes through a fixed directory of fixed-size chunks, so a reader
+// never sees an array being reallocated under it. The text itself lives in
+// `texts`, whose elements never move.
+class Pool {
+ public:
+  static constexpr std::size_t kChunk = 4096;
+  static constexpr std::size_t kChunks = 256;  // 1M symbols
+  static constexpr std::size_t kMaxTextBytes = std::size_t{64} << 20;
+
+  Pool() { add(""); }  // id 0 is ""
+
+  std::uint32_t intern(std::string_view s) {
+    {
+      std::shared_lock<std::shared_mutex> lk(mtx_);
+      auto it = ids_.find(s);
+      if (it != ids_.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lk(mtx_);
+    auto it = ids_.find(s);
+    if (it != ids_.end()) return it->second;
+    return add(s);
+  }
+
+  std::string_view lookup(std::uint32_t id) const {
+    return chunks_[id / kChunk].load(std::memory_order_acquire)[id % kChunk];
+  }
+
+  Symbol::PoolStats stats() const {
+    std::shared_lock<std::shared_mutex> lk(mtx_);
+    Symbol::PoolStats st;
+    st.symbols = ids_.size();
+    st.bytes = textBytes_ + ids_.size() * (sizeof(std::string) + sizeof(std::string_view) + 32);
+    return st;
+  }
+
+ private:
+  mutable std::shared_mutex mtx_;
+  std::unordered_map<std::string_view, std::uint32_t> ids_;  // views into texts_
+  std::deque<std::string> texts_;
+  std::array<std::atomic<std::string_view*>, kChunks> chunks_{};
+  std::vector<std::unique_ptr<std::string_view[]>> owned_;
+  std::size_t textBytes_ = 0;
+
+  // Under the exclusive lock (or from the constructor).
+  std::uint32_t add(std::string_view s) {
+    if (texts_.size() == kChunk * kChunks || textBytes_ + s.size() + 1 > kMaxTextBytes) {
+      throw std::length_error("symbol pool is full");
+    }
+    const auto id = static_cast<std::uint32_t>(texts_.size());
+    if (id % kChunk == 0) {
+      owned_.push_back(std::make_unique<std::string_view[]>(kChunk));
+      chunks_[id / kChunk].store(owned_.back().get(), std::memory_order_release);
+    }
+    const std::string& text = texts_.emplace_back(s);
+    chunks_[id / kChunk].load(std::memory_order_relaxed)[id % kChunk] = text;
+    ids_.emplace(text, id);
+    textBytes_ += text.capacity() + 1;
+    return id;
+  }
+};
+
+Pool& pool() {
+  static Pool p;
+  return p;
+}
+
+}  // namespace
+
+std::uint32_t Symbol::intern(std::string_view s) {
+  return s.empty() ? 0 : pool().intern(s);
+}
+
+std::string_view Symbol::view() const {
+  return id_ == 0 ? std::string_view() : pool().lookup(id_);
+}
+
+Symbol::PoolStats Symbol::poolStats() {
+  return pool().stats();
+}
@@ -0,0 +1,143 @@
+#include "../../include/core/Timestamp.hpp"
+
+namespace {
+
+// Days from 1970-01-01 to y-m-d in the proleptic Gregorian calendar
+// (H. Hinnant's days_from_civil).
+std::int64_t daysFromCivil(std::int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2 ? 1 : 0;
+  const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+// The inverse: y-m-d of a day count (H. Hinnant's civil_from_days).
+void civilFromDays(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) {
+  z += 719468;
+  const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2 ? 1 : 0);
+}
+
+bool isLeap(std::int64_t y) {
+  return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+// Reads exactly `n` digits at `pos`.
+bool digits(std::string_view s, std::size_t& pos, std::size_t n, int& out) {
+  if (pos + n > s.size()) return false;
+  out = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const char c = s[pos + i];
+    if (c < '0' || c > '9') return false;
+    out = out * 10 + (c - '0');
+  }
+  pos += n;
+  return true;
+}
+
+bool expect(std::string_view s, std::size_t& pos, char c) {
+  if (pos >= s.size() || s[pos] != c) return false;
+  ++pos;
+  return true;
+}
+
+}  // namespace
+
+std::int64_t parseTimestamp(std::string_view s) {
+  std::size_t pos = 0;
+  int year = 0, month = 0, day = 0;
+  if (!digits(s, pos, 4, year) || !expect(s, pos, '-') || !digits(s, pos, 2, month) || !expect(s, pos, '-') ||
+      !digits(s, pos, 2, day)) {
+    return kNoTime;
+  }
+  static const int kDaysIn[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (month < 1 || month > 12 || day < 1) return kNoTime;
+  if (day > kDaysIn[month - 1] + (month == 2 && isLeap(year) ? 1 : 0)) return kNoTime;
+
+  int hour = 0, minute = 0, second = 0, millis = 0;
+  if (pos < s.size() && (s[pos] == 'T' || s[pos] == ' ')) {
+    ++pos;
+    if (!digits(s, pos, 2, hour) || !expect(s, pos, ':') || !digits(s, pos, 2, minute)) return kNoTime;
+    if (pos < s.size() && s[pos] == ':') {
+      ++pos;
+      if (!digits(s, pos, 2, second)) return kNoTime;
+      if (pos < s.size() && s[pos] == '.') {
+        ++pos;
+        // Any number of fraction digits; milliseconds are kept.
+        const std::size_t start = pos;
+        int scale = 100;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+          millis += (s[pos] - '0') * scale;
+          scale /= 10;
+          ++pos;
+        }
+        if (pos == start) return kNoTime;
+      }
+    }
+    if (hour > 23 || minute > 59 || second > 60) return kNoTime;  // 60: leap second
+  }
+
+  int offsetMin = 0;
+  if (pos < s.size()) {
+    const char c = s[pos++];
+    if (c == '+' || c == '-') {
+      int oh = 0, om = 0;
+      if (!digits(s, pos, 2, oh)) return kNoTime;
+      if (pos < s.size() && s[pos] == ':') ++pos;
+      if (!digits(s, pos, 2, om) || oh > 23 || om > 59) return kNoTime;
+      offsetMin = (c == '+' ? 1 : -1) * (oh * 60 + om);
+    } else if (c != 'Z') {
+      return kNoTime;
+    }
+  }
+  if (pos != s.size()) return kNoTime;
+
+  const std::int64_t days = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+  const std::int64_t secs = days * 86400 + hour * 3600 + minute * 60 + second - offsetMin * 60;
+  return secs * 1000 + millis;
+}
+
+bool formatTimestamp(std::int64_t ms, char (&out)[kCanonicalTimeLen]) {
+  constexpr std::int64_t kMin = -62167219200000;  // 0000-01-01T00:00:00.000Z
+  constexpr std::int64_t kMax = 253402300799999;  // 9999-12-31T23:59:59.999Z
+  if (ms < kMin || ms > kMax) return false;
+
+  const std::int64_t days = (ms >= 0 ? ms : ms - 86399999) / 86400000;
+  const std::int64_t rest = ms - days * 86400000;  // ms into the day, 0 .. 86399999
+  std::int64_t year = 0;
+  unsigned month = 0, day = 0;
+  civilFromDays(days, year, month, day);
+
+  auto put = [&out](std::size_t at, std::int64_t v, std::size_t n) {
+    for (std::size_t i = n; i-- > 0; v /= 10) out[at + i] = static_cast<char>('0' + v % 10);
+  };
+  put(0, year, 4);
+  out[4] = '-';
+  put(5, month, 2);
+  out[7] = '-';
+  put(8, day, 2);
+  out[10] = 'T';
+  put(11, rest / 3600000, 2);
+  out[13] = ':';
+  put(14, rest / 60000 % 60, 2);
+  out[16] = ':';
+  put(17, rest / 1000 % 60, 2);
+  out[19] = '.';
+  put(20, rest % 1000, 3);
+  out[23] = 'Z';
+  return true;
+}
+
+bool isCanonicalTimestamp(std::string_view text, std::int64_t ms) {
+  char buf[kCanonicalTimeLen];
+  return text.size() == kCanonicalTimeLen && formatTimestamp(ms, buf) &&
+         text == std::string_view(buf, kCanonicalTimeLen);
+}
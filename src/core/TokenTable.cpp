@@ -0,0 +1,83 @@
+#include "../../include/core/TokenTable.hpp"
+
+#include <cstring>
+#include <functional>
+
+#include "../../include/core/Epoch.hpp"
+
+TokenTable::TokenTable(std::size_t initialCapacity) {
+  std::size_t n = 16;
+  while (n < initialCapacity) n <<= 1;
+  array_.store(new Array(n), std::memory_order_release);
+}
+
+// No reader may be left at this point; entries go with entries_.
+TokenTable::~TokenTable() {
+  delete array_.load();
+}
+
+std::size_t TokenTable::hash(std::string_view token) {
+  return std::hash<std::string_view>{}(token);
+}
+
+std::size_t TokenTable::capacity() const {
+  EpochDomain::Guard pin;
+  return array_.load(std::memory_order_acquire)->mask + 1;
+}
+
+// ----------------------
+// Lookup（lock-free）
+// ----------------------
+
+const UserHandle* TokenTable::find(std::string_view token) const {
+  if (token.size() != kTokenLength) return nullptr;
+  EpochDomain::Guard pin;  // keeps the array alive if an insert grows the table meanwhile
+  const Array* array = array_.load(std::memory_order_acquire);
+  for (std::size_t i = hash(token) & array->mask;; i = (i + 1) & array->mask) {
+    const Entry* e = array->slots[i].load(std::memory_order_acquire);
+    if (!e) return nullptr;
+    if (std::memcmp(e->token, token.data(), kTokenLength) == 0) return e->user;
+  }
+}
+
+// ----------------------
+// Insert / grow（writers hold writeMtx_）
+// ----------------------
+
+// The array is at most half full, so an empty slot is always found.
+void TokenTable::place(Array& array, Entry* entry) {
+  const std::string_view token(entry->token, kTokenLength);
+  for (std::size_t i = hash(token) & array.mask;; i = (i + 1) & array.mask) {
+    if (!array.slots[i].load(std::memory_order_relaxed)) {
+      array.slots[i].store(entry, std::memory_order_release);
+      return;
+    }
+  }
+}
+
+bool TokenTable::insert(std::string_view token, const UserHandle* user) {
+  if (token.size() != kTokenLength) return false;
+  std::lock_guard<std::mutex> lk(writeMtx_);
+  if (find(token)) return false;
+
+  const Array* array = array_.load(std::memory_order_relaxed);
+  if ((size_.load(std::memory_order_relaxed) + 1) * 2 > array->mask + 1) grow();
+
+  auto entry = std::make_unique<Entry>();
+  std::memcpy(entry->token, token.data(), kTokenLength);
+  entry->user = user;
+  place(*array_.load(std::memory_order_relaxed), entry.get());
+  entries_.push_back(std::move(entry));
+  size_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+// Readers keep probing the old array until they see the new one; it holds
+// the same entries, so either answers correctly.
+void TokenTable::grow() {
+  Array* old = array_.load(std::memory_order_relaxed);
+  auto bigger = std::make_unique<Array>((old->mask + 1) * 2);
+  for (const auto& e : entries_) place(*bigger, e.get());
+  array_.store(bigger.release(), std::memory_order_release);
+  EpochDomain::global().retire([old] { delete old; });
+}
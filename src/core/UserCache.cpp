@@ -0,0 +1,79 @@
+#include "../../include/core/UserCache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+std::size_t UserCache::budgetFromEnv() {
+  return bytesFromEnv("STORAGE_CACHE_BYTES", 0);
+}
+
+std::size_t UserCache::bytesFromEnv(const char* var, std::size_t fallback) {
+  const char* env = std::getenv(var);
+  if (!env || !*env) return fallback;
+  try {
+    std::size_t used = 0;
+    unsigned long long n = std::stoull(env, &used);
+    switch (std::toupper(static_cast<unsigned char>(env[used]))) {
+      case 'G':
+        n <<= 10;
+        [[fallthrough]];
+      case 'M':
+        n <<= 10;
+        [[fallthrough]];
+      case 'K':
+        n <<= 10;
+        break;
+      default:
+        break;
+    }
+    return static_cast<std::size_t>(n);
+  } catch (...) {
+    return fallback;
+  }
+}
+
+void UserCache::hit(const std::string& name) {
+  ++hits_;
+  if (!bounded()) return;
+  std::lock_guard<std::mutex> lk(lruMtx_);
+  auto it = pos_.find(name);
+  if (it != pos_.end()) lru_.splice(lru_.begin(), lru_, it->second);
+}
+
+void UserCache::admit(const std::string& name, std::size_t bytes, bool miss) {
+  if (miss) ++misses_;
+  ++users_;
+  bytes_ += static_cast<std::int64_t>(bytes);
+  if (!bounded()) return;
+  std::lock_guard<std::mutex> lk(lruMtx_);
+  lru_.push_front(name);
+  pos_[name] = lru_.begin();
+}
+
+void UserCache::evict(const std::string& name, std::size_t bytes) {
+  ++evictions_;
+  --users_;
+  bytes_ -= static_cast<std::int64_t>(bytes);
+  std::lock_guard<std::mutex> lk(lruMtx_);
+  auto it = pos_.find(name);
+  if (it == pos_.end()) return;
+  lru_.erase(it->second);
+  pos_.erase(it);
+}
+
+std::vector<std::string> UserCache::coldest() const {
+  std::lock_guard<std::mutex> lk(lruMtx_);
+  return std::vector<std::string>(lru_.rbegin(), lru_.rend());
+}
+
+UserCache::Stats UserCache::stats() const {
+  Stats s;
+  s.budgetBytes = budget_;
+  s.residentBytes = residentBytes();
+  s.hits = hits_;
+  s.misses = misses_;
+  s.evictions = evictions_;
+  s.residentUsers = users_;
+  return s;
+}
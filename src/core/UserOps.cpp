@@ -0,0 +1,232 @@
+#include "../../include/core/UserOps.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "../../include/core/RecordSchema.hpp"
+#include "../../include/core/SnapshotJson.hpp"
+
+using nlohmann::json;
+
+json makeUserOp(const char* kind, const char* coll) {
+  json op;
+  op["op"] = kind;
+  op["coll"] = coll;
+  return op;
+}
+
+std::uint64_t assignRecordId(const UserData& user, json& op) {
+  if (op.value("op", "") != "add" || !op.contains("rec") || !op["rec"].is_object()) return 0;
+  op["rec"]["id"] = user.nextRecordId;
+  return user.nextRecordId;
+}
+
+// The record an update / delete is for. Journals written before records had
+// ids address them by position ("index") instead.
+template <typename Rec>
+static std::uint64_t targetId(const RecordSet<Rec>& set, const json& op) {
+  if (op.contains("id")) return op.value("id", std::uint64_t{0});
+  return set.idAt(op.value("index", std::numeric_limits<std::size_t>::max()));
+}
+
+// `bytes` tracks approxBytes() of the user as records come and go.
+template <typename Rec>
+static bool applyRecordOp(RecordSet<Rec>& set, const std::string& kind, const json& op, UserData& user) {
+  if (kind == "add") {
+    Rec r;
+    fromJson(op.at("rec"), r);
+    if (r.id == 0) r.id = user.nextRecordId;  // journal written before records had ids
+    if (r.id < user.nextRecordId) return false;  // ids are never reused
+    user.nextRecordId = r.id + 1;
+    user.bytes += approxBytes(r);
+    set.push_back(std::move(r));
+    return true;
+  }
+
+  Rec* cur = set.find(targetId(set, op));
+  if (!cur) return false;
+
+  if (kind == "update") {
+    Rec r;
+    fromJson(op.at("rec"), r);
+    r.id = cur->id;
+    user.bytes -= approxBytes(*cur);
+    user.bytes += approxBytes(r);
+    *cur = std::move(r);
+    return true;
+  }
+  if (kind == "delete") {
+    user.bytes -= approxBytes(*cur);
+    set.erase(cur->id);
+    return true;
+  }
+  return false;
+}
+
+bool isArchivable(std::int64_t timeMs, std::int64_t before) {
+  return timeMs != kNoTime && timeMs < before;
+}
+
+// The segment file was written before the op was logged; this only moves
+// the records out. The op names how many it holds, so a replay onto
+// anything but the state it was cut from changes nothing.
+template <typename Rec>
+static bool applyArchiveOp(RecordSet<Rec>& set, const json& op, UserData& user) {
+  const std::int64_t before = op.value("before", kNoTime);
+  Segment seg;
+  segmentFromJson(op.at("segment"), seg);
+  seg.collection = op.value("coll", "");
+  seg.category = op.value("category", "");
+
+  std::vector<std::uint64_t> ids;
+  for (const Rec& r : set) {
+    if (isArchivable(r.timeMs, before)) ids.push_back(r.id);
+  }
+  if (ids.empty() || ids.size() != seg.records) return false;
+  for (std::uint64_t id : ids) {
+    user.bytes -= approxBytes(*set.find(id));
+    set.erase(id);
+  }
+  user.segments.push_back(seg);
+  user.bytes += sizeof(Segment);
+  // Segment ids come from the record id counter, so a file name is never reused.
+  user.nextRecordId = std::max(user.nextRecordId, seg.id + 1);
+  return true;
+}
+
+// The op carries the segment's records, so replay does not need the file,
+// which is removed once a snapshot covers the op.
+template <typename Rec>
+static bool applyRestoreOp(RecordSet<Rec>& set, const std::string& coll, const std::string& category,
+                           const json& op, UserData& user) {
+  const std::uint64_t segId = op.value("segment", std::uint64_t{0});
+  auto seg = std::find_if(user.segments.begin(), user.segments.end(), [&](const Segment& s) {
+    return s.id == segId && s.collection.view() == coll && s.category == category;
+  });
+  if (seg == user.segments.end()) return false;
+
+  std::vector<Rec> records;
+  for (const json& jr : op.at("recs")) {
+    Rec r;
+    fromJson(jr, r);
+    if (r.id == 0 || set.find(r.id)) return false;
+    records.push_back(std::move(r));
+  }
+  for (const Rec& r : records) user.bytes += approxBytes(r);
+  set.merge(std::move(records));
+  user.segments.erase(seg);
+  user.bytes -= sizeof(Segment);
+  return true;
+}
+
+// The checks applyRecordOp / applyArchiveOp / applyRestoreOp make before
+// they touch anything, without parsing the records themselves.
+template <typename Rec>
+static bool setOpApplies(const RecordSet<Rec>& set, const std::string& kind, const std::string& coll,
+                         const std::string& category, const json& op, const UserData& user) {
+  if (kind == "add") {
+    if (!op.contains("rec") || !op["rec"].is_object()) return false;
+    const std::uint64_t id = op["rec"].value("id", std::uint64_t{0});
+    return id == 0 || id >= user.nextRecordId;
+  }
+  if (kind == "update") return op.contains("rec") && set.find(targetId(set, op)) != nullptr;
+  if (kind == "delete") return set.find(targetId(set, op)) != nullptr;
+  if (kind == "archive") {
+    if (!op.contains("segment")) return false;
+    const std::int64_t before = op.value("before", kNoTime);
+    const std::uint64_t records = op["segment"].value("records", std::uint64_t{0});
+    std::uint64_t n = 0;
+    for (const Rec& r : set) {
+      if (isArchivable(r.timeMs, before)) ++n;
+    }
+    return n != 0 && n == records;
+  }
+  if (kind == "restore") {
+    const std::uint64_t segId = op.value("segment", std::uint64_t{0});
+    const bool known = std::any_of(user.segments.begin(), user.segments.end(), [&](const Segment& s) {
+      return s.id == segId && s.collection.view() == coll && s.category == category;
+    });
+    if (!known || !op.contains("recs") || !op["recs"].is_array()) return false;
+    for (const json& jr : op["recs"]) {
+      const std::uint64_t id = jr.value("id", std::uint64_t{0});
+      if (id == 0 || set.find(id)) return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool canApplyUserOp(const UserData& user, const json& op) {
+  const std::string kind = op.value("op", "");
+  const std::string coll = op.value("coll", "");
+
+  bool matched = false, applies = false;
+  forEachRecordSchema([&](auto schema) {
+    using Schema = decltype(schema);
+    if (matched || coll != Schema::kCollection) return;
+    matched = true;
+    applies = setOpApplies(Schema::records(user), kind, coll, "", op, user);
+  });
+  if (matched) return applies;
+
+  if (coll == "categories") {
+    const std::string catName = op.value("category", "");
+    auto it = user.categories.find(catName);
+    if (kind == "create") return !catName.empty() && it == user.categories.end();
+    if (it == user.categories.end()) return false;
+    if (kind == "drop") return true;
+    return setOpApplies(it->second, kind, coll, catName, op, user);
+  }
+  return false;
+}
+
+bool applyUserOp(UserData& user, const json& op) {
+  const std::string kind = op.value("op", "");
+  const std::string coll = op.value("coll", "");
+
+  // The top-level collections, one per schema.
+  bool matched = false, applied = false;
+  forEachRecordSchema([&](auto schema) {
+    using Schema = decltype(schema);
+    if (matched || coll != Schema::kCollection) return;
+    matched = true;
+    auto& records = Schema::records(user);
+    if (kind == "archive") {
+      applied = applyArchiveOp(records, op, user);
+    } else if (kind == "restore") {
+      applied = applyRestoreOp(records, coll, "", op, user);
+    } else {
+      applied = applyRecordOp(records, kind, op, user);
+    }
+  });
+  if (matched) return applied;
+
+  if (coll == "categories") {
+    const std::string catName = op.value("category", "");
+    auto it = user.categories.find(catName);
+    if (kind == "create") {
+      if (catName.empty() || it != user.categories.end()) return false;
+      user.categories[catName] = {};
+      user.bytes += approxCategoryBytes(catName, {});
+      return true;
+    }
+    if (it == user.categories.end()) return false;
+    if (kind == "drop") {
+      user.bytes -= approxCategoryBytes(it->first, it->second);
+      const std::size_t segments = user.segments.size();
+      user.segments.erase(std::remove_if(user.segments.begin(), user.segments.end(),
+                                         [&](const Segment& s) {
+                                           return s.collection.view() == coll && s.category == it->first;
+                                         }),
+                          user.segments.end());
+      user.bytes -= (segments - user.segments.size()) * sizeof(Segment);
+      user.categories.erase(it);
+      return true;
+    }
+    if (kind == "archive") return applyArchiveOp(it->second, op, user);
+    if (kind == "restore") return applyRestoreOp(it->second, coll, catName, op, user);
+    return applyRecordOp(it->second, kind, op, user);
+  }
+  return false;
+}
@@ -0,0 +1,84 @@
+#include "../../include/core/UserVersion.hpp"
+
+#include "../../include/core/RecordSchema.hpp"
+
+std::unique_ptr<UserVersion> makeUserVersion(const UserData& u) {
+  auto v = std::make_unique<UserVersion>();
+  v->version = 1;
+  v->profile = u.profile;
+  forEachRecordSchema([&](auto schema) {
+    using Schema = decltype(schema);
+    Schema::published(*v) = RecordList<typename Schema::Record>(Schema::records(u));
+  });
+  for (const auto& [name, items] : u.categories) {
+    v->categories.emplace(name, RecordList<CategoryItem>(items));
+  }
+  v->segments = std::make_shared<const std::vector<Segment>>(u.segments);
+  return v;
+}
+
+std::unique_ptr<UserVersion> nextUserVersion(const UserVersion& prev, const UserData& u, const std::string& coll,
+                                             const std::string& category) {
+  auto v = std::make_unique<UserVersion>(prev);
+  v->version = prev.version + 1;
+  v->profile = u.profile;
+  forEachRecordSchema([&](auto schema) {
+    using Schema = decltype(schema);
+    if (coll == Schema::kCollection) Schema::published(*v) = RecordList<typename Schema::Record>(Schema::records(u));
+  });
+  if (coll == "categories") {
+    // Create / drop change the key set; add / update / delete one list.
+    v->categories.clear();
+    for (const auto& [name, items] : u.categories) {
+      auto old = prev.categories.find(name);
+      if (name != category && old != prev.categories.end()) {
+        v->categories.emplace(name, old->second);
+      } else {
+        v->categories.emplace(name, RecordList<CategoryItem>(items));
+      }
+    }
+  }
+  // Segments are only ever appended (archive) or removed (restore, drop),
+  // one kind per op, so a change always shows in the count.
+  if (u.segments.size() != prev.segments->size()) {
+    v->segments = std::make_shared<const std::vector<Segment>>(u.segments);
+  }
+  return v;
+}
+
+template <typename Rec>
+static CollectionFootprint collectionFootprint(const RecordSet<Rec>& records, const RecordList<Rec>* published) {
+  CollectionFootprint c;
+  c.records = records.size();
+  c.recordBytes = heapBytes(records);
+  if (published) c.publishedBytes = published->bytes();
+  return c;
+}
+
+UserFootprint footprintOf(const UserData& u, const UserVersion* published) {
+  UserFootprint f;
+  f.name = u.profile.name;
+  f.otherBytes = sizeof(UserData) + u.profile.id.capacity() + u.profile.name.capacity() + u.password.capacity();
+  f.waters = collectionFootprint(u.waters, published ? &published->waters : nullptr);
+  f.sleeps = collectionFootprint(u.sleeps, published ? &published->sleeps : nullptr);
+  f.activities = collectionFootprint(u.activities, published ? &published->activities : nullptr);
+  f.otherBytes += u.segments.capacity() * sizeof(Segment);
+  if (published) f.otherBytes += sizeof(UserVersion) + published->segments->capacity() * sizeof(Segment);
+
+  // A map node per category on each side: the key, the set or list, and
+  // the node's links (about four pointers).
+  constexpr std::size_t kNodeLinks = 4 * sizeof(void*);
+  for (const auto& [name, items] : u.categories) {
+    const RecordList<CategoryItem>* list = nullptr;
+    if (published) {
+      auto it = published->categories.find(name);
+      if (it != published->categories.end()) {
+        list = &it->second;
+        f.otherBytes += sizeof(*it) + kNodeLinks;
+      }
+    }
+    f.categories += collectionFootprint(items, list);
+    f.otherBytes += sizeof(name) + sizeof(items) + kNodeLinks;
+  }
+  return f;
+}
@@ -0,0 +1,204 @@
+#include "../../include/routes/AdminRoutes.hpp"
+
+#include <cstdlib>
+
+#include "../../include/routes/Helpers.hpp"
+#include "../../include/server/WorkerPool.hpp"
+#include "../../third_party/json.hpp"
+
+using json = RequestJson;
+
+static json snapshotStatusJson(const BackgroundSnapshot::Status& st) {
+  json j;
+  j["state"] = BackgroundSnapshot::stateName(st.state);
+  j["pid"] = st.pid;
+  j["journalSeq"] = st.journalSeq;
+  j["usersWritten"] = st.usersWritten;
+  j["usersTotal"] = st.usersTotal;
+  j["startedAtMs"] = st.startedAtMs;
+  j["finishedAtMs"] = st.finishedAtMs;
+  j["lastSuccessAtMs"] = st.lastSuccessAtMs;
+  j["lastSuccessSeq"] = st.lastSuccessSeq;
+  if (!st.lastError.empty()) j["lastError"] = st.lastError;
+  return j;
+}
+
+static json laneJson(const server::WorkStealingPool::LaneStats& st) {
+  json j;
+  j["requests"] = st.requests;
+  j["inFlight"] = st.inFlight;
+  j["waiting"] = st.waiting;
+  j["avgMs"] = st.avgMs;
+  j["maxMs"] = st.maxMs;
+  return j;
+}
+
+// Gauges of the HTTP worker pool; null when the server runs httplib's own pool.
+static json httpPoolJson() {
+  const server::WorkStealingPool* pool = server::WorkStealingPool::active();
+  if (!pool) return nullptr;
+  const server::WorkStealingPool::Stats st = pool->stats();
+  json j;
+  j["workers"] = st.workers;
+  j["maxWorkers"] = st.maxWorkers;
+  j["threads"] = st.threads;
+  j["busy"] = st.busy;
+  j["blocked"] = st.blocked;
+  j["queued"] = st.queued;
+  j["queueWaitAvgMs"] = st.queueWaitAvgMs;
+  j["queueWaitMaxMs"] = st.queueWaitMaxMs;
+  j["completed"] = st.completed;
+  j["steals"] = st.steals;
+  j["rejected"] = st.rejected;
+  j["extraStarted"] = st.extraStarted;
+  j["readLane"] = laneJson(st.read);
+  j["writeLane"] = laneJson(st.write);
+  return j;
+}
+
+// Shard-per-core executor: one entry per shard thread (empty when locked).
+static json executorJson(const HealthBackend& backend) {
+  json j;
+  j["mode"] = backend.executionMode();
+  j["shards"] = json::array();
+  for (const ShardExecutor::ShardStats& st : backend.executorStats()) {
+    json s;
+    s["tasks"] = st.tasks;
+    s["queued"] = st.queued;
+    s["cpu"] = st.cpu;
+    j["shards"].push_back(s);
+  }
+  return j;
+}
+
+static json archiveJson(const HealthBackend::ArchiveStats& st) {
+  json j;
+  j["enabled"] = st.ageMs > 0;
+  j["ageDays"] = st.ageMs / (24 * 60 * 60 * 1000);
+  j["batch"] = st.minRecords;
+  j["segmentsWritten"] = st.segmentsWritten;
+  j["recordsArchived"] = st.recordsArchived;
+  j["segmentReads"] = st.segmentReads;
+  j["segmentReadErrors"] = st.segmentReadErrors;
+  j["segmentsRestored"] = st.segmentsRestored;
+  j["cache"]["budgetBytes"] = st.cache.budgetBytes;
+  j["cache"]["bytes"] = st.cache.bytes;
+  j["cache"]["segments"] = st.cache.segments;
+  j["cache"]["hits"] = st.cache.hits;
+  j["cache"]["misses"] = st.cache.misses;
+  return j;
+}
+
+static json collectionJson(const CollectionFootprint& c) {
+  json j;
+  j["records"] = c.records;
+  j["recordBytes"] = c.recordBytes;
+  j["publishedBytes"] = c.publishedBytes;
+  j["bytes"] = c.bytes();
+  return j;
+}
+
+static json collectionsJson(const CollectionFootprint& waters, const CollectionFootprint& sleeps,
+                            const CollectionFootprint& activities, const CollectionFootprint& categories) {
+  json j;
+  j["waters"] = collectionJson(waters);
+  j["sleeps"] = collectionJson(sleeps);
+  j["activities"] = collectionJson(activities);
+  j["categories"] = collectionJson(categories);
+  return j;
+}
+
+void registerAdminRoutes(httplib::Server& svr, HealthBackend& backend) {
+  svr.Get("/admin/stats", [&backend](const httplib::Request&, httplib::Response& res) {
+    Journal::Stats js = backend.persistenceStats();
+    json j;
+    j["durability"] = backend.durabilityMode();
+    j["layout"] = backend.storageLayout();
+    j["dirtyUsers"] = backend.dirtyUsers();
+    j["journal"]["lastSeq"] = js.lastSeq;
+    j["journal"]["durableSeq"] = js.durableSeq;
+    j["journal"]["pendingEntries"] = js.pendingEntries;
+    j["journal"]["flushLagMs"] = js.lagMs;
+    j["journal"]["flushes"] = js.flushes;
+    j["journal"]["maxBatch"] = js.maxBatch;
+    j["journal"]["failedBatches"] = js.failedBatches;
+    UserCache::Stats cs = backend.cacheStats();
+    j["cache"]["budgetBytes"] = cs.budgetBytes;
+    j["cache"]["residentBytes"] = cs.residentBytes;
+    j["cache"]["residentUsers"] = cs.residentUsers;
+    j["cache"]["hits"] = cs.hits;
+    j["cache"]["misses"] = cs.misses;
+    j["cache"]["evictions"] = cs.evictions;
+    j["archive"] = archiveJson(backend.archiveStats());
+    j["executor"] = executorJson(backend);
+    j["httpPool"] = httpPoolJson();
+    sendJson(res, 200, j);
+  });
+
+  // ?limit= largest users to list (default 10, 0 for none).
+  svr.Get("/admin/memory", [&backend](const httplib::Request& req, httplib::Response& res) {
+    std::size_t limit = 10;
+    if (req.has_param("limit")) {
+      char* end = nullptr;
+      const std::string text(queryParam(req, "limit"));
+      const unsigned long long n = std::strtoull(text.c_str(), &end, 10);
+      if (text.empty() || *end != '\0') {
+        json err;
+        err["errorMessage"] = "Invalid limit";
+        sendJson(res, 400, err);
+        return;
+      }
+      limit = static_cast<std::size_t>(n);
+    }
+
+    const HealthBackend::MemoryReport report = backend.memoryReport(limit);
+    const std::size_t records = report.waters.records + report.sleeps.records + report.activities.records +
+                          report.categories.records;
+    json j;
+    j["users"] = report.users;
+    j["records"] = records;
+    j["bytes"] = report.bytes;
+    j["bytesPerUser"] = report.users ? static_cast<double>(report.bytes) / report.users : 0.0;
+    j["bytesPerRecord"] = records ? static_cast<double>(report.bytes) / records : 0.0;
+    j["collections"] = collectionsJson(report.waters, report.sleeps, report.activities, report.categories);
+    j["largest"] = json::array();
+    for (const UserFootprint& f : report.largest) {
+      json u;
+      u["name"] = f.name;
+      u["records"] = f.records();
+      u["bytes"] = f.bytes();
+      u["collections"] = collectionsJson(f.waters, f.sleeps, f.activities, f.categories);
+      j["largest"].push_back(std::move(u));
+    }
+    sendJson(res, 200, j);
+  });
+
+  // Archive every resident user's old records now (STORAGE_ARCHIVE_DAYS).
+  svr.Post("/admin/archive", [&backend](const httplib::Request&, httplib::Response& res) {
+    if (backend.archiveStats().ageMs <= 0) {
+      json err;
+      err["errorMessage"] = "Archiving is off (set STORAGE_ARCHIVE_DAYS)";
+      sendJson(res, 409, err);
+      return;
+    }
+    const std::size_t segments = backend.archiveNow();
+    json j = archiveJson(backend.archiveStats());
+    j["segments"] = segments;
+    sendJson(res, 200, j);
+  });
+
+  svr.Get("/admin/snapshot", [&backend](const httplib::Request&, httplib::Response& res) {
+    sendJson(res, 200, snapshotStatusJson(backend.snapshotStatus()));
+  });
+
+  svr.Post("/admin/snapshot", [&backend](const httplib::Request&, httplib::Response& res) {
+    if (!backend.startBackgroundSnapshot()) {
+      json err;
+      err["errorMessage"] = "Snapshot already running or could not be started";
+      err["snapshot"] = snapshotStatusJson(backend.snapshotStatus());
+      sendJson(res, 409, err);
+      return;
+    }
+    sendJson(res, 202, snapshotStatusJson(backend.snapshotStatus()));
+  });
+}
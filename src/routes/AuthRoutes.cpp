@@ -4,7 +4,7 @@
 #include "../../include/utils/Logger.hpp"
 #include "../../third_party/json.hpp"
 
-using json = nlohmann::ordered_json;
+using json = RequestJson;
 
 void registerAuthRoutes(httplib::Server& svr, HealthBackend& backend) {
   svr.Post("/register", [&backend](const httplib::Request& req, httplib::Response& res) {
@@ -14,8 +14,7 @@ void registerAuthRoutes(httplib::Server& svr, HealthBackend& backend) {
           !j.contains("heightM") || !j.contains("gender")) {
         json err;
         err["errorMessage"] = "Missing or invalid fields";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
 
@@ -30,8 +29,7 @@ void registerAuthRoutes(httplib::Server& svr, HealthBackend& backend) {
       if (!ok) {
         json err;
         err["errorMessage"] = "User already exists";
-        res.status = 409;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 409, err);
         return;
       }
 
@@ -39,21 +37,18 @@ void registerAuthRoutes(httplib::Server& svr, HealthBackend& backend) {
       if (token == "INVALID") {
         json err;
         err["errorMessage"] = "Internal error when generating token";
-        res.status = 500;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 500, err);
         return;
       }
 
       json out;
       out["token"] = token;
-      res.status = 201;
-      res.set_content(out.dump(), "application/json");
+      sendJson(res, 201, out);
       util::Logger::info(std::string("POST /register: user=") + name + " token=" + token);
     } catch (const std::exception& e) {
       json err;
       err["errorMessage"] = std::string("Invalid JSON: ") + e.what();
-      res.status = 400;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 400, err);
     }
   });
 
@@ -63,8 +58,7 @@ void registerAuthRoutes(httplib::Server& svr, HealthBackend& backend) {
       if (!j.contains("name") || !j.contains("password")) {
         json err;
         err["errorMessage"] = "Missing name or password";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
 
@@ -75,22 +69,19 @@ void registerAuthRoutes(httplib::Server& svr, HealthBackend& backend) {
       if (token == "INVALID") {
         json err;
         err["errorMessage"] = "Invalid name or password";
-        res.status = 401;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 401, err);
         util::Logger::warn(std::string("POST /login failed: user=") + name);
         return;
       }
 
       json out;
       out["token"] = token;
-      res.status = 200;
-      res.set_content(out.dump(), "application/json");
+      sendJson(res, 200, out);
       util::Logger::info(std::string("POST /login: user=") + name + " token=" + token);
     } catch (const std::exception& e) {
       json err;
       err["errorMessage"] = std::string("Invalid JSON: ") + e.what();
-      res.status = 400;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 400, err);
     }
   });
 }
@@ -1,39 +1,39 @@
 #include "../../include/routes/CategoryRoutes.hpp"
 
+#include <optional>
+
 #include "../../include/routes/Helpers.hpp"
 #include "../../third_party/json.hpp"
 
-using json = nlohmann::ordered_json;
+using json = RequestJson;
 
 void registerCategoryRoutes(httplib::Server& svr, HealthBackend& backend) {
   svr.Get("/category/list", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
-    auto cats = backend.getOtherCategories(token);
     json arr = json::array();
-    for (const auto& name : cats) {
-      json jc;
-      jc["id"] = name;
-      jc["categoryName"] = name;
-      arr.push_back(jc);
-    }
-    res.status = 200;
-    res.set_content(arr.dump(), "application/json");
+    backend.readUser(token, [&](const UserVersion& user) {
+      for (const auto& [name, _items] : user.categories) {
+        json jc;
+        jc["id"] = name;
+        jc["categoryName"] = name;
+        arr.push_back(std::move(jc));
+      }
+    });
+    sendJson(res, 200, arr);
   });
 
   svr.Post("/category/create", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
     try {
@@ -41,48 +41,42 @@ void registerCategoryRoutes(httplib::Server& svr, HealthBackend& backend) {
       if (!j.contains("categoryName")) {
         json err;
         err["errorMessage"] = "Missing categoryName";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
-      std::string name = j["categoryName"].get<std::string>();
+      const std::string_view name = jsonString(j["categoryName"]);
       bool ok = backend.createCategory(token, name);
       if (!ok) {
         json err;
         err["errorMessage"] = "Category already exists or invalid name";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
       json out;
       out["id"] = name;
       out["categoryName"] = name;
-      res.status = 201;
-      res.set_content(out.dump(), "application/json");
+      sendJson(res, 201, out);
     } catch (const std::exception& e) {
       json err;
       err["errorMessage"] = std::string("Invalid JSON: ") + e.what();
-      res.status = 400;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 400, err);
     }
   });
 
   svr.Delete(R"(/category/([^/]+)$)", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
-    std::string categoryId = req.matches[1];
+    const std::string_view categoryId = pathParam(req, 1);
     bool ok = backend.deleteCategory(token, categoryId);
     if (!ok) {
       json err;
       err["errorMessage"] = "Category not found";
-      res.status = 404;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 404, err);
       return;
     }
     res.status = 204;
@@ -90,151 +84,141 @@ void registerCategoryRoutes(httplib::Server& svr, HealthBackend& backend) {
   });
 
   svr.Get(R"(/category/([^/]+)/list)", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
-    std::string categoryId = req.matches[1];
-    auto records = backend.getOtherRecords(token, categoryId);
-    if (records.empty()) {
+    const std::string_view categoryId = pathParam(req, 1);
+    if (backend.countOtherRecords(token, categoryId) == 0) {
       json err;
       err["errorMessage"] = "Category not found or no items";
-      res.status = 404;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 404, err);
       return;
     }
-    json arr = json::array();
-    for (std::size_t i = 0; i < records.size(); ++i) {
-      const auto& r = records[i];
-      json jr;
-      jr["id"] = std::to_string(i);
-      jr["datetime"] = r.datetime;
-      jr["note"] = r.note;
-      arr.push_back(jr);
-    }
-    res.status = 200;
-    res.set_content(arr.dump(), "application/json");
+    auto fetch = [&](const RecordQuery& q) { return backend.queryOtherRecords(token, categoryId, q); };
+    sendRecordList<CategoryItemSchema>(req, res, fetch);
   });
 
   svr.Post(R"(/category/([^/]+)/add)", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
-    std::string categoryId = req.matches[1];
+    const std::string_view categoryId = pathParam(req, 1);
     try {
       json j = json::parse(req.body);
       if (!j.contains("datetime") || !j.contains("note")) {
         json err;
         err["errorMessage"] = "Missing datetime or note";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
-      std::string datetime = j["datetime"].get<std::string>();
-      std::string note = j["note"].get<std::string>();
-      bool ok = backend.addOtherRecord(token, categoryId, datetime, 0.0, note);
-      if (!ok) {
+      const std::string_view datetime = jsonString(j["datetime"]);
+      const std::string_view note = jsonString(j["note"]);
+      const std::uint64_t id = backend.addOtherRecord(token, categoryId, datetime, 0.0, note);
+      if (id == 0) {
         json err;
         err["errorMessage"] = "Category not found or invalid data";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
-      auto records = backend.getOtherRecords(token, categoryId);
-      std::size_t idx = records.size() - 1;
-      const auto& r = records[idx];
       json out;
-      out["id"] = std::to_string(idx);
+      out["id"] = std::to_string(id);
       out["categoryId"] = categoryId;
-      out["datetime"] = r.datetime;
-      out["note"] = r.note;
-      res.status = 201;
-      res.set_content(out.dump(), "application/json");
+      out["datetime"] = datetime;
+      out["note"] = note;
+      sendJson(res, 201, out);
     } catch (const std::exception& e) {
       json err;
       err["errorMessage"] = std::string("Invalid JSON: ") + e.what();
-      res.status = 400;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 400, err);
     }
   });
 
   svr.Patch(R"(/category/([^/]+)/([^/]+))", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
-    std::string categoryId = req.matches[1];
+    const std::string_view categoryId = pathParam(req, 1);
     std::string itemIdStr = req.matches[2];
-    std::size_t index = 0;
+    std::uint64_t id = 0;
+    try {
+      id = std::stoull(itemIdStr);
+    } catch (...) {
+      json err;
+      err["errorMessage"] = "Invalid item id";
+      sendJson(res, 400, err);
+      return;
+    }
     try {
       json j = json::parse(req.body);
-      auto records = backend.getOtherRecords(token, categoryId);
-      if (index >= records.size()) {
+      const std::optional<CategoryItem> cur = backend.findOtherRecord(token, categoryId, id);
+      if (!cur) {
         json err;
         err["errorMessage"] = "Category or item not found";
-        res.status = 404;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 404, err);
         return;
       }
-      std::string newDatetime = records[index].datetime;
-      std::string newNote = records[index].note;
-      double value = records[index].value;
-      if (j.contains("datetime")) newDatetime = j["datetime"].get<std::string>();
-      if (j.contains("note")) newNote = j["note"].get<std::string>();
-      bool ok = backend.updateOtherRecord(token, categoryId, index, newDatetime, value, newNote);
+      const DatetimeText curDatetime = datetimeText(*cur);
+      std::string_view newDatetime = curDatetime;
+      std::string_view newNote = cur->note.view();
+      double value = cur->value;
+      if (j.contains("datetime")) newDatetime = jsonString(j["datetime"]);
+      if (j.contains("note")) newNote = jsonString(j["note"]);
+      bool ok = backend.updateOtherRecord(token, categoryId, id, newDatetime, value, newNote);
       if (!ok) {
         json err;
         err["errorMessage"] = "Failed to update category item";
-        res.status = 400;
-        res.set_content(err.dump(), "application/json");
+        sendJson(res, 400, err);
         return;
       }
       json out;
-      out["id"] = std::to_string(index);
+      out["id"] = itemIdStr;
       out["categoryId"] = categoryId;
       out["datetime"] = newDatetime;
       out["note"] = newNote;
-      res.status = 200;
-      res.set_content(out.dump(), "application/json");
+      sendJson(res, 200, out);
     } catch (const std::exception& e) {
       json err;
       err["errorMessage"] = std::string("Invalid JSON: ") + e.what();
-      res.status = 400;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 400, err);
     }
   });
 
   svr.Delete(R"(/category/([^/]+)/([^/]+))", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
-    std::string categoryId = req.matches[1];
+    const std::string_view categoryId = pathParam(req, 1);
     std::string itemIdStr = req.matches[2];
-    std::size_t index = 0;
-    bool ok = backend.deleteOtherRecord(token, categoryId, index);
+    std::uint64_t id = 0;
+    try {
+      id = std::stoull(itemIdStr);
+    } catch (...) {
+      json err;
+      err["errorMessage"] = "Invalid item id";
+      sendJson(res, 400, err);
+      return;
+    }
+    bool ok = backend.deleteOtherRecord(token, categoryId, id);
     if (!ok) {
       json err;
       err["errorMessage"] = "Category or item not found";
-      res.status = 404;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 404, err);
       return;
     }
     res.status = 204;
@@ -3,14 +3,28 @@
 #include "../../include/routes/Helpers.hpp"
 #include "../../third_party/json.hpp"
 
-using json = nlohmann::ordered_json;
+using json = RequestJson;
 
-void registerHealthRoutes(httplib::Server& svr, HealthBackend&) {
+void registerHealthRoutes(httplib::Server& svr, HealthBackend& backend) {
   svr.Get("/health", [](const httplib::Request&, httplib::Response& res) {
     json j;
     j["status"] = "ok";
     j["message"] = "health_backend server running";
-    res.status = 200;
-    res.set_content(j.dump(), "application/json");
+    sendJson(res, 200, j);
+  });
+
+  // Readiness: 200 once the startup load is done, 503 with progress before.
+  // With STORAGE_WARMUP=background the server already answers requests
+  // before that (loading users on demand), so /health stays the liveness probe.
+  svr.Get("/ready", [&backend](const httplib::Request&, httplib::Response& res) {
+    HealthBackend::WarmupStatus st = backend.warmupStatus();
+    json j;
+    j["ready"] = st.ready;
+    j["mode"] = st.mode;
+    j["usersLoaded"] = st.usersLoaded;
+    j["usersTotal"] = st.usersTotal;
+    j["residentUsers"] = backend.cacheStats().residentUsers;
+    j["elapsedMs"] = st.elapsedMs;
+    sendJson(res, st.ready ? 200 : 503, j);
   });
 }
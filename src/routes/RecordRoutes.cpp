@@ -0,0 +1,165 @@
+#include "../../include/routes/RecordRoutes.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../include/routes/Helpers.hpp"
+#include "../../third_party/json.hpp"
+
+using json = RequestJson;
+
+static void sendError(httplib::Response& res, int status, std::string_view message) {
+  json err;
+  err["errorMessage"] = message;
+  sendJson(res, status, err);
+}
+
+// "Missing datetime or amountMl", "Missing datetime, minutes or intensity".
+template <typename Schema>
+static std::string missingFieldsMessage() {
+  std::vector<std::string> keys{"datetime"};
+  forEachField<Schema>([&](const auto& f) {
+    if (f.api) keys.push_back(f.key);
+  });
+  std::string message = "Missing " + keys.front();
+  for (std::size_t i = 1; i < keys.size(); ++i) message += (i + 1 == keys.size() ? " or " : ", ") + keys[i];
+  return message;
+}
+
+template <typename Schema>
+static bool hasApiFields(const json& j) {
+  bool all = j.contains("datetime");
+  forEachField<Schema>([&](const auto& f) { all = all && (!f.api || j.contains(f.key)); });
+  return all;
+}
+
+// The datetime and API fields `j` has, onto `r`. Throws (json::type_error)
+// on a value of the wrong type.
+template <typename Schema>
+static void readApiFields(const json& j, typename Schema::Record& r) {
+  if (j.contains("datetime")) setDatetime(r, jsonString(j.at("datetime")));
+  forEachField<Schema>([&](const auto& f) {
+    if (!f.api || !j.contains(f.key)) return;
+    using T = typename std::decay_t<decltype(f)>::Type;
+    if constexpr (std::decay_t<decltype(f)>::kNumber) {
+      r.*f.member = j.at(f.key).template get<T>();
+    } else {
+      r.*f.member = jsonString(j.at(f.key));
+    }
+  });
+}
+
+// The id in the path; false after sending a 400 if it is not one.
+template <typename Schema>
+static bool pathId(const httplib::Request& req, httplib::Response& res, std::uint64_t& id) {
+  try {
+    id = std::stoull(req.matches[1]);
+    return true;
+  } catch (...) {
+    sendError(res, 400, std::string("Invalid ") + Schema::kNoun + " id");
+    return false;
+  }
+}
+
+template <typename Schema>
+static void registerCollection(httplib::Server& svr, HealthBackend& backend) {
+  using Record = typename Schema::Record;
+  const std::string path = std::string("/") + Schema::kCollection;
+  const std::string itemPath = path + R"(/(\d+))";
+
+  svr.Post(path, [&backend](const httplib::Request& req, httplib::Response& res) {
+    static const std::string missing = missingFieldsMessage<Schema>();
+    std::string_view token = getTokenFromAuthHeader(req);
+    if (token.empty()) {
+      sendError(res, 401, "Missing or invalid Authorization token");
+      return;
+    }
+    try {
+      json j = json::parse(req.body);
+      if (!hasApiFields<Schema>(j)) {
+        sendError(res, 400, missing);
+        return;
+      }
+      Record rec;
+      readApiFields<Schema>(j, rec);
+      rec.id = backend.addRecord<Schema>(token, rec);
+      if (rec.id == 0) {
+        sendError(res, 400, std::string("Failed to add ") + Schema::kNoun + " record");
+        return;
+      }
+      ArenaString out;
+      appendRecordJson<Schema>(out, viewOf<Schema>(rec));
+      sendJsonText(res, 201, out);
+    } catch (const std::length_error& e) {
+      sendError(res, 400, e.what());  // a new interned value (Symbol) with the pool full
+    } catch (const std::exception& e) {
+      sendError(res, 400, std::string("Invalid JSON: ") + e.what());
+    }
+  });
+
+  svr.Get(path, [&backend](const httplib::Request& req, httplib::Response& res) {
+    std::string_view token = getTokenFromAuthHeader(req);
+    if (token.empty()) {
+      sendError(res, 401, "Missing or invalid Authorization token");
+      return;
+    }
+    sendRecordList<Schema>(req, res, [&](const RecordQuery& q) { return backend.queryRecords<Schema>(token, q); });
+  });
+
+  // Archived records are found too; updating one restores its segment. The
+  // fields sent are merged into the stored record, and the result must be
+  // within the schema's bounds (validRecord), as for POST: out of range is
+  // a 400, as it was with the per-type update methods.
+  svr.Patch(itemPath, [&backend](const httplib::Request& req, httplib::Response& res) {
+    std::string_view token = getTokenFromAuthHeader(req);
+    if (token.empty()) {
+      sendError(res, 401, "Missing or invalid Authorization token");
+      return;
+    }
+    std::uint64_t id = 0;
+    if (!pathId<Schema>(req, res, id)) return;
+    try {
+      json j = json::parse(req.body);
+      const std::optional<Record> cur = backend.findRecord<Schema>(token, id);
+      if (!cur) {
+        sendError(res, 404, "Record not found");
+        return;
+      }
+      Record rec = *cur;
+      readApiFields<Schema>(j, rec);
+      if (!backend.updateRecord<Schema>(token, id, rec)) {
+        sendError(res, 400, std::string("Failed to update ") + Schema::kNoun + " record");
+        return;
+      }
+      ArenaString out;
+      appendRecordJson<Schema>(out, pathParam(req, 1), viewOf<Schema>(rec));
+      sendJsonText(res, 200, out);
+    } catch (const std::length_error& e) {
+      sendError(res, 400, e.what());  // a new interned value (Symbol) with the pool full
+    } catch (const std::exception& e) {
+      sendError(res, 400, std::string("Invalid JSON: ") + e.what());
+    }
+  });
+
+  svr.Delete(itemPath, [&backend](const httplib::Request& req, httplib::Response& res) {
+    std::string_view token = getTokenFromAuthHeader(req);
+    if (token.empty()) {
+      sendError(res, 401, "Missing or invalid Authorization token");
+      return;
+    }
+    std::uint64_t id = 0;
+    if (!pathId<Schema>(req, res, id)) return;
+    if (!backend.deleteRecord<Schema>(token, id)) {
+      sendError(res, 404, "Record not found");
+      return;
+    }
+    res.status = 204;
+    res.set_content("", "application/json");
+  });
+}
+
+void registerRecordRoutes(httplib::Server& svr, HealthBackend& backend) {
+  forEachRecordSchema([&](auto schema) { registerCollection<decltype(schema)>(svr, backend); });
+}
@@ -1,17 +1,15 @@
-#include "../../include/routes/ActivityRoutes.hpp"
+#include "../../include/routes/AdminRoutes.hpp"
 #include "../../include/routes/AuthRoutes.hpp"
 #include "../../include/routes/CategoryRoutes.hpp"
 #include "../../include/routes/HealthRoutes.hpp"
-#include "../../include/routes/SleepRoutes.hpp"
+#include "../../include/routes/RecordRoutes.hpp"
 #include "../../include/routes/UserRoutes.hpp"
-#include "../../include/routes/WaterRoutes.hpp"
 
 void registerRoutes(httplib::Server& svr, HealthBackend& backend) {
   registerHealthRoutes(svr, backend);
   registerAuthRoutes(svr, backend);
   registerUserRoutes(svr, backend);
-  registerWaterRoutes(svr, backend);
-  registerSleepRoutes(svr, backend);
-  registerActivityRoutes(svr, backend);
+  registerRecordRoutes(svr, backend);
   registerCategoryRoutes(svr, backend);
+  registerAdminRoutes(svr, backend);
 }
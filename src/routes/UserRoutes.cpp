@@ -3,46 +3,43 @@
 #include "../../include/routes/Helpers.hpp"
 #include "../../third_party/json.hpp"
 
-using json = nlohmann::ordered_json;
+using json = RequestJson;
 
 void registerUserRoutes(httplib::Server& svr, HealthBackend& backend) {
   svr.Get("/user/profile", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
 
-    UserProfile profile;
-    if (!backend.getUserProfile(token, profile)) {
+    json out;
+    const bool found = backend.readUser(token, [&](const UserVersion& user) {
+      const UserProfile& profile = user.profile;
+      out["id"] = profile.id;
+      out["name"] = profile.name;
+      out["gender"] = profile.gender;
+      out["weightKg"] = profile.weightKg;
+      out["heightM"] = profile.heightM;
+      out["age"] = profile.age;
+    });
+    if (!found) {
       json err;
       err["errorMessage"] = "Profile not found";
-      res.status = 404;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 404, err);
       return;
     }
-
-    json out;
-    out["id"] = profile.id;
-    out["name"] = profile.name;
-    out["gender"] = profile.gender;
-    out["weightKg"] = profile.weightKg;
-    out["heightM"] = profile.heightM;
-    out["age"] = profile.age;
-    res.status = 200;
-    res.set_content(out.dump(), "application/json");
+    sendJson(res, 200, out);
   });
 
   svr.Get("/user/bmi", [&backend](const httplib::Request& req, httplib::Response& res) {
-    std::string token = getTokenFromAuthHeader(req);
+    std::string_view token = getTokenFromAuthHeader(req);
     if (token.empty()) {
       json err;
       err["errorMessage"] = "Missing or invalid Authorization token";
-      res.status = 401;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 401, err);
       return;
     }
 
@@ -50,13 +47,11 @@ void registerUserRoutes(httplib::Server& svr, HealthBackend& backend) {
     if (bmi <= 0.0) {
       json err;
       err["errorMessage"] = "Profile not found";
-      res.status = 404;
-      res.set_content(err.dump(), "application/json");
+      sendJson(res, 404, err);
       return;
     }
     json out;
     out["bmi"] = bmi;
-    res.status = 200;
-    res.set_content(out.dump(), "application/json");
+    sendJson(res, 200, out);
   });
 }
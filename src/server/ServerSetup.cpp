@@ -1,13 +1,17 @@
 #include "../../include/server/ServerSetup.hpp"
 
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
-#include <mutex>
+#include <memory_resource>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
+#include "../../include/server/WorkerPool.hpp"
 #include "../../include/utils/Logger.hpp"
+#include "../../include/utils/RequestArena.hpp"
 #include "../../third_party/httplib.h"
 #include "../../third_party/json.hpp"
 
@@ -15,8 +19,26 @@ using json = nlohmann::ordered_json;
 
 namespace server {
 
-static std::mutex g_req_mtx;
-static std::unordered_map<const httplib::Request*, std::chrono::steady_clock::time_point> g_req_start;
+// A request runs on one worker from pre-routing to post-routing, so its
+// start time and lane are per-thread: no shared map, no lock, no allocation.
+static thread_local std::chrono::steady_clock::time_point t_requestStart;
+
+// The lane of the request this worker is handling: entered once the route
+// matched, left in post-routing (which runs for every response).
+static thread_local std::optional<WorkStealingPool::LaneScope> t_lane;
+
+static std::string_view originOf(const httplib::Request& req) {
+  auto it = req.headers.find("Origin");
+  return it == req.headers.end() ? std::string_view("-") : std::string_view(it->second);
+}
+
+// "METHOD path" plus `tail`, in the request arena.
+static std::pmr::string requestLine(const httplib::Request& req, std::string_view tail) {
+  std::pmr::string line(util::RequestArena::resource());
+  line.reserve(req.method.size() + req.path.size() + tail.size() + 1);
+  line.append(req.method).append(" ").append(req.path).append(tail);
+  return line;
+}
 
 void initLoggerFromEnv() {
   const char* logFileEnv = std::getenv("LOG_FILE");
@@ -38,6 +60,18 @@ void initLoggerFromEnv() {
 }
 
 void setupServerCommon(httplib::Server& svr) {
+  // Work-stealing connection pool with a write lane (HTTP_WORKERS etc.)
+  svr.new_task_queue = [] { return new WorkStealingPool(WorkStealingPool::optionsFromEnv()); };
+
+  // Reads run as they are; writes and logins (anything but GET / HEAD)
+  // queue for a write slot, and the pool covers for the worker meanwhile.
+  svr.set_pre_request_handler([](const httplib::Request& req, httplib::Response& /*res*/) {
+    const bool read = req.method == "GET" || req.method == "HEAD";
+    t_lane.reset();
+    t_lane.emplace(read ? WorkStealingPool::Lane::Read : WorkStealingPool::Lane::Write);
+    return httplib::Server::HandlerResponse::Unhandled;
+  });
+
   // CORS preflight
   svr.Options(R"(.*)", [](const httplib::Request& req, httplib::Response& res) {
     res.set_header("Access-Control-Allow-Origin", "*");
@@ -61,18 +95,22 @@ void setupServerCommon(httplib::Server& svr) {
     }
   });
 
-  // Pre-routing: record start time and basic request info
+  // Pre-routing: a fresh request arena, start time and basic request info
   svr.set_pre_routing_handler(
       [&](const httplib::Request& req, httplib::Response& /*res*/) -> httplib::Server::HandlerResponse {
-        std::lock_guard<std::mutex> lk(g_req_mtx);
-        g_req_start[&req] = std::chrono::steady_clock::now();
-        auto origin = req.has_header("Origin") ? req.get_header_value("Origin") : "-";
-        util::Logger::info(req.method + std::string(" ") + req.path + " Origin:" + origin);
+        util::RequestArena::reset();
+        t_requestStart = std::chrono::steady_clock::now();
+        if (util::Logger::enabled(util::LogLevel::Info)) {
+          std::pmr::string line = requestLine(req, " Origin:");
+          line.append(originOf(req));
+          util::Logger::info(line);
+        }
         return httplib::Server::HandlerResponse::Unhandled;
       });
 
   // Post-routing: add CORS headers if missing and log duration
   svr.set_post_routing_handler([&](const httplib::Request& req, httplib::Response& res) {
+    t_lane.reset();
     if (res.get_header_value("Access-Control-Allow-Origin").empty()) {
       res.set_header("Access-Control-Allow-Origin", "*");
     }
@@ -82,28 +120,27 @@ void setupServerCommon(httplib::Server& svr) {
     if (res.get_header_value("Access-Control-Allow-Methods").empty()) {
       res.set_header("Access-Control-Allow-Methods", "GET, POST, PATCH, DELETE, OPTIONS");
     }
-
-    std::chrono::steady_clock::time_point start;
-    {
-      std::lock_guard<std::mutex> lk(g_req_mtx);
-      auto it = g_req_start.find(&req);
-      if (it != g_req_start.end()) {
-        start = it->second;
-        g_req_start.erase(it);
-      }
+    if (res.has_header("X-Next-Cursor")) {
+      res.set_header("Access-Control-Expose-Headers", "X-Next-Cursor");  // readable by browser clients
     }
-    if (start.time_since_epoch().count() > 0) {
+
+    const auto start = t_requestStart;
+    t_requestStart = {};
+    if (start.time_since_epoch().count() > 0 && util::Logger::enabled(util::LogLevel::Info)) {
       auto dur =
           std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
-      util::Logger::info(req.method + std::string(" ") + req.path + " -> " + std::to_string(res.status) + " (" +
-                         std::to_string(dur) + " ms)");
+      char tail[48];
+      std::snprintf(tail, sizeof(tail), " -> %d (%lld ms)", res.status, static_cast<long long>(dur));
+      util::Logger::info(requestLine(req, tail));
     }
   });
 
   // httplib logging -> our Logger
   svr.set_logger([](const httplib::Request& req, const httplib::Response& /*res*/) {
-    auto origin = req.has_header("Origin") ? req.get_header_value("Origin") : "-";
-    util::Logger::debug(std::string("httplib log: ") + req.method + " " + req.path + " Origin:" + origin);
+    if (!util::Logger::enabled(util::LogLevel::Debug)) return;
+    std::pmr::string line = requestLine(req, " Origin:");
+    line.insert(0, "httplib log: ").append(originOf(req));
+    util::Logger::debug(line);
   });
 
   svr.set_error_logger([](const httplib::Error& err, const httplib::Request* req) {
@@ -0,0 +1,296 @@
+#include "../../include/server/WorkerPool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include "../../include/utils/Logger.hpp"
+
+namespace server {
+
+namespace {
+
+thread_local WorkStealingPool* tlsPool = nullptr;
+std::atomic<WorkStealingPool*> activePool{nullptr};
+
+constexpr auto kExtraIdle = std::chrono::seconds(1);
+
+std::size_t envSize(const char* name, std::size_t fallback) {
+  if (const char* env = std::getenv(name)) {
+    try {
+      return static_cast<std::size_t>(std::max(0L, std::stol(env)));
+    } catch (...) {
+      // keep default
+    }
+  }
+  return fallback;
+}
+
+std::uint64_t sinceUs(std::chrono::steady_clock::time_point t) {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t).count());
+}
+
+void updateMax(std::atomic<std::uint64_t>& max, std::uint64_t v) {
+  std::uint64_t cur = max.load(std::memory_order_relaxed);
+  while (v > cur && !max.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+// HTTP_WORKERS / HTTP_MAX_WORKERS / HTTP_WRITE_CONCURRENCY / HTTP_MAX_QUEUED
+WorkStealingPool::Options WorkStealingPool::optionsFromEnv() {
+  Options o;
+  o.workers = std::max<std::size_t>(1, envSize("HTTP_WORKERS", CPPHTTPLIB_THREAD_POOL_COUNT));
+  o.maxWorkers = std::max(o.workers, envSize("HTTP_MAX_WORKERS", o.workers * 4));
+  o.writeSlots = std::max<std::size_t>(1, envSize("HTTP_WRITE_CONCURRENCY", o.workers));
+  o.maxQueued = envSize("HTTP_MAX_QUEUED", 0);
+  return o;
+}
+
+WorkStealingPool::WorkStealingPool(const Options& opts) : opts_(opts) {
+  for (std::size_t i = 0; i < opts_.workers; ++i) deques_.push_back(std::make_unique<Deque>());
+  std::lock_guard<std::mutex> lk(threadsMtx_);
+  for (std::size_t i = 0; i < opts_.workers; ++i) {
+    ++threads_;
+    workers_.emplace_back([this, i] { workerLoop(i, false, 0); });
+  }
+  activePool = this;
+  util::Logger::info(std::string("HTTP pool: ") + std::to_string(opts_.workers) + " workers, up to " +
+                     std::to_string(opts_.maxWorkers) + " threads, " + std::to_string(opts_.writeSlots) +
+                     " write slots");
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  shutdown();
+  WorkStealingPool* self = this;
+  activePool.compare_exchange_strong(self, nullptr);
+}
+
+WorkStealingPool* WorkStealingPool::active() {
+  return activePool.load();
+}
+
+// ----------------------
+// Queue：per-worker deques + stealing
+// ----------------------
+
+bool WorkStealingPool::enqueue(std::function<void()> fn) {
+  if (opts_.maxQueued > 0 && queued_.load() >= opts_.maxQueued) {
+    ++rejected_;
+    return false;
+  }
+  Deque& d = *deques_[nextDeque_++ % deques_.size()];
+  {
+    // Counted under the deque's lock, like the decrement in take(), so it
+    // never runs behind a take() of this task and queued_ cannot wrap; a
+    // worker that sees queued_ > 0 finds the task once it gets the lock.
+    std::lock_guard<std::mutex> lk(d.mtx);
+    d.tasks.push_back({std::move(fn), std::chrono::steady_clock::now()});
+    ++queued_;
+  }
+  // Announced under sleepMtx_, so one about to sleep gets the wake-up.
+  {
+    std::lock_guard<std::mutex> lk(sleepMtx_);
+  }
+  wake_.notify_one();
+  return true;
+}
+
+// Own deque from the front, then the other deques from the back.
+bool WorkStealingPool::take(std::size_t own, Task& out) {
+  const std::size_t n = deques_.size();
+  if (own < n) {
+    Deque& d = *deques_[own];
+    std::lock_guard<std::mutex> lk(d.mtx);
+    if (!d.tasks.empty()) {
+      out = std::move(d.tasks.front());
+      d.tasks.pop_front();
+      --queued_;
+      return true;
+    }
+  }
+  const std::size_t start = own < n ? own + 1 : nextDeque_.load();
+  for (std::size_t k = 0; k < n; ++k) {
+    const std::size_t i = (start + k) % n;
+    if (i == own) continue;
+    Deque& d = *deques_[i];
+    std::lock_guard<std::mutex> lk(d.mtx);
+    if (!d.tasks.empty()) {
+      out = std::move(d.tasks.back());
+      d.tasks.pop_back();
+      --queued_;
+      ++steals_;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Extra threads own no deque (own == deques_.size()) and only steal.
+void WorkStealingPool::workerLoop(std::size_t own, bool extra, std::uint64_t extraId) {
+  tlsPool = this;
+  for (;;) {
+    Task task;
+    if (!take(own, task)) {
+      std::unique_lock<std::mutex> lk(sleepMtx_);
+      const auto ready = [this] { return shutdown_ || queued_.load() > 0; };
+      if (!extra) {
+        wake_.wait(lk, ready);
+      } else if (!wake_.wait_for(lk, kExtraIdle, ready) && threads_.load() - blocked_.load() > opts_.workers) {
+        break;  // idle and no longer needed
+      }
+      if (shutdown_ && queued_.load() == 0) break;
+      continue;
+    }
+
+    const std::uint64_t waitedUs = sinceUs(task.queuedAt);
+    waitTotalUs_ += waitedUs;
+    updateMax(waitMaxUs_, waitedUs);
+    ++busy_;
+    try {
+      task.fn();
+    } catch (...) {
+      // httplib handles request errors itself; never let one kill a worker.
+    }
+    --busy_;
+    ++completed_;
+  }
+  --threads_;
+  tlsPool = nullptr;
+  if (extra) {
+    std::lock_guard<std::mutex> lk(threadsMtx_);
+    finished_.push_back(extraId);
+  }
+}
+
+void WorkStealingPool::shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(sleepMtx_);
+    if (shutdown_) return;
+    shutdown_ = true;
+  }
+  wake_.notify_all();
+  // Workers drain what is queued, like httplib's ThreadPool. No extra thread
+  // starts once shutdown_ is set, so this collects all of them.
+  std::vector<std::thread> all;
+  {
+    std::lock_guard<std::mutex> lk(threadsMtx_);
+    all.swap(workers_);
+    for (auto& [_, t] : extras_) all.push_back(std::move(t));
+    extras_.clear();
+  }
+  for (auto& t : all) {
+    if (t.joinable()) t.join();
+  }
+}
+
+// ----------------------
+// Write lane：slots + compensation
+// ----------------------
+
+void WorkStealingPool::beginBlocking() {
+  ++blocked_;
+  startExtraIfNeeded();
+}
+
+void WorkStealingPool::endBlocking() {
+  --blocked_;
+}
+
+// Keep `workers` threads free of the write lane while there is room.
+void WorkStealingPool::startExtraIfNeeded() {
+  std::lock_guard<std::mutex> lk(threadsMtx_);
+  for (std::uint64_t id : finished_) {
+    auto it = extras_.find(id);
+    if (it == extras_.end()) continue;
+    it->second.join();
+    extras_.erase(it);
+  }
+  finished_.clear();
+
+  if (threads_.load() - blocked_.load() >= opts_.workers || threads_.load() >= opts_.maxWorkers) return;
+  {
+    std::lock_guard<std::mutex> sleep(sleepMtx_);
+    if (shutdown_) return;
+  }
+  const std::uint64_t id = nextExtra_++;
+  ++threads_;
+  ++extraStarted_;
+  extras_.emplace(id, std::thread([this, id] { workerLoop(deques_.size(), true, id); }));
+}
+
+void WorkStealingPool::acquireWriteSlot() {
+  std::unique_lock<std::mutex> lk(slotsMtx_);
+  if (slotsUsed_ >= opts_.writeSlots) {
+    ++lanes_[1].waiting;
+    slotFreed_.wait(lk, [this] { return slotsUsed_ < opts_.writeSlots; });
+    --lanes_[1].waiting;
+  }
+  ++slotsUsed_;
+}
+
+void WorkStealingPool::releaseWriteSlot() {
+  {
+    std::lock_guard<std::mutex> lk(slotsMtx_);
+    --slotsUsed_;
+  }
+  slotFreed_.notify_one();
+}
+
+WorkStealingPool::LaneScope::LaneScope(Lane lane)
+    : pool_(tlsPool), lane_(lane), start_(std::chrono::steady_clock::now()) {
+  if (!pool_) return;
+  if (lane_ == Lane::Write) {
+    pool_->beginBlocking();
+    pool_->acquireWriteSlot();
+  }
+  ++pool_->lanes_[static_cast<int>(lane_)].inFlight;
+}
+
+WorkStealingPool::LaneScope::~LaneScope() {
+  if (!pool_) return;
+  LaneCounters& c = pool_->lanes_[static_cast<int>(lane_)];
+  const std::uint64_t us = sinceUs(start_);
+  --c.inFlight;
+  ++c.requests;
+  c.totalUs += us;
+  updateMax(c.maxUs, us);
+  if (lane_ == Lane::Write) {
+    pool_->releaseWriteSlot();
+    pool_->endBlocking();
+  }
+}
+
+// ----------------------
+// Gauges
+// ----------------------
+
+WorkStealingPool::Stats WorkStealingPool::stats() const {
+  Stats st;
+  st.workers = opts_.workers;
+  st.maxWorkers = opts_.maxWorkers;
+  st.threads = threads_;
+  st.busy = busy_;
+  st.blocked = blocked_;
+  st.queued = queued_;
+  st.completed = completed_;
+  st.steals = steals_;
+  st.rejected = rejected_;
+  st.extraStarted = extraStarted_;
+  st.queueWaitAvgMs = st.completed > 0 ? waitTotalUs_ / 1000.0 / st.completed : 0.0;
+  st.queueWaitMaxMs = waitMaxUs_ / 1000.0;
+  LaneStats* out[2] = {&st.read, &st.write};
+  for (int i = 0; i < 2; ++i) {
+    const LaneCounters& c = lanes_[i];
+    out[i]->requests = c.requests;
+    out[i]->inFlight = c.inFlight;
+    out[i]->waiting = c.waiting;
+    out[i]->avgMs = out[i]->requests > 0 ? c.totalUs / 1000.0 / out[i]->requests : 0.0;
+    out[i]->maxMs = c.maxUs / 1000.0;
+  }
+  return st;
+}
+
+}  // namespace server
@@ -1,16 +1,16 @@
 #include "../../include/utils/Logger.hpp"
 
 #include <chrono>
+#include <cstdio>
+#include <ctime>
 #include <filesystem>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 
 namespace util {
 
 std::mutex Logger::mtx_;
 std::ofstream Logger::out_;
-LogLevel Logger::level_ = LogLevel::Info;
+std::atomic<LogLevel> Logger::level_{LogLevel::Info};
 
 void Logger::init(const std::string& filePath, LogLevel level) {
   std::lock_guard<std::mutex> lk(mtx_);
@@ -34,19 +34,16 @@ void Logger::shutdown() {
   }
 }
 
-std::string Logger::timeStamp() {
+std::size_t Logger::timeStamp(char* buf, std::size_t size) {
   using namespace std::chrono;
   auto now = system_clock::now();
   auto itt = system_clock::to_time_t(now);
-  std::ostringstream ss;
-  ss << std::put_time(std::localtime(&itt), "%Y-%m-%d %H:%M:%S");
-  return ss.str();
+  return std::strftime(buf, size, "%Y-%m-%d %H:%M:%S", std::localtime(&itt));
 }
 
-void Logger::log(LogLevel level, const std::string& msg) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  if (level < level_) return;
-  std::string lvl;
+void Logger::log(LogLevel level, std::string_view msg) {
+  if (!enabled(level)) return;
+  const char* lvl = "INFO";
   switch (level) {
     case LogLevel::Debug:
       lvl = "DEBUG";
@@ -61,28 +58,35 @@ void Logger::log(LogLevel level, const std::string& msg) {
       lvl = "ERROR";
       break;
   }
-  std::ostringstream oss;
-  oss << "[" << timeStamp() << "] [" << lvl << "] " << msg << "\n";
-  const std::string outStr = oss.str();
+  std::lock_guard<std::mutex> lk(mtx_);  // also guards localtime's static buffer
+  char stamp[32];
+  stamp[timeStamp(stamp, sizeof(stamp))] = '\0';
+  char head[64];
+  const int n = std::snprintf(head, sizeof(head), "[%s] [%s] ", stamp, lvl);
+  const std::size_t headLen = n > 0 ? static_cast<std::size_t>(n) : 0;
   // write to stdout
-  std::fwrite(outStr.data(), 1, outStr.size(), stdout);
+  std::fwrite(head, 1, headLen, stdout);
+  std::fwrite(msg.data(), 1, msg.size(), stdout);
+  std::fputc('\n', stdout);
   // flush to file if open
   if (out_.is_open()) {
-    out_ << outStr;
+    out_.write(head, static_cast<std::streamsize>(headLen));
+    out_.write(msg.data(), static_cast<std::streamsize>(msg.size()));
+    out_.put('\n');
     out_.flush();
   }
 }
 
-void Logger::debug(const std::string& msg) {
+void Logger::debug(std::string_view msg) {
   log(LogLevel::Debug, msg);
 }
-void Logger::info(const std::string& msg) {
+void Logger::info(std::string_view msg) {
   log(LogLevel::Info, msg);
 }
-void Logger::warn(const std::string& msg) {
+void Logger::warn(std::string_view msg) {
   log(LogLevel::Warning, msg);
 }
-void Logger::error(const std::string& msg) {
+void Logger::error(std::string_view msg) {
   log(LogLevel::Error, msg);
 }
 
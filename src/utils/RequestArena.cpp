@@ -0,0 +1,103 @@
+#include "../../include/utils/RequestArena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+
+namespace util {
+
+namespace {
+
+constexpr std::size_t kDefaultBytes = std::size_t{64} << 10;
+constexpr std::size_t kMaxBytes = std::size_t{4} << 20;  // growth stops here; larger requests use the heap
+
+std::size_t initialBytes() {
+  static const std::size_t bytes = [] {
+    const char* v = std::getenv("REQUEST_ARENA_KB");
+    if (!v || !*v) return kDefaultBytes;
+    char* end = nullptr;
+    const unsigned long long kb = std::strtoull(v, &end, 10);
+    if (end == v) return kDefaultBytes;
+    return std::min<std::size_t>(static_cast<std::size_t>(kb) << 10, kMaxBytes);
+  }();
+  return bytes;
+}
+
+// Where the arena goes once its buffer is full: new / delete, counting what
+// it hands out so the next reset() can grow the buffer to fit.
+class OverflowResource : public std::pmr::memory_resource {
+ public:
+  std::size_t bytes = 0;
+
+ private:
+  void* do_allocate(std::size_t n, std::size_t align) override {
+    bytes += n;
+    return std::pmr::new_delete_resource()->allocate(n, align);
+  }
+  void do_deallocate(void* p, std::size_t n, std::size_t align) override {
+    std::pmr::new_delete_resource()->deallocate(p, n, align);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+class Arena {
+ public:
+  explicit Arena(std::size_t bytes) { allocateBuffer(bytes); }
+
+  std::pmr::memory_resource* resource() { return &*mono_; }
+
+  void reset() {
+    const std::size_t over = overflow_.bytes;
+    if (over > 0 && size_ < kMaxBytes) {
+      std::size_t grown = size_;
+      while (grown < size_ + over && grown < kMaxBytes) grown *= 2;
+      allocateBuffer(std::min(grown, kMaxBytes));
+    } else {
+      mono_->release();  // back to the start of the buffer
+    }
+    overflow_.bytes = 0;
+  }
+
+  RequestArena::Stats stats() const { return {size_, overflow_.bytes}; }
+
+ private:
+  OverflowResource overflow_;
+  std::unique_ptr<char[]> buf_;
+  std::size_t size_ = 0;
+  std::optional<std::pmr::monotonic_buffer_resource> mono_;  // last: goes before the buffer it points into
+
+  void allocateBuffer(std::size_t bytes) {
+    mono_.reset();
+    buf_ = std::make_unique<char[]>(bytes);
+    size_ = bytes;
+    mono_.emplace(buf_.get(), size_, &overflow_);
+  }
+};
+
+Arena& threadArena() {
+  thread_local Arena arena(initialBytes());
+  return arena;
+}
+
+}  // namespace
+
+bool RequestArena::enabled() {
+  return initialBytes() > 0;
+}
+
+std::pmr::memory_resource* RequestArena::resource() {
+  if (!enabled()) return std::pmr::new_delete_resource();
+  return threadArena().resource();
+}
+
+void RequestArena::reset() {
+  if (enabled()) threadArena().reset();
+}
+
+RequestArena::Stats RequestArena::stats() {
+  if (!enabled()) return {};
+  return threadArena().stats();
+}
+
+}  // namespace util
@@ -0,0 +1,262 @@
+// Concurrent stress test for HealthBackend behind the real HTTP routes.
+//
+//   concurrency_stress [clientThreads=8] [iterations=100]
+//
+// Starts the server in-process on a free port, with the server's worker pool
+// and request lanes, then every client thread drives all route families at
+// once: its own user (records of every kind, categories, profile / BMI,
+// re-logins) plus one user shared by all threads, which is where
+// unsynchronised code used to race. Small checkpoints keep
+// forked background snapshots running alongside. Afterwards the record
+// counts must add up exactly, over HTTP and again after a restart from disk.
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../third_party/httplib.h"
+#include "../third_party/json.hpp"
+#include "core/HealthBackend.hpp"
+#include "routes/Routes.hpp"
+#include "server/ServerSetup.hpp"
+#include "server/WorkerPool.hpp"
+#include "utils/Logger.hpp"
+
+using json = nlohmann::json;
+
+static std::atomic<int> failures{0};
+static std::mutex printMtx;
+
+static void fail(const std::string& what) {
+  if (++failures <= 20) {
+    std::lock_guard<std::mutex> lk(printMtx);
+    std::printf("  FAIL %s\n", what.c_str());
+  }
+}
+
+// A client with a bearer token. One connection per request: kept-alive
+// connections would each pin one of httplib's pool threads, and two per
+// client thread outnumber the pool.
+class Client {
+ public:
+  explicit Client(int port) : http_("127.0.0.1", port) { http_.set_tcp_nodelay(true); }
+
+  void setToken(const std::string& token) { headers_ = {{"Authorization", "Bearer " + token}}; }
+
+  // Returns the body; records a failure unless the status is `expect`.
+  std::string call(const char* method, const std::string& path, const json& body, int expect) {
+    httplib::Result res;
+    const std::string text = body.is_null() ? "" : body.dump();
+    const std::string m = method;
+    if (m == "GET") res = http_.Get(path, headers_);
+    if (m == "POST") res = http_.Post(path, headers_, text, "application/json");
+    if (m == "PATCH") res = http_.Patch(path, headers_, text, "application/json");
+    if (m == "DELETE") {
+      // httplib's server reads a DELETE body until its read timeout unless the
+      // request says there is none, and its client only does so for POST/PUT/PATCH.
+      httplib::Headers headers = headers_;
+      headers.emplace("Content-Length", "0");
+      res = http_.Delete(path, headers);
+    }
+    ++requests_;
+    if (!res) {
+      fail(m + " " + path + ": no response");
+      return "";
+    }
+    if (res->status != expect) {
+      fail(m + " " + path + ": status " + std::to_string(res->status) + " " + res->body);
+    }
+    return res->body;
+  }
+
+  std::string login(const std::string& name, const std::string& password) {
+    json in = {{"name", name}, {"password", password}};
+    std::string token = json::parse(call("POST", "/login", in, 200), nullptr, false).value("token", "");
+    setToken(token);
+    return token;
+  }
+
+  std::size_t listSize(const std::string& path) {
+    json arr = json::parse(call("GET", path, nullptr, 200), nullptr, false);
+    if (!arr.is_array()) {
+      fail("GET " + path + ": not an array");
+      return 0;
+    }
+    return arr.size();
+  }
+
+  // Pages through `path` (which sets a limit) by following X-Next-Cursor.
+  // The ids must come strictly in order: a cursor never repeats or skips
+  // back, however the list changes between pages. Returns how many it saw.
+  std::size_t pagedSize(const std::string& path) {
+    std::size_t seen = 0;
+    std::uint64_t lastId = 0;
+    std::string cursor;
+    do {
+      const std::string url = cursor.empty() ? path : path + "&cursor=" + cursor;
+      auto res = http_.Get(url, headers_);
+      ++requests_;
+      if (!res || res->status != 200) {
+        fail("GET " + url + ": " + (res ? std::to_string(res->status) : std::string("no response")));
+        return seen;
+      }
+      json arr = json::parse(res->body, nullptr, false);
+      for (const auto& r : arr) {
+        const std::uint64_t id = std::stoull(r.value("id", "0"));
+        if (id <= lastId) fail("GET " + url + ": id " + std::to_string(id) + " after " + std::to_string(lastId));
+        lastId = id;
+        ++seen;
+      }
+      cursor = res->get_header_value("X-Next-Cursor");
+    } while (!cursor.empty());
+    return seen;
+  }
+
+  std::size_t requests() const { return requests_; }
+
+ private:
+  httplib::Client http_;
+  httplib::Headers headers_;
+  std::size_t requests_ = 0;
+};
+
+static json registration(const std::string& name) {
+  return {{"name", name}, {"password", "pw"}, {"age", 30}, {"weightKg", 70.0}, {"heightM", 1.75},
+          {"gender", "other"}};
+}
+
+static void runClient(int port, int t, int iterations) {
+  const std::string me = "stress" + std::to_string(t);
+  Client own(port), shared(port);
+  own.call("POST", "/register", registration(me), 201);
+  own.login(me, "pw");
+  shared.login("shared", "pw");
+  own.call("POST", "/category/create", {{"categoryName", "Mood"}}, 201);
+
+  // Records are addressed by the ids the POSTs hand back.
+  auto idOf = [](const std::string& body) { return json::parse(body, nullptr, false).value("id", ""); };
+  std::deque<std::string> ownWaters;
+  std::string firstActivity;
+
+  const json water = {{"datetime", "2024-01-01T08:00:00.000Z"}, {"amountMl", 250}};
+  for (int i = 0; i < iterations; ++i) {
+    ownWaters.push_back(idOf(own.call("POST", "/waters", water, 201)));
+    shared.call("POST", "/waters", water, 201);
+    shared.listSize("/waters");
+    own.call("POST", "/sleeps", {{"datetime", "2024-01-01T23:00:00.000Z"}, {"hours", 7.5}}, 201);
+    own.listSize("/sleeps");
+    const std::string act = idOf(own.call(
+        "POST", "/activities", {{"datetime", "2024-01-01T07:00:00.000Z"}, {"minutes", 30}, {"intensity", "low"}}, 201));
+    if (firstActivity.empty()) firstActivity = act;
+    own.call("PATCH", "/activities/" + firstActivity, {{"minutes", 45}}, 200);
+    own.call("POST", "/category/Mood/add", {{"datetime", "2024-01-01T09:00:00.000Z"}, {"note", "ok"}}, 201);
+    own.listSize("/category/Mood/list");
+    json profile = json::parse(own.call("GET", "/user/profile", nullptr, 200), nullptr, false);
+    if (profile.value("name", "") != me) fail("profile of " + me + " came back as " + profile.dump());
+    own.call("GET", "/user/bmi", nullptr, 200);
+
+    if (i % 10 == 9) {
+      own.login(me, "pw");  // token directory writes under load
+      own.call("DELETE", "/waters/" + ownWaters.front(), nullptr, 204);
+      ownWaters.pop_front();
+      own.listSize("/category/list");
+      // Every shared water has the same datetime, so pages run in id order
+      // while the other clients keep adding.
+      const std::size_t before = shared.listSize("/waters");
+      if (shared.pagedSize("/waters?limit=64") < before) fail("paging /waters lost records");
+      own.call("GET", "/admin/stats", nullptr, 200);
+    }
+  }
+  std::lock_guard<std::mutex> lk(printMtx);
+  std::printf("  client %d: %zu requests\n", t, own.requests() + shared.requests());
+}
+
+// Expected counts, checked over HTTP and against a restarted backend.
+struct Expect {
+  int threads, iterations;
+  std::size_t ownWaters() const { return iterations - iterations / 10; }
+  std::size_t sharedWaters() const { return static_cast<std::size_t>(threads) * iterations; }
+};
+
+static void checkCounts(HealthBackend& backend, const Expect& e, const char* when) {
+  const int before = failures;
+  std::string token = backend.login("shared", "pw");
+  if (backend.getAllWater(token).size() != e.sharedWaters()) {
+    fail(std::string(when) + ": shared user has " + std::to_string(backend.getAllWater(token).size()) +
+         " waters, expected " + std::to_string(e.sharedWaters()));
+  }
+  for (int t = 0; t < e.threads; ++t) {
+    const std::string me = "stress" + std::to_string(t);
+    token = backend.login(me, "pw");
+    const std::size_t waters = backend.getAllWater(token).size();
+    const std::size_t sleeps = backend.getAllSleep(token).size();
+    const std::size_t acts = backend.getAllActivity(token).size();
+    const std::size_t mood = backend.getOtherRecords(token, "Mood").size();
+    if (waters != e.ownWaters() || sleeps != static_cast<std::size_t>(e.iterations) ||
+        acts != static_cast<std::size_t>(e.iterations) || mood != static_cast<std::size_t>(e.iterations)) {
+      fail(std::string(when) + ": " + me + " has " + std::to_string(waters) + "/" + std::to_string(sleeps) + "/" +
+           std::to_string(acts) + "/" + std::to_string(mood) + " waters/sleeps/activities/mood");
+    }
+  }
+  std::printf("%s: counts %s\n", when, failures == before ? "ok" : "WRONG");
+}
+
+int main(int argc, char** argv) {
+  const int threads = argc > 1 ? std::max(1, std::atoi(argv[1])) : 8;
+  const int iterations = argc > 2 ? std::max(10, std::atoi(argv[2])) : 100;
+  const Expect expect{threads, iterations};
+
+  const std::string dir =
+      (std::filesystem::temp_directory_path() / ("health_stress." + std::to_string(::getpid()))).string();
+  std::filesystem::create_directories(dir);
+  ::setenv("STORAGE_PATH", (dir + "/storage.json").c_str(), 1);
+  ::setenv("STORAGE_CHECKPOINT_BYTES", "65536", 1);  // background snapshots while we run
+  util::Logger::init(dir + "/stress.log", util::LogLevel::Error);
+
+  {
+    auto backend = std::make_unique<HealthBackend>();
+    backend->registerUser("shared", 30, 70.0, 1.75, "pw", "other");
+
+    httplib::Server svr;
+    svr.set_tcp_nodelay(true);
+    server::setupServerCommon(svr);  // the server's worker pool and request lanes
+    registerRoutes(svr, *backend);
+    const int port = svr.bind_to_any_port("127.0.0.1");
+    std::thread server([&] { svr.listen_after_bind(); });
+    svr.wait_until_ready();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int t = 0; t < threads; ++t) clients.emplace_back(runClient, port, t, iterations);
+    for (auto& c : clients) c.join();
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const server::WorkStealingPool::Stats pool = server::WorkStealingPool::active()->stats();
+    svr.stop();
+    server.join();
+    std::printf("%d clients x %d iterations in %.2f s; pool: %llu connections, %llu steals, %llu extra threads\n",
+                threads, iterations, secs, static_cast<unsigned long long>(pool.completed),
+                static_cast<unsigned long long>(pool.steals), static_cast<unsigned long long>(pool.extraStarted));
+    if (pool.read.requests == 0 || pool.write.requests == 0) fail("requests did not go through the pool's lanes");
+    checkCounts(*backend, expect, "live");
+  }
+  {
+    // Snapshot + journal written by the run above.
+    HealthBackend restarted;
+    checkCounts(restarted, expect, "after restart");
+  }
+
+  util::Logger::shutdown();
+  std::filesystem::remove_all(dir);
+  std::printf("%d failure(s)\n", failures.load());
+  return failures == 0 ? 0 : 1;
+}
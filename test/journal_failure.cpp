@@ -0,0 +1,178 @@
+// Journal behaviour when a group commit cannot be written.
+//
+//   journal_failure
+//
+// A file-size limit (RLIMIT_FSIZE, with SIGXFSZ ignored) makes the journal's
+// write() come up short and then fail with EFBIG partway through a batch.
+// Sync writers of that batch must get 0 back, durableSeq must not move, the
+// partial line must be cut back out, and every entry written before and after
+// the failure must survive a replay. Through HealthBackend, a mutation whose
+// sync append fails must not be applied at all. Sealing again after a failed
+// snapshot (the sealed file still there) must keep every entry, even with
+// nothing new in the live file. Runs under ctest.
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "core/HealthBackend.hpp"
+#include "core/Journal.hpp"
+#include "utils/Logger.hpp"
+
+using nlohmann::json;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+  do {                                                                      \
+    if (!(cond)) {                                                          \
+      std::printf("    FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+      ++failures;                                                           \
+    }                                                                       \
+  } while (0)
+
+static bool setFileLimit(rlim_t bytes) {
+  rlimit lim{};
+  if (::getrlimit(RLIMIT_FSIZE, &lim) != 0) return false;
+  lim.rlim_cur = std::min(bytes, lim.rlim_max);
+  return ::setrlimit(RLIMIT_FSIZE, &lim) == 0;
+}
+
+static json entry(int n) {
+  return json{{"op", "add"}, {"n", n}, {"pad", std::string(100, 'x')}};
+}
+
+// Every line in the file must be a complete entry.
+static bool onlyWholeLines(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (!text.empty() && text.back() != '\n') return false;
+  std::size_t start = 0;
+  while (start < text.size()) {
+    const std::size_t end = text.find('\n', start);
+    if (json::parse(text.substr(start, end - start), nullptr, false).is_discarded()) return false;
+    start = end + 1;
+  }
+  return true;
+}
+
+int main() {
+  const std::string dir =
+      (std::filesystem::temp_directory_path() / ("health_journal." + std::to_string(::getpid()))).string();
+  std::filesystem::create_directories(dir);
+  util::Logger::init(dir + "/journal.log", util::LogLevel::Error);
+  const std::string path = dir + "/storage.journal";
+
+  rlimit original{};
+  ::getrlimit(RLIMIT_FSIZE, &original);
+  std::signal(SIGXFSZ, SIG_IGN);
+
+  std::vector<int> kept;  // entries whose append() reported success
+  {
+    Journal journal(path, Journal::Durability::Sync);
+    journal.replay(0, [](const json&) {});
+
+    for (int n = 0; n < 5; ++n) {
+      CHECK(journal.append(entry(n)) != 0);
+      kept.push_back(n);
+    }
+    const std::uintmax_t before = std::filesystem::file_size(path);
+
+    // Room for about half an entry: the next write is torn, then refused.
+    CHECK(setFileLimit(before + 60));
+    CHECK(journal.append(entry(5)) == 0);
+    CHECK(journal.append(entry(6)) == 0);
+    const Journal::Stats failed = journal.stats();
+    CHECK(failed.failedBatches == 2);
+    CHECK(failed.durableSeq == 5);
+    CHECK(std::filesystem::file_size(path) == before);
+    CHECK(onlyWholeLines(path));
+
+    ::setrlimit(RLIMIT_FSIZE, &original);
+    for (int n = 7; n < 10; ++n) {
+      CHECK(journal.append(entry(n)) != 0);
+      kept.push_back(n);
+    }
+    CHECK(journal.stats().durableSeq == journal.lastSeq());
+    CHECK(onlyWholeLines(path));
+  }
+  {
+    // Nothing behind the failed batches is lost on the next start.
+    Journal journal(path, Journal::Durability::Sync);
+    std::vector<int> replayed;
+    journal.replay(0, [&](const json& e) { replayed.push_back(e.value("n", -1)); });
+    CHECK(replayed == kept);
+  }
+
+  {
+    // Sealed twice without dropSealed in between, as after a failed snapshot.
+    const std::string sealedPath = dir + "/sealed.journal";
+    std::vector<int> written;
+    {
+      Journal journal(sealedPath, Journal::Durability::Sync);
+      journal.replay(0, [](const json&) {});
+      for (int n = 0; n < 3; ++n) {
+        CHECK(journal.append(entry(n)) != 0);
+        written.push_back(n);
+      }
+      CHECK(journal.seal());
+      CHECK(journal.seal());  // nothing live: still fine
+      CHECK(journal.seal());
+      for (int n = 3; n < 5; ++n) {
+        CHECK(journal.append(entry(n)) != 0);
+        written.push_back(n);
+      }
+      CHECK(journal.seal());
+      CHECK(!std::filesystem::exists(sealedPath));
+      CHECK(onlyWholeLines(sealedPath + ".1"));
+    }
+    Journal journal(sealedPath, Journal::Durability::Sync);
+    std::vector<int> replayed;
+    journal.replay(0, [&](const json& e) { replayed.push_back(e.value("n", -1)); });
+    CHECK(replayed == written);
+  }
+
+  {
+    // A failed append reports "not applied" and leaves nothing behind.
+    ::setenv("STORAGE_PATH", (dir + "/storage.json").c_str(), 1);
+    ::setenv("STORAGE_DURABILITY", "sync", 1);
+    const std::string wal = dir + "/storage.json.wal";
+    {
+      HealthBackend backend;
+      CHECK(backend.registerUser("ann", 30, 60.0, 1.70, "pw", "female"));
+      const std::string token = backend.login("ann", "pw");
+      CHECK(backend.addWater(token, "2024-01-01T08:00", 250.0) != 0);
+
+      CHECK(setFileLimit(std::filesystem::file_size(wal) + 20));
+      CHECK(backend.addWater(token, "2024-01-01T09:00", 300.0) == 0);
+      CHECK(backend.getAllWater(token).size() == 1);
+      CHECK(!backend.registerUser("bob", 40, 80.0, 1.80, "pw", "male"));
+      CHECK(backend.login("bob", "pw") == "INVALID");
+      ::setrlimit(RLIMIT_FSIZE, &original);
+
+      CHECK(backend.registerUser("bob", 40, 80.0, 1.80, "pw", "male"));
+      CHECK(backend.addWater(token, "2024-01-01T09:00", 300.0) != 0);
+      CHECK(backend.getAllWater(token).size() == 2);
+    }
+    HealthBackend backend;
+    CHECK(backend.getAllWater(backend.login("ann", "pw")).size() == 2);
+    CHECK(backend.login("bob", "pw") != "INVALID");
+  }
+
+  std::filesystem::remove_all(dir);
+  if (failures > 0) {
+    std::printf("journal_failure: %d failed checks\n", failures);
+    return 1;
+  }
+  std::printf("journal_failure: ok\n");
+  return 0;
+}
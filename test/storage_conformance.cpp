@@ -0,0 +1,321 @@
+// Conformance suite for StorageEngine implementations.
+//
+//   storage_conformance [engine...]   (default: every engine in storageEngineNames())
+//
+// Every engine has to give the same answers for the same record-level writes,
+// before and after a reopen, with and without a checkpoint in between. Runs
+// under ctest; exits non-zero on the first engine with a failed check.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/SnapshotJson.hpp"
+#include "core/StorageEngine.hpp"
+
+using nlohmann::json;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+  do {                                                                      \
+    if (!(cond)) {                                                          \
+      std::printf("    FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+      ++failures;                                                           \
+    }                                                                       \
+  } while (0)
+
+// ----------------------
+// Helpers
+// ----------------------
+
+static UserData makeUser(const std::string& name) {
+  UserData u;
+  u.profile.id = name;
+  u.profile.name = name;
+  u.profile.age = 30;
+  u.profile.weightKg = 70.5;
+  u.profile.heightM = 1.75;
+  u.profile.gender = "female";
+  u.password = "pw-" + name;
+  return u;
+}
+
+static json water(const std::string& dt, double ml) {
+  return toJson(WaterRecord{dt, ml});
+}
+
+// Records and profile; the persistence bookkeeping is engine-private.
+static bool sameUser(const UserData& a, const UserData& b) {
+  const auto& p = a.profile;
+  const auto& q = b.profile;
+  if (p.id != q.id || p.name != q.name || p.age != q.age || p.weightKg != q.weightKg || p.heightM != q.heightM ||
+      p.gender != q.gender || a.password != b.password) {
+    return false;
+  }
+  // Ids included: toJson writes them.
+  auto sameList = [](const auto& x, const auto& y) {
+    if (x.size() != y.size()) return false;
+    auto same = [](const auto& r, const auto& q) { return toJson(r) == toJson(q); };
+    return std::equal(x.begin(), x.end(), y.begin(), same);
+  };
+  if (!sameList(a.waters, b.waters) || !sameList(a.sleeps, b.sleeps) || !sameList(a.activities, b.activities)) {
+    return false;
+  }
+  if (a.categories.size() != b.categories.size()) return false;
+  for (const auto& [name, items] : a.categories) {
+    auto it = b.categories.find(name);
+    if (it == b.categories.end() || !sameList(items, it->second)) return false;
+  }
+  return true;
+}
+
+static UserMap dump(const StorageEngine& engine) {
+  UserMap out;
+  engine.forEachUser([&](const UserData& u) { out.emplace(u.profile.name, u); });
+  return out;
+}
+
+static bool sameUsers(const UserMap& a, const UserMap& b) {
+  if (a.size() != b.size()) return false;
+  for (const auto& [name, u] : a) {
+    auto it = b.find(name);
+    if (it == b.end() || !sameUser(u, it->second)) return false;
+  }
+  return true;
+}
+
+static std::unique_ptr<StorageEngine> reopen(const std::string& name, const std::string& dir) {
+  auto engine = makeStorageEngine(name, dir);
+  CHECK(engine && engine->open());
+  return engine;
+}
+
+// ----------------------
+// Cases
+// ----------------------
+
+static void testUsers(const std::string& name, const std::string& dir) {
+  auto e = reopen(name, dir);
+  CHECK(dump(*e).empty());
+
+  CHECK(e->createUser(makeUser("alice")));
+  CHECK(e->createUser(makeUser("bob")));
+  CHECK(!e->createUser(makeUser("alice")));  // taken
+  CHECK(!e->createUser(makeUser("")));
+
+  UserData out;
+  CHECK(e->loadUser("alice", out));
+  CHECK(sameUser(out, makeUser("alice")));
+  CHECK(!e->loadUser("carol", out));
+
+  // Iteration is in name order.
+  std::vector<std::string> names;
+  e->forEachUser([&](const UserData& u) { names.push_back(u.profile.name); });
+  CHECK((names == std::vector<std::string>{"alice", "bob"}));
+  CHECK(e->stats().users == 2);
+}
+
+static void testRecords(const std::string& name, const std::string& dir) {
+  auto e = reopen(name, dir);
+  CHECK(e->createUser(makeUser("alice")));
+
+  CHECK(e->putRecord("alice", {"waters"}, water("2024-01-01T08:00:00.000Z", 250)));
+  CHECK(e->putRecord("alice", {"waters"}, water("2024-01-01T12:00:00.000Z", 300)));
+  CHECK(e->putRecord("alice", {"waters"}, water("2024-01-01T18:00:00.000Z", 350)));
+  CHECK(e->putRecord("alice", {"sleeps"}, toJson(SleepRecord{"2024-01-01T23:00:00.000Z", 7.5})));
+  CHECK(e->putRecord("alice", {"activities"}, toJson(ActivityRecord{"2024-01-01T07:00:00.000Z", 30, "low"})));
+
+  // Ids are handed out per user in write order: waters 1-3, sleep 4,
+  // activity 5. Replace by id, then delete the first: nothing renumbers.
+  CHECK(e->putRecord("alice", {"waters", 2}, water("2024-01-01T13:00:00.000Z", 400)));
+  CHECK(e->deleteRecord("alice", {"waters", 1}));
+
+  UserData u;
+  CHECK(e->loadUser("alice", u));
+  CHECK(u.waters.size() == 2 && !u.waters.find(1));
+  CHECK(u.waters.find(2) && u.waters.find(2)->amountMl == 400);
+  CHECK(u.waters.find(2) && u.waters.find(2)->timeMs == 1704114000000);  // 2024-01-01T13:00:00Z
+  CHECK(u.waters.find(3) && u.waters.find(3)->amountMl == 350);
+  CHECK(u.waters.begin()->id == 2);  // order is still write order
+  CHECK(u.sleeps.size() == 1 && u.sleeps.find(4) && u.sleeps.find(4)->hours == 7.5);
+  CHECK(u.activities.size() == 1 && u.activities.find(5) && u.activities.find(5)->intensity == "low");
+
+  // Everything that does not address an existing record is refused.
+  CHECK(!e->putRecord("nobody", {"waters"}, water("2024-01-01T08:00:00.000Z", 250)));
+  CHECK(!e->putRecord("alice", {"waters", 7}, water("2024-01-01T08:00:00.000Z", 250)));
+  CHECK(!e->putRecord("alice", {"waters", 4}, water("2024-01-01T08:00:00.000Z", 250)));  // a sleep's id
+  CHECK(!e->putRecord("alice", {"steps"}, water("2024-01-01T08:00:00.000Z", 250)));
+  CHECK(!e->putRecord("alice", {"waters"}, json("not an object")));
+  CHECK(!e->deleteRecord("alice", {"sleeps", 1}));  // deleted, and was a water
+  CHECK(!e->deleteRecord("alice", {"sleeps"}));     // no id
+
+  UserData after;
+  CHECK(e->loadUser("alice", after));
+  CHECK(sameUser(u, after));
+
+  // Ids survive a reopen, and a deleted id is never handed out again.
+  e.reset();
+  e = reopen(name, dir);
+  CHECK(e->putRecord("alice", {"waters"}, water("2024-01-02T08:00:00.000Z", 500)));
+  CHECK(e->loadUser("alice", after));
+  CHECK(after.waters.find(3) && after.waters.find(3)->amountMl == 350);
+  CHECK(after.waters.find(3) && after.waters.find(3)->timeMs == 1704132000000);  // parsed again on load
+  CHECK(after.waters.find(6) && after.waters.find(6)->amountMl == 500 && !after.waters.find(1));
+}
+
+static void testCategories(const std::string& name, const std::string& dir) {
+  auto e = reopen(name, dir);
+  CHECK(e->createUser(makeUser("alice")));
+
+  CHECK(e->createCategory("alice", "Mood"));
+  CHECK(!e->createCategory("alice", "Mood"));
+  CHECK(!e->createCategory("alice", ""));
+  CHECK(e->createCategory("alice", "Steps"));
+
+  const json item = toJson(CategoryItem{"2024-01-01T08:00:00.000Z", "Good day", 4});
+  CHECK(e->putRecord("alice", {"categories", StorageEngine::kAppend, "Mood"}, item));
+  CHECK(e->putRecord("alice", {"categories", StorageEngine::kAppend, "Mood"}, item));
+  CHECK(e->putRecord("alice", {"categories", 1, "Mood"}, toJson(CategoryItem{"2024-01-02T08:00:00.000Z", "Tired", 2})));
+  CHECK(e->deleteRecord("alice", {"categories", 2, "Mood"}));
+  CHECK(!e->putRecord("alice", {"categories", StorageEngine::kAppend, "Sleepiness"}, item));
+
+  CHECK(e->dropCategory("alice", "Steps"));
+  CHECK(!e->dropCategory("alice", "Steps"));
+
+  UserData u;
+  CHECK(e->loadUser("alice", u));
+  CHECK(u.categories.size() == 1);
+  CHECK(u.categories.count("Mood") && u.categories["Mood"].size() == 1 && u.categories["Mood"].find(1) &&
+        u.categories["Mood"].find(1)->note == "Tired");
+}
+
+// Writes survive a reopen through the journal alone, through a checkpoint,
+// and through a checkpoint followed by more journal.
+static void testReopen(const std::string& name, const std::string& dir) {
+  UserMap expected;
+  {
+    auto e = reopen(name, dir);
+    for (int i = 0; i < 20; ++i) {
+      const std::string user = "user" + std::to_string(i);
+      CHECK(e->createUser(makeUser(user)));
+      for (int r = 0; r < 5; ++r) CHECK(e->putRecord(user, {"waters"}, water("2024-01-01T08:00:00.000Z", 100 + r)));
+    }
+    CHECK(e->createCategory("user3", "Mood"));
+    CHECK(e->deleteRecord("user4", {"waters", 2}));
+    expected = dump(*e);
+  }
+  {
+    auto e = reopen(name, dir);
+    CHECK(sameUsers(dump(*e), expected));
+
+    CHECK(e->checkpoint());
+    CHECK(e->stats().checkpoints == 1);
+    CHECK(e->stats().journalBytes == 0);
+
+    // Only some users change after the checkpoint (sharded engines rewrite
+    // just those).
+    CHECK(e->putRecord("user7", {"sleeps"}, toJson(SleepRecord{"2024-01-02T23:00:00.000Z", 6})));
+    CHECK(e->dropCategory("user3", "Mood"));
+    CHECK(e->createUser(makeUser("zoe")));
+    CHECK(e->stats().journalBytes > 0);
+    expected = dump(*e);
+  }
+  {
+    auto e = reopen(name, dir);
+    CHECK(sameUsers(dump(*e), expected));
+    CHECK(e->checkpoint());
+  }
+  {
+    auto e = reopen(name, dir);
+    CHECK(sameUsers(dump(*e), expected));
+  }
+}
+
+static void testConcurrentWriters(const std::string& name, const std::string& dir) {
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 200;
+  {
+    auto e = reopen(name, dir);
+    for (int t = 0; t < kThreads; ++t) CHECK(e->createUser(makeUser("w" + std::to_string(t))));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        const std::string user = "w" + std::to_string(t);
+        for (int i = 0; i < kPerThread; ++i) {
+          e->putRecord(user, {"waters"}, water("2024-01-01T08:00:00.000Z", i + 1));
+          // A reader alongside the writers.
+          UserData u;
+          e->loadUser("w0", u);
+        }
+      });
+    }
+    for (auto& th : threads) th.join();
+    CHECK(e->stats().writes == kThreads + kThreads * kPerThread);
+  }
+  auto e = reopen(name, dir);
+  for (int t = 0; t < kThreads; ++t) {
+    UserData u;
+    CHECK(e->loadUser("w" + std::to_string(t), u));
+    CHECK(u.waters.size() == static_cast<std::size_t>(kPerThread));
+    // Per-user order is the order of the writes.
+    CHECK(!u.waters.empty() && u.waters.begin()->amountMl == 1 && u.waters.find(kPerThread) &&
+          u.waters.find(kPerThread)->amountMl == kPerThread);
+  }
+}
+
+// ----------------------
+// Driver
+// ----------------------
+
+int main(int argc, char** argv) {
+  std::vector<std::string> engines(argv + 1, argv + argc);
+  if (engines.empty()) engines = storageEngineNames();
+
+  const std::string root =
+      (std::filesystem::temp_directory_path() / ("health_conformance." + std::to_string(::getpid()))).string();
+
+  struct Case {
+    const char* name;
+    void (*run)(const std::string&, const std::string&);
+  };
+  const Case cases[] = {
+      {"users", testUsers},
+      {"records", testRecords},
+      {"categories", testCategories},
+      {"reopen", testReopen},
+      {"concurrent writers", testConcurrentWriters},
+  };
+
+  int failedEngines = 0;
+  for (const std::string& engine : engines) {
+    const auto known = storageEngineNames();
+    if (std::find(known.begin(), known.end(), engine) == known.end()) {
+      std::printf("unknown engine: %s\n", engine.c_str());
+      ++failedEngines;
+      continue;
+    }
+    std::printf("[%s]\n", engine.c_str());
+    const int before = failures;
+    for (const Case& c : cases) {
+      // A fresh directory per case; engines must not depend on leftovers.
+      const std::string dir = root + "/" + engine;
+      std::filesystem::remove_all(dir);
+      std::filesystem::create_directories(dir);
+      const int f = failures;
+      c.run(engine, dir);
+      std::printf("  %-20s %s\n", c.name, failures == f ? "ok" : "FAIL");
+    }
+    if (failures != before) ++failedEngines;
+  }
+  std::filesystem::remove_all(root);
+
+  std::printf("%d engine(s) failed\n", failedEngines);
+  return failedEngines == 0 ? 0 : 1;
+}
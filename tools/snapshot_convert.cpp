@@ -0,0 +1,40 @@
+// Convert a snapshot between the JSON, compressed JSON (.gz) and binary
+// (.hbs) formats.
+//
+//   snapshot_convert data/storage.json data/storage.hbs
+//   snapshot_convert data/storage.hbs  data/storage.json
+//   snapshot_convert data/storage.json data/storage.json.gz
+//
+// The format of each side is picked from its extension, exactly like the
+// server does for STORAGE_PATH. The journalSeq is carried over, so a
+// converted snapshot can be dropped in next to the existing journal.
+
+#include <iostream>
+
+#include "core/Storage.hpp"
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <input.json|input.hbs> <output.json|output.hbs>" << std::endl;
+    return 2;
+  }
+
+  Storage in(argv[1]);
+  Storage out(argv[2]);
+
+  UserMap users;
+  std::uint64_t journalSeq = 0;
+  if (!in.loadSnapshot(users, journalSeq)) {
+    std::cerr << "failed to read " << in.path() << " as " << Storage::formatName(in.format()) << std::endl;
+    return 1;
+  }
+  if (!out.saveSnapshot(users, journalSeq)) {
+    std::cerr << "failed to write " << out.path() << std::endl;
+    return 1;
+  }
+
+  std::cout << in.path() << " (" << Storage::formatName(in.format()) << ") -> " << out.path() << " ("
+            << Storage::formatName(out.format()) << "): " << users.size() << " users, journalSeq " << journalSeq
+            << std::endl;
+  return 0;
+}